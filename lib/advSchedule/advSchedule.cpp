@@ -0,0 +1,70 @@
+/*
+ * *************************************************************
+ * advSchedule.cpp - implementation file for adaptive BLE advertising schedule
+ *
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include "advSchedule.h"
+
+// AdvertisingSchedule constructor; directed_msec 0 skips the directed phase
+AdvertisingSchedule::AdvertisingSchedule(uint32_t directed_msec,
+                                         uint32_t fast_msec) : _directed_msec(directed_msec),
+                                                               _fast_msec(fast_msec),
+                                                               _hostKnown(false),
+                                                               _connected(false),
+                                                               _started(false),
+                                                               _phase(ADV_PHASE_NONE),
+                                                               _phaseStart_msec(0) {
+}
+
+/*****************************************************************************
+Description : Decides whether the advertising phase should change.
+                Boot or disconnect -> DIRECTED (bonded host known) or FAST
+                DIRECTED for directed_msec -> FAST
+                FAST for fast_msec -> SLOW
+                Connected -> nothing (stack stops advertising itself)
+
+Input Value : now_msec, connected - current BLE connection state
+Return Value: phase to apply now, or ADV_PHASE_NONE for no change
+********************************************************************************/
+advPhase_t AdvertisingSchedule::update(unsigned long now_msec, bool connected) {
+    if (connected) {
+        _connected = true;
+        _started = true;
+        _phase = ADV_PHASE_NONE;
+        return ADV_PHASE_NONE;
+    }
+
+    advPhase_t wanted = _phase;
+    if (_connected || !_started) {  // just disconnected, or first call after boot
+        _connected = false;
+        _started = true;
+        wanted = (_hostKnown && (_directed_msec > 0)) ? ADV_PHASE_DIRECTED : ADV_PHASE_FAST;
+    } else if ((_phase == ADV_PHASE_DIRECTED) && ((now_msec - _phaseStart_msec) >= _directed_msec)) {
+        wanted = ADV_PHASE_FAST;
+    } else if ((_phase == ADV_PHASE_FAST) && ((now_msec - _phaseStart_msec) >= _fast_msec)) {
+        wanted = ADV_PHASE_SLOW;
+    }
+
+    if (wanted == _phase) {
+        return ADV_PHASE_NONE;
+    }
+    _phase = wanted;
+    _phaseStart_msec = now_msec;
+    return wanted;
+}
+
+const advParams_t& AdvertisingSchedule::params(advPhase_t phase) {
+    switch (phase) {
+        case ADV_PHASE_DIRECTED:
+            return ADV_PARAMS_DIRECTED;
+        case ADV_PHASE_SLOW:
+            return ADV_PARAMS_SLOW;
+        default:
+            return ADV_PARAMS_FAST;
+    }
+}
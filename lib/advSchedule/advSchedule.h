@@ -0,0 +1,66 @@
+/*
+ * *************************************************************
+ * advSchedule.h - Header file for adaptive BLE advertising schedule
+ *
+ *   While disconnected flipTurn steps through advertising phases:
+ *     DIRECTED  high duty cycle directed advertising to the last bonded
+ *               central (only if one is cached); 1.28 s is the BLE limit
+ *     FAST      20 ms undirected, so any central (or an iPad using a
+ *               private address) reconnects quickly
+ *     SLOW      ~1 s undirected until someone connects (low power)
+ *   Pure policy - the caller applies each phase through the HAL, so it also
+ *   runs on a host.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef ADV_SCHEDULE_H  // begin header guard
+#define ADV_SCHEDULE_H
+
+#include <stdint.h>
+
+enum advPhase_t { ADV_PHASE_NONE,  // connected / no change requested
+                  ADV_PHASE_DIRECTED,
+                  ADV_PHASE_FAST,
+                  ADV_PHASE_SLOW };
+
+// BLE units: advertising interval x 0.625 ms
+struct advParams_t {
+    bool directed;
+    uint16_t minInterval;
+    uint16_t maxInterval;
+};
+
+/*
+ *  Intervals follow Apple accessory design guidelines: 20 ms for the first
+ *    30 s, then one of the listed longer intervals (1022.5 ms)
+ *  Directed high duty cycle advertising ignores the interval (<= 3.75 ms, spec fixed)
+ */
+constexpr advParams_t ADV_PARAMS_DIRECTED = {true, 0x20, 0x20};
+constexpr advParams_t ADV_PARAMS_FAST = {false, 0x20, 0x20};    // 20 ms
+constexpr advParams_t ADV_PARAMS_SLOW = {false, 0x662, 0x662};  // 1022.5 ms
+
+class AdvertisingSchedule {
+   public:
+    AdvertisingSchedule(uint32_t directed_msec, uint32_t fast_msec);  // constructor prototype
+
+    // method prototypes:
+    void setBondedHost(bool known) { _hostKnown = known; }
+    advPhase_t update(unsigned long now_msec, bool connected);
+
+    static const advParams_t& params(advPhase_t phase);
+    advPhase_t phase() const { return _phase; }
+
+   private:
+    uint32_t _directed_msec;
+    uint32_t _fast_msec;
+    bool _hostKnown;
+    bool _connected;
+    bool _started;
+    advPhase_t _phase;
+    unsigned long _phaseStart_msec;
+};
+
+#endif  // end header guard
@@ -0,0 +1,97 @@
+/*
+ * *************************************************************
+ * batteryAdc.cpp - ADC backends for the battery monitor
+ *
+ *   ESP32 build: calibrated ADC1 readings on the board profile's channel
+ *   host build:  fake ADC returning a settable pin voltage
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ *  Ver2, 17Oct26: ADC1 channel from the compile-time board profile
+ *
+ * ************************************************************ */
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_BATTERY
+
+#include "batteryMonitor.h"
+#include "boardProfile.h"  // Board::BATTERY_ADC_CHANNEL
+
+#ifdef ARDUINO
+
+#include <Arduino.h>
+
+#include "driver/adc.h"
+#include "esp_adc_cal.h"  // Espressif Analog to Digital Converter (ADC) Calibration Driver library
+#include "logger.h"       // deferred serial logging
+
+// characterised once in adcBatteryBegin(); esp_adc_cal_characterize() is far too slow to repeat per reading
+static esp_adc_cal_characteristics_t adc_chars;
+
+/*****************************************************************************
+Description : Configures ADC1 and characterises it once at boot
+*!             Must solder-bridge zero-ohm pads to enable voltage divider hardware (ref DFR0478 Ver3 schematic)
+
+              Uses eFuse calibrations, if present (ESP32-E), otherwise alternative characterisation used
+              In comparison with a regular voltmeter, ESP32 vs. multimeter values differ only ~0.05V
+Input Value : -
+Return Value: -
+---------------------------------
+Ref:  ADC1_CHANNEL_0 Enumeration
+https://docs.espressif.com/projects/esp-idf/en/v4.1.1/api-reference/peripherals/adc.html#_CPPv414ADC1_CHANNEL_0)
+********************************************************************************/
+template <typename BOARD>
+void adcBatteryBegin() {
+    // divided battery voltage on an ADC1 pin (FireBeetle: GPIO36 / A0 = ADC1_CHANNEL_0)
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    adc1_config_channel_atten((adc1_channel_t)BOARD::BATTERY_ADC_CHANNEL, ADC_ATTEN_DB_11);
+    switch (esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &adc_chars)) {
+        case ESP_ADC_CAL_VAL_EFUSE_TP:
+            LOG_INFO("Characterised using Two Point Value");
+            break;
+        case ESP_ADC_CAL_VAL_EFUSE_VREF:
+            LOG_INFO("Characterised using eFuse Vref (%d mV)", adc_chars.vref);
+            break;
+        default:
+            LOG_INFO("Characterised using Default Vref (%d mV)", 1100);
+    }
+}
+
+/*****************************************************************************
+Description : Single calibrated reading at the board's battery pin (divider not applied)
+
+Input Value : -
+Return Value: pin voltage in millivolts
+********************************************************************************/
+template <typename BOARD>
+uint32_t adcBatteryRead_mV() {
+    return esp_adc_cal_raw_to_voltage(adc1_get_raw((adc1_channel_t)BOARD::BATTERY_ADC_CHANNEL), &adc_chars);
+}
+
+#else  // host build - fake ADC
+
+static uint32_t fakePin_mV = 0;
+static uint32_t fakeReads = 0;
+
+template <typename BOARD>
+void adcBatteryBegin() {
+}
+
+template <typename BOARD>
+uint32_t adcBatteryRead_mV() {
+    fakeReads++;
+    return fakePin_mV;
+}
+
+void fakeAdcSet_mV(uint32_t pin_mV) {
+    fakePin_mV = pin_mV;
+}
+
+uint32_t fakeAdcReads() {
+    return fakeReads;
+}
+
+#endif  // ARDUINO
+
+template void adcBatteryBegin<Board>();
+template uint32_t adcBatteryRead_mV<Board>();
@@ -0,0 +1,84 @@
+/*
+ * *************************************************************
+ * batteryMonitor.cpp - implementation file for background LiPo battery monitor
+ *
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include "batteryMonitor.h"
+
+// BatteryMonitor constructor; ADC backend is injected so the filter can run against a fake ADC
+BatteryMonitor::BatteryMonitor(adcRead_mV_t adcRead,
+                               uint32_t sample_interval_msec,
+                               uint32_t divider_ratio) : _adcRead(adcRead),
+                                                         _sample_interval_msec(sample_interval_msec),
+                                                         _divider_ratio(divider_ratio),
+                                                         _lastSample_msec(0),
+                                                         _filtered_mV_x16(0),
+                                                         _sampleCount(0) {
+}
+
+/*****************************************************************************
+Description : Primes the EMA filter with an averaged burst of readings so the
+                very first battery status shown at power-up is already accurate.
+                Called once from setup(); ADC must already be characterised.
+
+Input Value : now_msec - current time (millis())
+              prime_rounds - number of readings to average
+Return Value: -
+********************************************************************************/
+void BatteryMonitor::begin(unsigned long now_msec, int prime_rounds) {
+    uint32_t value = 0;
+
+    if (prime_rounds < 1) {
+        prime_rounds = 1;
+    }
+    for (int i = 1; i <= prime_rounds; i++) {
+        value += _adcRead();
+    }
+    value /= (uint32_t)prime_rounds;
+
+    _filtered_mV_x16 = value << EMA_SCALE_SHIFT;
+    _lastSample_msec = now_msec;
+    _sampleCount = prime_rounds;
+}
+
+/*****************************************************************************
+Description : Seeds the EMA filter with the pack voltage retained through deep
+                sleep (auto-off), instead of priming with an ADC burst.  Pack
+                voltage barely moves while asleep; normal sampling corrects it.
+
+Input Value : now_msec - current time (millis())
+              battery_mV - pack voltage (after divider correction)
+Return Value: -
+********************************************************************************/
+void BatteryMonitor::resume(unsigned long now_msec, uint32_t battery_mV) {
+    _filtered_mV_x16 = (battery_mV / _divider_ratio) << EMA_SCALE_SHIFT;
+    _lastSample_msec = now_msec;
+    _sampleCount = 0;
+}
+
+/*****************************************************************************
+Description : Takes a single ADC reading if the sample interval has elapsed and
+                folds it into the EMA:  y += (x - y) / 8
+                Non-blocking; call every loop pass.
+
+Input Value : now_msec - current time (millis())
+Return Value: true if a new sample was taken
+********************************************************************************/
+bool BatteryMonitor::update(unsigned long now_msec) {
+    if ((now_msec - _lastSample_msec) < _sample_interval_msec) {
+        return false;
+    }
+    _lastSample_msec = now_msec;
+
+    int32_t sample_x16 = (int32_t)(_adcRead() << EMA_SCALE_SHIFT);
+    int32_t error = sample_x16 - (int32_t)_filtered_mV_x16;
+    _filtered_mV_x16 = (uint32_t)((int32_t)_filtered_mV_x16 + (error >> EMA_ALPHA_SHIFT));
+    _sampleCount++;
+
+    return true;
+}
@@ -0,0 +1,67 @@
+/*
+ * *************************************************************
+ * batteryMonitor.h - Header file for background LiPo battery monitor
+ *
+ *   Samples the battery voltage divider on a slow fixed schedule, smooths the
+ *   readings with a fixed-point exponential moving average (EMA) and publishes
+ *   a cached voltage that callers read in O(1).
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef BATTERY_MONITOR_H  // begin header guard
+#define BATTERY_MONITOR_H
+
+#include <stdint.h>  // no Arduino dependency so filter + schedule also compile on a Linux host
+
+// ADC backend: returns ONE calibrated reading at the ADC pin, in millivolts (before divider correction)
+typedef uint32_t (*adcRead_mV_t)();
+
+class BatteryMonitor {
+   public:
+    BatteryMonitor(adcRead_mV_t adcRead,
+                   uint32_t sample_interval_msec,
+                   uint32_t divider_ratio);  // constructor prototype
+
+    // method prototypes:
+    void begin(unsigned long now_msec, int prime_rounds);
+    void resume(unsigned long now_msec, uint32_t battery_mV);  // seed from retained value (no ADC burst)
+    bool update(unsigned long now_msec);
+    void setSampleInterval(uint32_t sample_interval_msec) { _sample_interval_msec = sample_interval_msec; }  // battery saver
+
+    // cached results - cheap enough to call from every loop pass
+    float voltage() const { return millivolts() / 1000.0; }
+    uint32_t millivolts() const { return (_filtered_mV_x16 >> EMA_SCALE_SHIFT) * _divider_ratio; }
+    uint32_t sampleCount() const { return _sampleCount; }
+
+   private:
+    static const uint8_t EMA_SCALE_SHIFT = 4;  // filter state held as mV * 16 to keep fractional bits
+    static const uint8_t EMA_ALPHA_SHIFT = 3;  // alpha = 1/8; ~8 samples to settle after a step change
+
+    adcRead_mV_t _adcRead;
+    uint32_t _sample_interval_msec;
+    uint32_t _divider_ratio;
+    unsigned long _lastSample_msec;
+    uint32_t _filtered_mV_x16;
+    uint32_t _sampleCount;
+};
+
+/******************************************************
+// ADC backends (see batteryAdc.cpp)
+******************************************************/
+template <typename BOARD>
+void adcBatteryBegin();  // configure + characterise ADC once at boot
+template <typename BOARD>
+uint32_t adcBatteryRead_mV();  // single reading at BOARD::BATTERY_ADC_CHANNEL, millivolts
+
+#ifndef ARDUINO
+// fake ADC backend for host builds; set the voltage seen at the ADC pin (mV)
+void fakeAdcSet_mV(uint32_t pin_mV);
+uint32_t fakeAdcReads();  // readings taken so far (battery sampling cost)
+#endif
+
+extern BatteryMonitor batteryMonitor;  // instantiated in flipState.cpp
+
+#endif  // end header guard
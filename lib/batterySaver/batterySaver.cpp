@@ -0,0 +1,101 @@
+/*
+ * *************************************************************
+ * batterySaver.cpp - implementation file for battery-aware degradation policy
+ *
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include "batterySaver.h"
+
+#include "batteryMonitor.h"
+#include "connParams.h"
+#include "controlRGB.h"
+#include "flipState.h"  // setIndicationScale()
+#include "hal.h"
+#include "powerPolicy.h"
+
+// BatterySaver constructor; starts at NORMAL until the first battery estimate
+BatterySaver::BatterySaver(uint8_t reducedBelow_percent,
+                           uint8_t criticalBelow_percent,
+                           uint8_t hysteresis_percent) : _reducedBelow_percent(reducedBelow_percent),
+                                                         _criticalBelow_percent(criticalBelow_percent),
+                                                         _hysteresis_percent(hysteresis_percent),
+                                                         _level(SAVER_NORMAL),
+                                                         _previous(SAVER_NORMAL),
+                                                         _levelEntered_msec(0),
+                                                         _lastUpdate_msec(0) {
+    resetStats(0);
+}
+
+void BatterySaver::resetStats(unsigned long now_msec) {
+    for (int l = 0; l < SAVER_LEVEL_COUNT; l++) {
+        _residency_msec[l] = 0;
+        _entries[l] = 0;
+    }
+    _lastUpdate_msec = now_msec;
+}
+
+// level for a charge, thresholds raised by margin (hysteresis on the way back up)
+saverLevel_t BatterySaver::levelFor(uint8_t percent, uint8_t margin) const {
+    if (percent < _criticalBelow_percent + margin) {
+        return SAVER_CRITICAL;
+    }
+    if (percent < _reducedBelow_percent + margin) {
+        return SAVER_REDUCED;
+    }
+    return SAVER_NORMAL;
+}
+
+/*****************************************************************************
+Description : Picks the saver level for the reported charge and accumulates
+                residency.  Drops a level as soon as percent is below its
+                threshold; climbs back only at threshold + hysteresis.
+
+Input Value : now_msec, percent - reported state of charge (socEstimator)
+Return Value: true if the level changed (caller applies SAVER_PROFILES[level()])
+********************************************************************************/
+bool BatterySaver::update(unsigned long now_msec, uint8_t percent) {
+    _residency_msec[_level] += now_msec - _lastUpdate_msec;
+    _lastUpdate_msec = now_msec;
+
+    saverLevel_t wanted = levelFor(percent, 0);
+    if (wanted < _level) {
+        wanted = levelFor(percent, _hysteresis_percent);
+        if (wanted >= _level) {
+            return false;
+        }
+    }
+    if (wanted == _level) {
+        return false;
+    }
+    _previous = _level;
+    _level = wanted;
+    _levelEntered_msec = now_msec;
+    _entries[wanted]++;
+    return true;
+}
+
+/*****************************************************************************
+Description : Background task side of a saver level change: battery sample
+                interval, BLE idle interval, LED brightness (rgbLed) and
+                the length of timed LED indications.
+
+Input Value : profile - SAVER_PROFILES[level], monitor, connPolicy
+Return Value: -
+********************************************************************************/
+void applySaverBackground(const saverProfile_t& profile, BatteryMonitor& monitor, ConnectionPolicy& connPolicy) {
+    monitor.setSampleInterval(profile.batterySample_msec);
+    connPolicy.setIdleAfter(profile.connIdleAfter_msec);
+    connPolicy.setSaverInterval(profile.connSaverInterval);
+    rgbLed.setBrightness(profile.ledBrightness_percent);
+    setIndicationScale(profile.ledDuration_percent);
+}
+
+// input task side of a saver level change: power mode timing and the boost clock
+void applySaverInput(const saverProfile_t& profile, PowerPolicy& powerPolicy) {
+    powerPolicy.setTiming(profile.boost_msec, profile.sleepAfter_msec);
+    halPowerSetMaxMhz(profile.boostMhz);
+}
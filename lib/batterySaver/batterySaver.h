@@ -0,0 +1,85 @@
+/*
+ * *************************************************************
+ * batterySaver.h - Header file for battery-aware degradation policy
+ *
+ *   Three saver levels keyed on the reported state of charge (socEstimator):
+ *     NORMAL    full behaviour
+ *     REDUCED   lower boost clock, earlier light sleep / long BLE interval,
+ *               dimmer and shorter LED indications, slower battery sampling
+ *     CRITICAL  all of the above, further
+ *   Levels drop as soon as the charge falls below a threshold and only climb
+ *   back once it is a hysteresis margin above it (ie on charge).  What each
+ *   level changes is the saverProfile_t table in myConstants.h; a press still
+ *   boosts the clock and brings back the short connection interval, so page
+ *   turn latency is protected at every level.  BatterySaver is pure policy;
+ *   applySaverBackground() / applySaverInput() apply a level's profile for
+ *   each task, so the firmware and tools/saverSim share them.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef BATTERY_SAVER_H  // begin header guard
+#define BATTERY_SAVER_H
+
+#include <stdint.h>
+
+enum saverLevel_t { SAVER_NORMAL,
+                    SAVER_REDUCED,
+                    SAVER_CRITICAL,
+                    SAVER_LEVEL_COUNT };
+
+// what one saver level changes (one row per level, see SAVER_PROFILES)
+struct saverProfile_t {
+    saverLevel_t level;
+    const char* name;
+    int boostMhz;                   // CPU clock while a press is handled; BLE needs >= 80 MHz
+    uint32_t boost_msec;            // powerPolicy: full clock for this long after activity
+    uint32_t sleepAfter_msec;       // powerPolicy: light sleep after this much inactivity
+    uint32_t connIdleAfter_msec;    // connPolicy: long interval after this much inactivity
+    bool connSaverInterval;         // idle on CONN_PARAMS_SAVER instead of CONN_PARAMS_IDLE
+    uint32_t batterySample_msec;    // batteryMonitor sample interval
+    uint8_t ledBrightness_percent;  // scales LED pwm duty
+    uint8_t ledDuration_percent;    // scales battery colour display time (LED_DURATION_MSEC)
+};
+
+class BatteryMonitor;
+class ConnectionPolicy;
+class PowerPolicy;
+
+// applying a level's profile (SAVER_PROFILES[level]):
+void applySaverBackground(const saverProfile_t& profile, BatteryMonitor& monitor, ConnectionPolicy& connPolicy);
+void applySaverInput(const saverProfile_t& profile, PowerPolicy& powerPolicy);
+
+class BatterySaver {
+   public:
+    BatterySaver(uint8_t reducedBelow_percent,
+                 uint8_t criticalBelow_percent,
+                 uint8_t hysteresis_percent);  // constructor prototype
+
+    // method prototypes:
+    bool update(unsigned long now_msec, uint8_t percent);
+    void resetStats(unsigned long now_msec);
+
+    saverLevel_t level() const { return _level; }
+    saverLevel_t previous() const { return _previous; }
+    unsigned long levelEntered_msec() const { return _levelEntered_msec; }
+    uint32_t residency_msec(saverLevel_t level) const { return _residency_msec[level]; }
+    uint32_t entries(saverLevel_t level) const { return _entries[level]; }
+
+   private:
+    saverLevel_t levelFor(uint8_t percent, uint8_t margin) const;
+
+    uint8_t _reducedBelow_percent;
+    uint8_t _criticalBelow_percent;
+    uint8_t _hysteresis_percent;
+    saverLevel_t _level;
+    saverLevel_t _previous;
+    unsigned long _levelEntered_msec;
+    unsigned long _lastUpdate_msec;
+    uint32_t _residency_msec[SAVER_LEVEL_COUNT];
+    uint32_t _entries[SAVER_LEVEL_COUNT];
+};
+
+#endif  // end header guard
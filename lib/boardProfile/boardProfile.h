@@ -0,0 +1,99 @@
+/*
+ * *************************************************************
+ * boardProfile.h - compile-time board profiles
+ *
+ *   A board is a type whose static constexpr members give its pins, RGB LED
+ *   polarity, battery ADC channel and divider.  RgbLed, Press_Type and the
+ *   battery ADC reader are templates on the board, so every pin and polarity
+ *   is a constant folded into the code - no pin fields, no runtime lookups.
+ *   Add a board by adding a struct below; pick it with
+ *       build_flags = -D FLIPTURN_BOARD=BoardEsp32DevKitC
+ *   (default BoardFireBeetleEsp32).  No Arduino dependency.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef BOARD_PROFILE_H  // begin header guard
+#define BOARD_PROFILE_H
+
+#include <stdint.h>
+
+enum ledPolarity_t { LED_COMMON_CATHODE,  // LED on = pin high (current sourcing)
+                     LED_COMMON_ANODE };  // LED on = pin low (current sinking); duty inverted
+
+/*
+ *  DFR0478 (Firebeetle ESP32 Ver1) microcontroller pinout:
+ *   Pin        Function    Comment
+ *   -------    --------    -----------------------------------------------
+ *   GND         GND        Split line ground between switch and RGB LED
+ *   A0 (IO36)   battery    Read battery voltage (must bridge Rx and Ry zero ohm resistor pads on Firebeetle voltage divider)
+ *   D6 (IO10)   switch     Microswitch; built-in pullup resistor enabled
+ *   IO19        R-LED      Red anode RGB LED (80 ohm current limiting resistor)
+ *   IO23        G-LED      Green anode RGB LED (12 ohm current limiting resistor)
+ *   IO18        B-LED      Blue anode RGB LED (12 ohm current limiting resistor)
+ *  *******************************************************
+ *    Note:  See Firebeetle pin mapping table for full board pin-out; pin number 35 is same as GPIO35 / IO35
+ *
+ *   Initial prototype (this pin configuration not used in final device):
+ *   -------    --------    -----------------------------------------------
+ *   D2 (IO25)   R-LED      Red anode RGB LED (82 ohm current limiting resistor)
+ *   D3 (IO26)   G-LED      Green anode RGB LED (12 ohm current limiting resistor)
+ *   D4 (IO27)   B-LED      Blue anode RGB LED (12 ohm current limiting resistor)
+ *
+ *   5mm RGB LED - Common Cathode   Source: AliExpress
+ *    Pin    Function     Comment                       Current limiting resistor
+ *    ----   --------     ------------------------      -------------------------
+ *    1      Red anode    Typ Vf (@ If=20mA) = 2.0V      82 ohm
+ *    2      GND          Common Cathode
+ *    3      Green anode  Typ Vf (@ If=20mA) = 3.2V      12 ohm
+ *    4      Blue anode   Typ Vf (@ If=20mA) = 3.1V      12 ohm
+ *
+ *   A0 / GPIO36 may conflict with wifi (not confirmed); flipTurn uses BLE only.
+ */
+struct BoardFireBeetleEsp32 {
+    static const char* name() { return "FireBeetle ESP32 (DFR0478)"; }
+
+    static constexpr int SWITCH_PIN = 10;  // D6; not an RTC GPIO, so no auto-off wake
+    static constexpr bool SWITCH_INTERNAL_PULLUP = true;
+
+    static constexpr int RED_LED_PIN = 19;
+    static constexpr int GREEN_LED_PIN = 23;
+    static constexpr int BLUE_LED_PIN = 18;
+    static constexpr ledPolarity_t LED_POLARITY = LED_COMMON_CATHODE;
+
+    static constexpr int BATTERY_ADC_CHANNEL = 0;  // ADC1 channel 0 = GPIO36 / A0
+    static constexpr uint32_t BATTERY_DIVIDER_RATIO = 2;  // on-board 1M + 1M divider
+};
+
+/*
+ *  Espressif ESP32-DevKitC, hand wired:
+ *   IO33        switch     NO to GND; RTC GPIO, so the pedal wakes flipTurn from auto-off
+ *   IO25/26/27  R/G/B-LED  common anode RGB LED (anode to 3V3)
+ *   IO34        battery    external 100k + 100k divider from the cell
+ */
+struct BoardEsp32DevKitC {
+    static const char* name() { return "ESP32-DevKitC"; }
+
+    static constexpr int SWITCH_PIN = 33;
+    static constexpr bool SWITCH_INTERNAL_PULLUP = true;
+
+    static constexpr int RED_LED_PIN = 25;
+    static constexpr int GREEN_LED_PIN = 26;
+    static constexpr int BLUE_LED_PIN = 27;
+    static constexpr ledPolarity_t LED_POLARITY = LED_COMMON_ANODE;
+
+    static constexpr int BATTERY_ADC_CHANNEL = 6;  // ADC1 channel 6 = GPIO34
+    static constexpr uint32_t BATTERY_DIVIDER_RATIO = 2;
+};
+
+#ifndef FLIPTURN_BOARD
+#define FLIPTURN_BOARD BoardFireBeetleEsp32
+#endif
+typedef FLIPTURN_BOARD Board;  // the board this firmware is built for
+
+static_assert((Board::BATTERY_ADC_CHANNEL >= 0) && (Board::BATTERY_ADC_CHANNEL <= 7), "battery must be on ADC1 (ADC2 is unusable with BLE)");
+static_assert(!Board::SWITCH_INTERNAL_PULLUP || (Board::SWITCH_PIN < 34), "GPIO 34-39 have no internal pullup; fit an external one");
+
+#endif  // end header guard
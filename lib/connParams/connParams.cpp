@@ -0,0 +1,93 @@
+/*
+ * *************************************************************
+ * connParams.cpp - implementation file for adaptive BLE connection parameter policy
+ *
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include "connParams.h"
+
+// ConnectionPolicy constructor
+ConnectionPolicy::ConnectionPolicy(uint32_t idleAfter_msec,
+                                   uint32_t retry_msec) : _idleAfter_msec(idleAfter_msec),
+                                                          _retry_msec(retry_msec),
+                                                          _saverInterval(false),
+                                                          _connected(false),
+                                                          _profile(CONN_PROFILE_NONE),
+                                                          _failedProfile(CONN_PROFILE_NONE),
+                                                          _lastActivity_msec(0),
+                                                          _lastFailure_msec(0),
+                                                          _requestCount(0) {
+}
+
+// foot switch activity; keeps (or brings back) the short connection interval
+void ConnectionPolicy::onActivity(unsigned long now_msec) {
+    _lastActivity_msec = now_msec;
+}
+
+/*****************************************************************************
+Description : Decides whether the connection parameters should change.
+                Newly connected -> ACTIVE (fast service discovery + first page turn)
+                ACTIVE and no switch activity for idleAfter -> IDLE (SAVER on low battery)
+                IDLE / SAVER and switch activity -> ACTIVE
+                A rejected request is only retried after retry_msec.
+
+Input Value : now_msec, connected - current BLE connection state
+Return Value: profile to request now, or CONN_PROFILE_NONE for no change
+********************************************************************************/
+connProfile_t ConnectionPolicy::update(unsigned long now_msec, bool connected) {
+    if (!connected) {
+        _connected = false;
+        _profile = CONN_PROFILE_NONE;
+        _failedProfile = CONN_PROFILE_NONE;
+        return CONN_PROFILE_NONE;
+    }
+    if (!_connected) {
+        _connected = true;
+        _lastActivity_msec = now_msec;  // connecting counts as activity
+    }
+
+    connProfile_t idle = _saverInterval ? CONN_PROFILE_SAVER : CONN_PROFILE_IDLE;
+    connProfile_t wanted = ((now_msec - _lastActivity_msec) >= _idleAfter_msec) ? idle : CONN_PROFILE_ACTIVE;
+
+    if (wanted == _profile) {
+        return CONN_PROFILE_NONE;
+    }
+    if ((wanted == _failedProfile) && ((now_msec - _lastFailure_msec) < _retry_msec)) {
+        return CONN_PROFILE_NONE;
+    }
+    _requestCount++;
+    return wanted;
+}
+
+/*****************************************************************************
+Description : Result of applying a requested profile through the BLE stack
+
+Input Value : profile - as returned by update(); accepted - stack took the request
+              now_msec
+Return Value: -
+********************************************************************************/
+void ConnectionPolicy::applied(connProfile_t profile, bool accepted, unsigned long now_msec) {
+    if (accepted) {
+        _profile = profile;
+        _failedProfile = CONN_PROFILE_NONE;
+    } else {
+        _failedProfile = profile;
+        _lastFailure_msec = now_msec;
+    }
+}
+
+const connParams_t& ConnectionPolicy::params(connProfile_t profile) {
+    return (profile == CONN_PROFILE_IDLE)    ? CONN_PARAMS_IDLE
+           : (profile == CONN_PROFILE_SAVER) ? CONN_PARAMS_SAVER
+                                             : CONN_PARAMS_ACTIVE;
+}
+
+const char* ConnectionPolicy::name(connProfile_t profile) {
+    return (profile == CONN_PROFILE_IDLE)    ? "IDLE"
+           : (profile == CONN_PROFILE_SAVER) ? "SAVER"
+                                             : "ACTIVE";
+}
@@ -0,0 +1,80 @@
+/*
+ * *************************************************************
+ * connParams.h - Header file for adaptive BLE connection parameter policy
+ *
+ *   Short connection interval (fast page turns) right after foot switch
+ *   activity; long interval + slave latency (radio mostly asleep) once the
+ *   switch has been idle for a while (longer still under the battery saver, see
+ *   batterySaver.h).  Pure policy - the caller applies the
+ *   requested parameters through the HAL, so it also runs on a host.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef CONN_PARAMS_H  // begin header guard
+#define CONN_PARAMS_H
+
+#include <stdint.h>
+
+enum connProfile_t { CONN_PROFILE_NONE,  // not connected / no change requested
+                     CONN_PROFILE_ACTIVE,
+                     CONN_PROFILE_IDLE,
+                     CONN_PROFILE_SAVER };  // idle on a low battery
+
+// BLE units: interval x 1.25 ms, supervision timeout x 10 ms
+struct connParams_t {
+    uint16_t minInterval;
+    uint16_t maxInterval;
+    uint16_t latency;  // slave latency (connection events peripheral may skip when it has nothing to send)
+    uint16_t timeout;
+};
+
+/*
+ *  Profiles respect Apple accessory design guidelines (iPad central):
+ *    interval min >= 15 ms;  interval min + 15 ms <= interval max
+ *    interval max * (latency + 1) <= 2 s;  latency <= 30
+ *    2 s <= supervision timeout <= 6 s;  interval max * (latency + 1) * 3 < timeout
+ */
+constexpr connParams_t CONN_PARAMS_ACTIVE = {12, 24, 0, 200};  // 15 - 30 ms, no latency, 2 s timeout
+constexpr connParams_t CONN_PARAMS_IDLE = {96, 120, 4, 500};   // 120 - 150 ms, latency 4 (750 ms), 5 s timeout
+constexpr connParams_t CONN_PARAMS_SAVER = {120, 144, 6, 600};  // 150 - 180 ms, latency 6 (1.26 s), 6 s timeout
+
+// slave latency only applies when the peripheral has nothing to send, so the first press after
+//   going idle waits at most one connection interval; keep that within the page turn budget
+constexpr uint32_t CONN_WORST_TURN_LATENCY_MSEC = 200;
+static_assert(CONN_PARAMS_IDLE.maxInterval * 5 / 4 <= CONN_WORST_TURN_LATENCY_MSEC, "idle interval exceeds page turn budget");
+static_assert(CONN_PARAMS_SAVER.maxInterval * 5 / 4 <= CONN_WORST_TURN_LATENCY_MSEC, "saver interval exceeds page turn budget");
+static_assert(CONN_PARAMS_SAVER.maxInterval * (CONN_PARAMS_SAVER.latency + 1) * 5 / 4 <= 2000, "Apple: interval max * (latency + 1) <= 2 s");
+static_assert(CONN_PARAMS_SAVER.maxInterval * (CONN_PARAMS_SAVER.latency + 1) * 5 / 4 * 3 < CONN_PARAMS_SAVER.timeout * 10, "Apple: 3 missed windows < supervision timeout");
+
+class ConnectionPolicy {
+   public:
+    ConnectionPolicy(uint32_t idleAfter_msec, uint32_t retry_msec);  // constructor prototype
+
+    // method prototypes:
+    void onActivity(unsigned long now_msec);
+    connProfile_t update(unsigned long now_msec, bool connected);
+    void applied(connProfile_t profile, bool accepted, unsigned long now_msec);
+
+    static const connParams_t& params(connProfile_t profile);
+    static const char* name(connProfile_t profile);
+    connProfile_t profile() const { return _profile; }
+    uint32_t requestCount() const { return _requestCount; }
+    void setIdleAfter(uint32_t idleAfter_msec) { _idleAfter_msec = idleAfter_msec; }
+    void setSaverInterval(bool saver) { _saverInterval = saver; }  // idle on CONN_PARAMS_SAVER
+
+   private:
+    uint32_t _idleAfter_msec;
+    uint32_t _retry_msec;
+    bool _saverInterval;
+    bool _connected;
+    connProfile_t _profile;         // last profile accepted by the stack
+    connProfile_t _failedProfile;   // last rejected request, retried after _retry_msec
+    unsigned long _lastActivity_msec;
+    unsigned long _lastFailure_msec;
+    uint32_t _requestCount;
+};
+
+#endif  // end header guard
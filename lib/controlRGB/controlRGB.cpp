@@ -7,80 +7,220 @@
  *  C W Greenstreet, Ver1, 10Dec23
  *    MIT Licence - Released into the public domain
  *
+ *  Ver2, 17Oct26: LEDC engine with gamma table + hardware fades
+ *  Ver3, 17Oct26: templated on the board profile
+ *  Ver4, 17Oct26: brightness scaling (battery saver)
+ *
  * ************************************************************ */
 
-//!  debug scaffold not used - remove if it remains unused
-// set up debug scaffold; comment out following line if you want to "turn off" debugging to serial monitor
-// #define DEBUG 1
-
 #include "controlRGB.h"
 
-// RgbLed constructor for common cathode RGB LED
-RgbLed::RgbLed(int red_pin, int green_pin, int blue_pin) : _red_pin(red_pin),
-                                                           _green_pin(green_pin),
-                                                           _blue_pin(blue_pin) {
-    pinMode(_red_pin, OUTPUT);
-    pinMode(_green_pin, OUTPUT);
-    pinMode(_blue_pin, OUTPUT);
+#include "hal.h"  // LEDC pwm + time via hardware abstraction layer
+
+// LEDC channel per colour
+constexpr int RED_LED_CHANNEL = 0;
+constexpr int GREEN_LED_CHANNEL = 1;
+constexpr int BLUE_LED_CHANNEL = 2;
+
+constexpr uint32_t BLINK_FADE_MSEC = 40;  // soft edge on blink transitions; done by LEDC hardware
+
+// RgbLed constructor; pins are BOARD constants, pwm hardware set up later in begin()
+template <typename BOARD>
+RgbLedT<BOARD>::RgbLedT() : _pattern(SOLID),
+                            _colour{0, 0, 0},
+                            _brightness(256),
+                            _interval_msec(0),
+                            _phaseOn(false),
+                            _nextToggle_msec(0),
+                            _testStep(-1),
+                            _testStep_msec(0),
+                            _testStepStart_msec(0) {
+}
+
+/*****************************************************************************
+Purpose     : Attaches the three LED pins to LEDC channels (led off)
+                Call once from setup()
+
+Input Value : -
+Return Value: -
+********************************************************************************/
+template <typename BOARD>
+void RgbLedT<BOARD>::begin() {
+    halLedAttach(RED_LED_CHANNEL, BOARD::RED_LED_PIN);
+    halLedAttach(GREEN_LED_CHANNEL, BOARD::GREEN_LED_PIN);
+    halLedAttach(BLUE_LED_CHANNEL, BOARD::BLUE_LED_PIN);
+    _pattern = SOLID;
+    _colour = led_off;
+    output(led_off, 0);  // attach leaves duty 0 = full on for a common anode LED
+}
+
+// gamma correct + write (or hardware fade) all three channels
+template <typename BOARD>
+void RgbLedT<BOARD>::output(const StatusColour& colour, uint32_t fade_msec) {
+    halLedFade(RED_LED_CHANNEL, duty(colour.red), fade_msec);
+    halLedFade(GREEN_LED_CHANNEL, duty(colour.green), fade_msec);
+    halLedFade(BLUE_LED_CHANNEL, duty(colour.blue), fade_msec);
+}
+
+// gamma corrected, brightness scaled duty for one channel; polarity folds away at compile time
+template <typename BOARD>
+uint16_t RgbLedT<BOARD>::duty(uint8_t value) const {
+    uint16_t on = (uint16_t)(((uint32_t)gammaLut::duty[value] * _brightness) >> 8);
+    return (BOARD::LED_POLARITY == LED_COMMON_ANODE) ? LED_PWM_MAX_DUTY - on : on;
+}
+
+/*****************************************************************************
+Purpose     : Scales LED brightness (battery saver).  Current through each
+                LED is proportional to duty, so 50% halves the LED drain.
+                A solid colour is rewritten now; patterns pick it up next phase.
+
+Input Value : percent - 1 to 100
+Return Value: -
+********************************************************************************/
+template <typename BOARD>
+void RgbLedT<BOARD>::setBrightness(uint8_t percent) {
+    uint16_t brightness = (uint16_t)(((percent > 100 ? 100 : percent) * 256 + 50) / 100);
+    if (brightness == _brightness) {
+        return;
+    }
+    _brightness = brightness;
+    if (_pattern == SOLID) {
+        output(_colour, 0);
+    }
+}
+
+template <typename COLOUR>
+static bool sameColour(const COLOUR& a, const COLOUR& b) {
+    return (a.red == b.red) && (a.green == b.green) && (a.blue == b.blue);
 }
 
-RgbLed::StatusColour statusColour;
+template <typename BOARD>
+void RgbLedT<BOARD>::startPattern(ledPattern_t pattern, const StatusColour& colour, unsigned long interval_msec) {
+    _pattern = pattern;
+    _colour = colour;
+    _interval_msec = interval_msec;
+    _phaseOn = false;
+    _nextToggle_msec = halMillis();  // first phase change on this call
+}
 
 /*****************************************************************************
 Purpose     : Displays a defined RGB LED colour by passing R, G and B values through a struct
                 const pass by ref avoids inefficient copying yet prevents any changes to underlying struct
+                pwm is only written when the colour (or pattern) actually changes, so this is
+                cheap to call every loop pass
 
 Input Value : Class struct instantiation for pre-defined status colours, containing
               R, G and B values for a specific colour output:
                  blue_BT_connected{0, 0, 255}
-                 green_fully_charged_battery{0, 255, 0}
-                 magenta_low_battery{255, 255, 0}
+                 green_high_battery_charge{0, 255, 0}
+                 orange_charge_battery_warning{255, 80, 0}
                  red_critically_low_battery{255, 0, 0}
                  led_off{0, 0, 0}
 Return Value: - n/a -
 ********************************************************************************/
-void RgbLed::setRgbColour(const RgbLed::StatusColour& statusColour) {
-    analogWrite(_red_pin, statusColour.red);
-    analogWrite(_green_pin, statusColour.green);
-    analogWrite(_blue_pin, statusColour.blue);
+template <typename BOARD>
+void RgbLedT<BOARD>::setRgbColour(const StatusColour& statusColour) {
+    if ((_pattern == SOLID) && sameColour(_colour, statusColour)) {
+        return;
+    }
+    _pattern = SOLID;
+    _colour = statusColour;
+    output(statusColour, 0);
 }
 
 /*****************************************************************************
-Purpose     : Blink RGB LED in designated colour
+Purpose     : Blink RGB LED in designated colour.  Call every loop pass; between
+                phase changes this is a single time comparison.
 
 Input Value : statusColour (see RgbLed Class for designated colour choices),
               Blink interval in msec (interval = on time = off time)
 Return Value: -
 ********************************************************************************/
-void RgbLed::ledBlink(const RgbLed::StatusColour& statusColour,
-                      unsigned long blink_interval_msec) {
-    // switch expression uses clever 1-line approach that evaluates to either 0 or 1
-    //  ref: https://blog.wokwi.com/5-ways-to-blink-an-led-with-arduino/
-    switch ((millis() / blink_interval_msec) % 2) {
-        case 0:  // led off
-            this->setRgbColour(this->led_off);
-            break;
-        case 1:  // led on, displayed in designated colour (passed as argument)
-            this->setRgbColour(statusColour);
-            break;
+template <typename BOARD>
+void RgbLedT<BOARD>::ledBlink(const StatusColour& statusColour,
+                              unsigned long blink_interval_msec) {
+    if ((_pattern != BLINK) || !sameColour(_colour, statusColour) || (_interval_msec != blink_interval_msec)) {
+        startPattern(BLINK, statusColour, blink_interval_msec);
+    }
+    unsigned long now_msec = halMillis();
+    if ((long)(now_msec - _nextToggle_msec) < 0) {
+        return;
     }
+    _phaseOn = !_phaseOn;
+    _nextToggle_msec = now_msec + _interval_msec;
+    output(_phaseOn ? _colour : led_off, BLINK_FADE_MSEC);
 }
 
 /*****************************************************************************
-Purpose     : Test RGB LED by cycling through designated status colours
+Purpose     : "Breathe" RGB LED in designated colour - slow hardware fade up and
+                down; the CPU only restarts the fade twice per period
 
-Input Value : -
+Input Value : statusColour, breathe period in msec (fade up + fade down)
+Return Value: -
+********************************************************************************/
+template <typename BOARD>
+void RgbLedT<BOARD>::ledBreathe(const StatusColour& statusColour,
+                                unsigned long breathe_period_msec) {
+    if ((_pattern != BREATHE) || !sameColour(_colour, statusColour) || (_interval_msec != breathe_period_msec / 2)) {
+        startPattern(BREATHE, statusColour, breathe_period_msec / 2);
+    }
+    unsigned long now_msec = halMillis();
+    if ((long)(now_msec - _nextToggle_msec) < 0) {
+        return;
+    }
+    _phaseOn = !_phaseOn;
+    _nextToggle_msec = now_msec + _interval_msec;
+    output(_phaseOn ? _colour : led_off, _interval_msec * 9 / 10);  // finish fade before next phase
+}
+
+/*****************************************************************************
+Purpose     : Test RGB LED by cycling through designated status colours; starts
+                the sequence, functionTestRunning() steps it without blocking
+
+Input Value : step_msec - time on each colour
 Return Value: -
 ********************************************************************************/
-void RgbLed::functionTest() {
-    this->setRgbColour(blue_BT_connected);
-    delay(1000);
-    this->setRgbColour(green_high_battery_charge);
-    delay(1000);
-    this->setRgbColour(magenta_charge_battery_warning);
-    delay(1000);
-    this->setRgbColour(red_critically_low_battery);
-    delay(1000);
-    this->setRgbColour(led_off);
-    delay(1000);
+template <typename BOARD>
+void RgbLedT<BOARD>::functionTest(unsigned long step_msec) {
+    _testStep = 0;
+    _testStep_msec = step_msec;
+    _testStepStart_msec = halMillis();
+    setRgbColour(blue_BT_connected);
+}
+
+/*****************************************************************************
+Purpose     : Advances the function test (blue, green, orange, red, off)
+
+Input Value : -
+Return Value: true while the function test is still running
+********************************************************************************/
+template <typename BOARD>
+bool RgbLedT<BOARD>::functionTestRunning() {
+    if (_testStep < 0) {
+        return false;
+    }
+    unsigned long now_msec = halMillis();
+    if ((now_msec - _testStepStart_msec) < _testStep_msec) {
+        return true;
+    }
+    _testStepStart_msec = now_msec;
+    switch (++_testStep) {
+        case 1:
+            setRgbColour(green_high_battery_charge);
+            return true;
+        case 2:
+            setRgbColour(orange_charge_battery_warning);
+            return true;
+        case 3:
+            setRgbColour(red_critically_low_battery);
+            return true;
+        case 4:
+            setRgbColour(led_off);
+            return true;
+        default:
+            _testStep = -1;
+            return false;
+    }
 }
+
+template class RgbLedT<Board>;  // only the profile being built is compiled
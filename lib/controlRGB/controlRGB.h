@@ -6,48 +6,109 @@
  *  C W Greenstreet, Ver1, 10Dec23
  *    MIT Licence - Released into the public domain
  *
+ *  Ver2, 17Oct26: ESP32 LEDC engine - 10 bit pwm through a compile-time gamma
+ *    table, hardware fades for blink / breathe, and pwm registers written only
+ *    when the displayed colour or pattern changes.  Function test is non-blocking.
+ *  Ver3, 17Oct26: pins and LED polarity from the compile-time board profile
+ *    (RgbLedT<BOARD>); common anode LEDs driven with inverted duty.
+ *  Ver4, 17Oct26: brightness scaling, used by the battery saver
+ *
  * ************************************************************ */
 
 #ifndef CONTROL_RGB_H  // begin header guard
 #define CONTROL_RGB_H
 
-#if ARDUINO >= 100  // this if-else block manages depreciated versions of Arduino IDE
-#include <Arduino.h>
-#else
-#include <WConstants.h>
-#include <WProgram.h>
-#include <pins_arduino.h>
-#endif  // end if-block
+#include <stdint.h>
+
+#include "boardProfile.h"
+
+/******************************************************
+// Gamma correction:  duty = 1023 * (v / 255) ^ 2.25
+//   2.25 = 2 + 1/4 keeps the maths to two square roots, so the table builds
+//   with C++11 constexpr (Arduino-ESP32 default -std=gnu++11); close to sRGB 2.2
+******************************************************/
+constexpr int LED_PWM_BITS = 10;
+constexpr uint16_t LED_PWM_MAX_DUTY = (1 << LED_PWM_BITS) - 1;
+
+constexpr double gammaSqrt(double x, double guess, int iterations) {
+    return iterations == 0 ? guess : gammaSqrt(x, 0.5 * (guess + x / guess), iterations - 1);
+}
+constexpr double gammaPow225(double x) {
+    return x <= 0.0 ? 0.0 : x * x * gammaSqrt(gammaSqrt(x, 1.0, 30), 1.0, 30);
+}
+constexpr uint16_t gammaDuty(int value) {
+    return (uint16_t)(LED_PWM_MAX_DUTY * gammaPow225(value / 255.0) + 0.5);
+}
+
+// builds gammaTable<0..255>::duty[] at compile time (C++11 index pack)
+template <int... I>
+struct gammaTable {
+    static constexpr uint16_t duty[sizeof...(I)] = {gammaDuty(I)...};
+};
+template <int... I>
+constexpr uint16_t gammaTable<I...>::duty[sizeof...(I)];
+
+template <int N, int... I>
+struct makeGammaTable : makeGammaTable<N - 1, N - 1, I...> {};
+template <int... I>
+struct makeGammaTable<0, I...> : gammaTable<I...> {};
 
-class RgbLed {
+typedef makeGammaTable<256> gammaLut;  // gammaLut::duty[0..255]
+static_assert(gammaLut::duty[0] == 0 && gammaLut::duty[255] == LED_PWM_MAX_DUTY, "gamma table end points");
+
+template <typename BOARD>
+class RgbLedT {
    public:
-    RgbLed(int red_pin, int green_pin, int blue_pin);  // constructor prototype
+    RgbLedT();  // constructor prototype; pins come from BOARD
 
     struct StatusColour {
-        int red, green, blue;  // rgb values, permissible values 0 - 255.
-    };                         //  Colour Picker Ref: https://www.w3schools.com/colors/colors_picker.asp
+        uint8_t red, green, blue;  // rgb values, permissible values 0 - 255 (perceptual; gamma applied on output)
+    };                             //  Colour Picker Ref: https://www.w3schools.com/colors/colors_picker.asp
 
     // pre-define status notification colours
     StatusColour blue_BT_connected{0, 0, 255};
     StatusColour green_high_battery_charge{0, 255, 0};
-    StatusColour magenta_charge_battery_warning{255, 0, 255};  // used magenta as orange colour was not distinct
+    StatusColour orange_charge_battery_warning{255, 80, 0};  // distinct orange once gamma corrected (replaces magenta)
     StatusColour red_critically_low_battery{255, 0, 0};
-    StatusColour led_off{0, 0, 0};  // common cathode - current sourcing
-
-    // TODO: explore gamma corrections to RGB luminosity (due to different voltages) for acceptable orange to replace magenta
+    StatusColour led_off{0, 0, 0};  // dark for either polarity (see output())
 
     // method prototypes:
-    void setRgbColour(const RgbLed::StatusColour& statusColour);
+    void begin();
+    void setRgbColour(const StatusColour& statusColour);
+    void setBrightness(uint8_t percent);  // scales every colour's duty (battery saver); 100 = full
 
-    void ledBlink(const RgbLed::StatusColour& statusColour,
+    void ledBlink(const StatusColour& statusColour,
                   unsigned long blink_interval_msec);
 
-    void functionTest();
+    void ledBreathe(const StatusColour& statusColour,
+                    unsigned long breathe_period_msec);
+
+    void functionTest(unsigned long step_msec);  // starts non-blocking colour cycle
+    bool functionTestRunning();                  // advances it; call every pass
 
    private:
-    int _red_pin,
-        _green_pin,
-        _blue_pin;
+    enum ledPattern_t { SOLID,
+                        BLINK,
+                        BREATHE };
+
+    void startPattern(ledPattern_t pattern, const StatusColour& colour, unsigned long interval_msec);
+    void output(const StatusColour& colour, uint32_t fade_msec);
+    uint16_t duty(uint8_t value) const;
+
+    // what is currently displayed; pwm only touched when these change
+    ledPattern_t _pattern;
+    StatusColour _colour;
+    uint16_t _brightness;  // duty scale, 256 = full
+    unsigned long _interval_msec;
+    bool _phaseOn;                   // blink / breathe half cycle
+    unsigned long _nextToggle_msec;  // next blink / breathe phase change
+
+    int _testStep;  // function test colour index; -1 = not running
+    unsigned long _testStep_msec;
+    unsigned long _testStepStart_msec;
 };
 
-#endif  // end header guard
\ No newline at end of file
+typedef RgbLedT<Board> RgbLed;  // the LED on the board being built
+extern RgbLed rgbLed;  // instantiated in flipState.cpp
+
+#endif  // end header guard
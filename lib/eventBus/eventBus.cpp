@@ -0,0 +1,230 @@
+/*
+ * *************************************************************
+ * eventBus.cpp - implementation file for typed publish / subscribe event bus
+ *
+ *   Concurrency: pool slots are claimed and freed with atomic operations on
+ *   the _used mask (any publishing task may claim, the lane's dispatching
+ *   task frees).  A slot belongs to its publisher until its index is on a
+ *   lane, then to that lane's dispatcher.  Shared counters are relaxed
+ *   atomics; high water marks may miss a simultaneous update from the other
+ *   core.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include "eventBus.h"
+
+#include <string.h>
+
+#include "hal.h"  // halCycleCount()
+
+EventBus eventBus;
+
+static const char* const eventTypeName[EVENT_TYPE_COUNT] = {"gesture", "battery", "connection", "timer", "saver", "power"};
+
+// EventBus constructor
+EventBus::EventBus() : _used(0), _sequence(0) {
+    memset(_handler, 0, sizeof(_handler));
+    memset(_handlers, 0, sizeof(_handlers));
+    memset(_timer, 0, sizeof(_timer));
+    resetStats();
+}
+
+void EventBus::resetStats() {
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+const char* EventBus::typeName(eventType_t type) {
+    return (type < EVENT_TYPE_COUNT) ? eventTypeName[type] : "?";
+}
+
+bool EventBus::subscribe(eventType_t type, eventHandler_t handler) {
+    if ((type >= EVENT_TYPE_COUNT) || (_handlers[type] >= EVENT_MAX_SUBSCRIBERS)) {
+        return false;
+    }
+    _handler[type][_handlers[type]++] = handler;
+    return true;
+}
+
+// claims a free pool slot and stamps it; nullptr (drop counted) if the pool is exhausted
+busEvent_t* EventBus::allocate(eventType_t type, uint32_t now_msec) {
+    uint32_t used = __atomic_load_n(&_used, __ATOMIC_RELAXED);
+    for (;;) {
+        uint32_t free = ~used & ((EVENT_POOL_SIZE < 32) ? ((1UL << EVENT_POOL_SIZE) - 1) : 0xffffffffUL);
+        if (free == 0) {
+            __atomic_fetch_add(&_stats.type[type].dropped, 1, __ATOMIC_RELAXED);
+            return nullptr;
+        }
+        uint32_t claimed = used | (free & -free);  // lowest free slot
+        if (__atomic_compare_exchange_n(&_used, &used, claimed, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            uint8_t inUse = (uint8_t)__builtin_popcount(claimed);
+            if (inUse > _stats.poolHighWater) {
+                _stats.poolHighWater = inUse;
+            }
+            busEvent_t* event = &_pool[__builtin_ctz(free)];
+            event->type = type;
+            event->time_msec = now_msec;
+            event->sequence = __atomic_fetch_add(&_sequence, 1, __ATOMIC_RELAXED);
+            return event;
+        }
+        // lost the race with the other lane: used reloaded, try again
+    }
+}
+
+// queues a filled slot on the publisher's lane; frees it again if the lane is full
+bool EventBus::post(eventLane_t lane, busEvent_t* event) {
+    uint8_t slot = (uint8_t)(event - _pool);
+    if (!_lane[lane].push(slot)) {
+        __atomic_fetch_add(&_stats.type[event->type].dropped, 1, __ATOMIC_RELAXED);
+        release(slot);
+        return false;
+    }
+    __atomic_fetch_add(&_stats.type[event->type].published, 1, __ATOMIC_RELAXED);
+    uint16_t depth = _lane[lane].size();
+    if (depth > _stats.laneHighWater[lane]) {
+        _stats.laneHighWater[lane] = (uint8_t)depth;
+    }
+    return true;
+}
+
+void EventBus::release(uint8_t slot) {
+    __atomic_fetch_and(&_used, ~(1UL << slot), __ATOMIC_RELEASE);
+}
+
+bool EventBus::publish(eventLane_t lane, uint32_t now_msec, const gestureEvent_t& gesture) {
+    busEvent_t* event = allocate(EVENT_GESTURE, now_msec);
+    if (event == nullptr) {
+        return false;
+    }
+    event->gesture = gesture;
+    return post(lane, event);
+}
+
+bool EventBus::publish(eventLane_t lane, uint32_t now_msec, const batteryEvent_t& battery) {
+    busEvent_t* event = allocate(EVENT_BATTERY, now_msec);
+    if (event == nullptr) {
+        return false;
+    }
+    event->battery = battery;
+    return post(lane, event);
+}
+
+bool EventBus::publish(eventLane_t lane, uint32_t now_msec, const connectionEvent_t& connection) {
+    busEvent_t* event = allocate(EVENT_CONNECTION, now_msec);
+    if (event == nullptr) {
+        return false;
+    }
+    event->connection = connection;
+    return post(lane, event);
+}
+
+bool EventBus::publish(eventLane_t lane, uint32_t now_msec, const saverEvent_t& saver) {
+    busEvent_t* event = allocate(EVENT_SAVER_LEVEL, now_msec);
+    if (event == nullptr) {
+        return false;
+    }
+    event->saver = saver;
+    return post(lane, event);
+}
+
+bool EventBus::publish(eventLane_t lane, uint32_t now_msec, const powerModeEvent_t& power) {
+    busEvent_t* event = allocate(EVENT_POWER_MODE, now_msec);
+    if (event == nullptr) {
+        return false;
+    }
+    event->power = power;
+    return post(lane, event);
+}
+
+void EventBus::startTimer(uint8_t timer, uint32_t deadline_msec) {
+    if (timer < EVENT_MAX_TIMERS) {
+        _timer[timer].running = true;
+        _timer[timer].deadline_msec = deadline_msec;
+    }
+}
+
+void EventBus::stopTimer(uint8_t timer) {
+    if (timer < EVENT_MAX_TIMERS) {
+        _timer[timer].running = false;
+    }
+}
+
+// publishes an EVENT_TIMER for each timer whose deadline has passed; a timer that can't be published stays due
+void EventBus::pollTimers(eventLane_t lane, uint32_t now_msec) {
+    for (uint8_t t = 0; t < EVENT_MAX_TIMERS; t++) {
+        if (!_timer[t].running || ((int32_t)(now_msec - _timer[t].deadline_msec) < 0)) {
+            continue;
+        }
+        busEvent_t* event = allocate(EVENT_TIMER, now_msec);
+        if (event == nullptr) {
+            return;
+        }
+        event->timer.timer = t;
+        if (post(lane, event)) {
+            _timer[t].running = false;
+        }
+    }
+}
+
+bool EventBus::isEmpty(uint8_t lanes) const {
+    for (int lane = 0; lane < EVENT_LANE_COUNT; lane++) {
+        if ((lanes & (1 << lane)) && !_lane[lane].isEmpty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*****************************************************************************
+Description : Hands events queued on the caller's lanes to their subscribers,
+                oldest first across those lanes, and frees their pool slots.
+                Stops after maxEvents (events published by the handlers
+                themselves included) so a burst costs a bounded time per
+                call; the rest wait for the next.
+
+Input Value : lanes - EVENT_LANES_* set consumed by the calling task
+              maxEvents - bound for this call
+Return Value: events dispatched
+********************************************************************************/
+int EventBus::dispatch(uint8_t lanes, int maxEvents) {
+    int handled = 0;
+    for (; handled < maxEvents; handled++) {
+        int oldestLane = -1;
+        uint8_t oldestSlot = 0;
+        for (int lane = 0; lane < EVENT_LANE_COUNT; lane++) {
+            uint8_t slot;
+            if ((lanes & (1 << lane)) && _lane[lane].peek(slot) &&
+                ((oldestLane < 0) || ((int32_t)(_pool[slot].sequence - _pool[oldestSlot].sequence) < 0))) {
+                oldestLane = lane;
+                oldestSlot = slot;
+            }
+        }
+        if (oldestLane < 0) {
+            break;
+        }
+        _lane[oldestLane].pop(oldestSlot);
+
+        const busEvent_t& event = _pool[oldestSlot];
+        eventTypeStats_t& stats = _stats.type[event.type];
+        uint32_t start_cycles = halCycleCount();
+        for (int h = 0; h < _handlers[event.type]; h++) {
+            _handler[event.type][h](event);
+        }
+        uint32_t cycles = halCycleCount() - start_cycles;
+        stats.dispatched++;
+        stats.total_cycles += cycles;
+        if (cycles > stats.max_cycles) {
+            stats.max_cycles = cycles;
+        }
+        release(oldestSlot);
+    }
+    if (handled > _stats.maxBatch) {
+        _stats.maxBatch = (uint16_t)handled;
+    }
+    if ((handled == maxEvents) && !isEmpty(lanes)) {
+        __atomic_fetch_add(&_stats.deferred, 1, __ATOMIC_RELAXED);
+    }
+    return handled;
+}
@@ -6,222 +6,272 @@
  *  C W Greenstreet, Ver1, 10Dec23
  *    MIT Licence - Released into the public domain
  *
+ *  Ver2, 17Oct26: auto shut-down warning no longer blocks the caller;
+ *    states defined by a constexpr transition table (entry / tick / exit hooks, timeouts)
+ *
  * ************************************************************ */
 
-// set up debug scaffold; comment out following line if you want to "turn off" debugging to serial monitor
-#define DEBUG 1
+// module log level (see logger.h); raise with build_flags -D LOG_LEVEL_FLIPSTATE=LOG_LEVEL_DEBUG
+#define LOG_MODULE_LEVEL LOG_LEVEL_FLIPSTATE
 
 #include "flipState.h"
 
-#include <BleKeyboard.h>
-
-#include "controlRGB.h"   // rgb led control functions
-#include "esp_adc_cal.h"  // Espressif Analog to Digital Converter (ADC) Calibration Driver library
-#include "myConstants.h"  // all constants in one file + pinout table
+#include "batteryMonitor.h"  // cached, filtered battery voltage
+#include "controlRGB.h"      // rgb led control functions
+#include "hal.h"             // hardware abstraction: time, BLE keyboard, deep sleep
+#include "logger.h"          // deferred serial logging
+#include "myConstants.h"     // all constants in one file + pinout table
+#include "socEstimator.h"    // LiPo discharge curve -> battery %
+#include "traceRecorder.h"   // state transitions for field traces
 
-int current_battery_level = 100;  // initially set to fully charged, 100%
-
-BleKeyboard bleKeyboard("flipTurn", "CW Greenstreet", current_battery_level);
 // rgb led instantiation
-RgbLed rgbLed(RED_LED_PIN, GREEN_LED_PIN, BLUE_LED_PIN);
-
-const byte BLE_DELAY = 10;  // Delay (milliseconds) to prevent BT congestion
+RgbLed rgbLed;
+// battery monitor instantiation; samples slowly in the background, see batteryMonitor.update() in loop()
+BatteryMonitor batteryMonitor(adcBatteryRead_mV<Board>, BATTERY_SAMPLE_INTERVAL_MSEC, Board::BATTERY_DIVIDER_RATIO);
+// state of charge (%) reported to BT Central device
+SocEstimator socEstimator(SOC_HYSTERESIS_PERCENT);
 
-// entryStates is an enum variable type defined in menu.h header file (as extern); flipState is global
-entryStates_t flipState;
 
 /*****************************************************************************
-Description : Reads the battery voltage through the voltage divider at AO pin (FireBeetle-ESP32, DFR0478)
-*!             Must solder-bridge zero-ohm pads to enable voltage divider hardware (ref DFR0478 Ver3 schematic)
-
-              Uses eFuse calibrations, if present (ESP32-E), otherwise alternative characterisation used
-              In comparison with a regular voltmeter, ESP32 vs. multimeter values differ only ~0.05V
+Description : Returns the battery voltage published by the background battery monitor
+                (ADC characterised once at boot; GPIO36 / A0 sampled on a slow schedule
+                and EMA filtered - see batteryMonitor library).  O(1), safe to call every loop pass.
 Input Value : -
 Return Value: battery voltage in volts
----------------------------------
-Ref:  ADC1_CHANNEL_0 Enumeration
-https://docs.espressif.com/projects/esp-idf/en/v4.1.1/api-reference/peripherals/adc.html#_CPPv414ADC1_CHANNEL_0)
 ********************************************************************************/
 float readBattery() {
-    uint32_t value = 0;
-    int rounds = 11;
-    esp_adc_cal_characteristics_t adc_chars;
-
-    // battery voltage divided by 2 can be measured at GPIO36 / A0 pin (ADC1_CHANNEL0)
-    adc1_config_width(ADC_WIDTH_BIT_12);
-    adc1_config_channel_atten(ADC1_CHANNEL_0, ADC_ATTEN_DB_11);
-    switch (esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &adc_chars)) {
-        case ESP_ADC_CAL_VAL_EFUSE_TP:
-#ifdef DEBUG
-            // Serial.println("Characterized using Two Point Value");
-#endif
-            break;
-        case ESP_ADC_CAL_VAL_EFUSE_VREF:
-#ifdef DEBUG
-            // Serial.printf("Characterised using eFuse Vref (%d mV)\r\n", adc_chars.vref);
-#endif
-            break;
-        default:
-            Serial.printf("Characterised using Default Vref (%d mV)\r\n", 1100);
+    return batteryMonitor.voltage();
+}
+
+/*****************************************************************************
+Description : Tests for low battery charge (<=3V)
+
+Input Value : battery_voltage (volts)
+Return Value: true / false
+********************************************************************************/
+bool isBatteryLow(float battery_voltage) {
+    return battery_voltage <= LOW_BATTERY_VOLTAGE;
+}
+
+/*****************************************************************************
+Description : Updates BT Central device with (%) battery charge level, estimated
+                from the LiPo discharge curve.  Notifies only when the reported
+                percentage actually changes (see socEstimator hysteresis).
+                Call when the battery monitor has taken a new sample.
+
+Input Value : battery_mV - filtered battery voltage (millivolts)
+Return Value: -
+********************************************************************************/
+void updateBatteryLevel(uint32_t battery_mV) {
+    if (socEstimator.update(battery_mV)) {
+        halKeyboardSetBatteryLevel(socEstimator.percent());
+        LOG_INFO("Battery level %d%% (%lu mV) sent to central", socEstimator.percent(), (unsigned long)battery_mV);
     }
+}
 
-    // to avoid noise, sample the pin several times and average the result
-    for (int i = 1; i <= rounds; i++) {
-        value += adc1_get_raw(ADC1_CHANNEL_0);
+/******************************************************
+// State hooks: one clock / battery / BLE snapshot per tick (stateTick_t).
+//   onEntry and onTick return the next state, or no_transition to stay.
+******************************************************/
+struct stateTick_t {
+    unsigned long now_msec;
+    unsigned long inState_msec;  // time since entry to current state
+    float battery_voltage;       // in Volts
+    bool connected;              // BLE central connected
+};
+
+typedef entryStates_t (*stateHook_t)(const stateTick_t& tick);
+typedef void (*stateExitHook_t)(const stateTick_t& tick);
+
+static entryStates_t tickCheckConnection(const stateTick_t& tick) {
+    if (tick.connected) {
+        rgbLed.setRgbColour(rgbLed.blue_BT_connected);  // solid blue LED if connected
+    } else {
+        rgbLed.ledBlink(rgbLed.blue_BT_connected, 750);  // flash blue LED if no connection
     }
-    value /= (uint32_t)rounds;
+    return no_transition;
+}
+
+static entryStates_t enterHighBattery(const stateTick_t& tick) {
+    (void)tick;  // only read by LOG_INFO, compiled out below LOG_LEVEL_INFO
+    rgbLed.setRgbColour(rgbLed.green_high_battery_charge);
+    LOG_INFO("Battery charged: battery voltage above 3.7V (%d mV)", (int)(tick.battery_voltage * 1000));
+    return no_transition;
+}
 
-    // due to the voltage divider (1M+1M), multiply value by 2 and convert mV to V
-    return esp_adc_cal_raw_to_voltage(value, &adc_chars) * 2.0 / 1000.0;
+static entryStates_t enterChargeWarning(const stateTick_t& tick) {
+    (void)tick;  // only read by LOG_INFO, compiled out below LOG_LEVEL_INFO
+    rgbLed.setRgbColour(rgbLed.orange_charge_battery_warning);
+    LOG_INFO("Battery adequate: battery voltage 3.7 to 3.2V (%d mV)", (int)(tick.battery_voltage * 1000));
+    return no_transition;
+}
+
+static entryStates_t enterLowBattery(const stateTick_t& tick) {
+    (void)tick;  // only read by LOG_INFO, compiled out below LOG_LEVEL_INFO
+    LOG_INFO("Charge Battery NOW (%d mV)", (int)(tick.battery_voltage * 1000));
+    return no_transition;
+}
+
+static entryStates_t tickLowBattery(const stateTick_t&) {
+    rgbLed.ledBlink(rgbLed.red_critically_low_battery, 500);
+    return no_transition;
+}
+
+// transient: picks the battery colour state
+static entryStates_t enterBatteryStatus(const stateTick_t& tick) {
+    if (tick.battery_voltage >= HIGH_BATTERY_VOLTAGE) {
+        return high_battery_charge;
+    }
+    if (tick.battery_voltage >= CHARGE_NOW_VOLTAGE) {
+        return warning_charge_battery_now;
+    }
+    return low_battery;  // below LOW_BATTERY_VOLTAGE is caught by the shut-down override
 }
 
+// auto shut-down warning; once started it always ends in deep sleep
+static bool shutdownPending = false;
+static unsigned long shutdownStart_msec = 0;
+
+static entryStates_t enterShutDown(const stateTick_t& tick) {
+    if (!shutdownPending) {
+        shutdownPending = true;
+        shutdownStart_msec = tick.now_msec;
+        LOG_WARN("Battery critically low.  Auto-shutdown in %lu ms", (unsigned long)SHUTDOWN_WARNING_MSEC);
+    }
+    return no_transition;
+}
+
+// flash red warning for SHUTDOWN_WARNING_MSEC, one step per pass, then deep sleep
+static entryStates_t tickShutDown(const stateTick_t& tick) {
+    rgbLed.ledBlink(rgbLed.red_critically_low_battery, 250);
+    if ((tick.now_msec - shutdownStart_msec) > SHUTDOWN_WARNING_MSEC) {
+        LOG_WARN("Commencing auto-shutdown!  (%lu ms after boot)", tick.now_msec);
+        logger.flush();  // last chance to get the log out before deep sleep
+        //! ESP32 will only wake-up on restart (cycle power switch or manual press reset button)
+        halDeepSleep();
+    }
+    return no_transition;
+}
+
+/******************************************************
+// Transition / action table - one row per state, in enum order.
+//   timeout_msec 0 = no timeout
+******************************************************/
+struct stateDef_t {
+    entryStates_t state;
+    const char* name;
+    stateHook_t onEntry;
+    stateHook_t onTick;
+    stateExitHook_t onExit;
+    uint32_t timeout_msec;
+    entryStates_t onTimeout;
+};
+
+constexpr stateDef_t stateTable[] = {
+    // state                       name                   onEntry             onTick               onExit   timeout            onTimeout
+    {check_BT_connection,        "check_BT_connection", nullptr,            tickCheckConnection, nullptr, 0,                 no_transition},
+    {high_battery_charge,        "high_battery_charge", enterHighBattery,   nullptr,             nullptr, LED_DURATION_MSEC, check_BT_connection},
+    {warning_charge_battery_now, "charge_warning",      enterChargeWarning, nullptr,             nullptr, LED_DURATION_MSEC, check_BT_connection},
+    {low_battery,                "low_battery",         enterLowBattery,    tickLowBattery,      nullptr, LED_DURATION_MSEC, check_BT_connection},
+    {battery_status,             "battery_status",      enterBatteryStatus, nullptr,             nullptr, 0,                 no_transition},
+    {auto_shut_down,             "auto_shut_down",      enterShutDown,      tickShutDown,        nullptr, 0,                 no_transition},
+};
+
+// compile-time checks: one row per state, rows in enum order, timeouts lead somewhere
+constexpr bool stateTableValid(int i = 0) {
+    return (i >= FLIP_STATE_COUNT) ||
+           ((stateTable[i].state == i + 1) &&
+            ((stateTable[i].timeout_msec == 0) || (stateTable[i].onTimeout != no_transition)) &&
+            stateTableValid(i + 1));
+}
+static_assert(sizeof(stateTable) / sizeof(stateTable[0]) == FLIP_STATE_COUNT, "stateTable must have a row for every entryStates_t");
+static_assert(stateTableValid(), "stateTable rows must be in entryStates_t order; timed states need an onTimeout state");
+
+static entryStates_t currentState = no_transition;
+static entryStates_t requestedState = no_transition;  // see requestState()
+static unsigned long stateEntered_msec = 0;
+static uint8_t indication_percent = 100;  // timed state (LED indication) length scale, see setIndicationScale()
+
 /*****************************************************************************
-Description : Tests for low battery charge (<=3V) and update BT Central device
-                with (%) battery charge level
+Description : Scales the timeout of timed states - the battery colour shown
+                for LED_DURATION_MSEC - so a low battery spends less on the LED
 
-Input Value : battery_voltage (volts)
-Return Value: true / false
+Input Value : duration_percent - 100 = as in stateTable
+Return Value: -
 ********************************************************************************/
-bool isBatteryLow(uint32_t battery_voltage) {
-    static unsigned long updateTimer_msec = 0;
-
-    if (millis() - updateTimer_msec > 1000) {
-        bleKeyboard.setBatteryLevel(
-            battery_voltage >= HIGH_BATTERY_VOLTAGE ? 100 : 10 + 90 * (battery_voltage - LOW_BATTERY_VOLTAGE) / (HIGH_BATTERY_VOLTAGE - LOW_BATTERY_VOLTAGE));
-        delay(BLE_DELAY);
-        // Serial.printf("Battery: %d%%\n", 10 + 90 * (battery_voltage - LOW_BATTERY_VOLTAGE) / (HIGH_BATTERY_VOLTAGE - LOW_BATTERY_VOLTAGE));
-        updateTimer_msec = millis();
+void setIndicationScale(uint8_t duration_percent) {
+    indication_percent = duration_percent;
+}
+
+static const stateDef_t& stateDef(entryStates_t state) {
+    return stateTable[state - 1];
+}
+
+// exit current state / enter next, following entry hook redirects (bounded - no loops)
+static void transition(entryStates_t next, stateTick_t& tick) {
+    for (int hop = 0; (next != no_transition) && (hop < FLIP_STATE_COUNT); hop++) {
+        if ((currentState != no_transition) && (stateDef(currentState).onExit != nullptr)) {
+            stateDef(currentState).onExit(tick);
+        }
+        currentState = next;
+        stateEntered_msec = tick.now_msec;
+        tick.inState_msec = 0;
+        LOG_DEBUG("flipState -> %s", stateDef(next).name);
+        TRACE_RECORD(TRACE_STATE, halMicros(), next);
+
+        const stateDef_t& def = stateDef(next);
+        next = (def.onEntry != nullptr) ? def.onEntry(tick) : no_transition;
     }
+}
 
-    return battery_voltage <= LOW_BATTERY_VOLTAGE ? true : false;
+/*****************************************************************************
+Description : Asks for a state (eg battery_status on a long press), entered on
+                the next processState() unless it is already the current state.
+                Call from the task that runs processState(), or before it starts.
+
+Input Value : state
+Return Value: -
+********************************************************************************/
+void requestState(entryStates_t state) {
+    if ((state > no_transition) && (state < entry_states_end)) {
+        requestedState = state;
+    }
 }
 
 /*****************************************************************************
-Description : state machine, primarily to process status LED states
+Description : state machine, primarily to process status LED states.  Takes one
+                time / battery / connection snapshot, applies any requested state
+                (see requestState()), then runs the current state's timeout or
+                tick hook from stateTable.
 
 Input Value : -
 Return Value: -
 *******************************************************************************/
 void processState() {
-    float battery_voltage = readBattery();  // in Volts
+    stateTick_t tick;
+    tick.now_msec = halMillis();
+    tick.battery_voltage = readBattery();
+    tick.connected = halKeyboardIsConnected();
 
     // battery_voltage = 3.8;               // !debug test line
 
-    //! code over-ride to auto shut-down if battery is critically low (<3V)
-    if (battery_voltage < LOW_BATTERY_VOLTAGE) {
-        flipState = auto_shut_down;
+    entryStates_t next = no_transition;
+    if ((tick.battery_voltage < LOW_BATTERY_VOLTAGE) && (currentState != auto_shut_down)) {
+        next = auto_shut_down;  //! over-ride to auto shut-down if battery is critically low (<3V)
+    } else if ((requestedState != no_transition) && (requestedState != currentState)) {
+        next = requestedState;  // requested by caller (eg long press -> battery_status)
+    } else if (currentState == no_transition) {
+        next = check_BT_connection;  // first pass
     }
-
-    switch (flipState) {
-        case check_BT_connection:
-            if (bleKeyboard.isConnected()) {
-                if (!hasRun) {  // prints message to serial monitor once only
-                    Serial.println("Entered flipState : check_BT_connection");
-                    Serial.println("flipTurn BLE Device connected!");
-                    hasRun = 1;  // toggle flag to run connection notification only once
-                }
-                rgbLed.setRgbColour(rgbLed.blue_BT_connected);  // solid blue LED if connected
-            } else {
-                rgbLed.ledBlink(rgbLed.blue_BT_connected, 750);  // flash blue LED if no connection
-            }
-            break;
-
-        case high_battery_charge:
-            if ((millis() - ledTimer_msec) <= LED_DURATION_MSEC) {
-                rgbLed.setRgbColour(rgbLed.green_high_battery_charge);
-            }
-            if ((millis() - ledTimer_msec) > LED_DURATION_MSEC) {
-                Serial.println(F("Battery charged: battery voltage above 3.7V"));
-                flipState = check_BT_connection;
-#ifdef DEBUG
-                Serial.println();
-                Serial.println("--------------------------");
-                Serial.print("flipState high battery charge; battery voltage = ");
-                Serial.println(battery_voltage);
-                Serial.println("--------------------------");
-#endif
-            }
-            break;
-
-        case warning_charge_battery_now:
-            if ((millis() - ledTimer_msec) <= LED_DURATION_MSEC) {
-                rgbLed.setRgbColour(rgbLed.magenta_charge_battery_warning);
-            }
-            if ((millis() - ledTimer_msec) > LED_DURATION_MSEC) {
-                Serial.println(F("Battery adequate: battery voltage 3.7 to 3.2V"));
-                flipState = check_BT_connection;
-#ifdef DEBUG
-                Serial.println();
-                Serial.println("--------------------------");
-                Serial.print("flipState warning battery charge; battery voltage = ");
-                Serial.println(battery_voltage);
-                Serial.println("--------------------------");
-#endif
-            }
-            break;
-
-        case low_battery:
-            if ((millis() - ledTimer_msec) <= LED_DURATION_MSEC) {
-                rgbLed.ledBlink(rgbLed.red_critically_low_battery, 500);
-            }
-            if ((millis() - ledTimer_msec) > LED_DURATION_MSEC) {
-                Serial.println(F("Charge Battery NOW"));
-                flipState = check_BT_connection;
-#ifdef DEBUG
-                Serial.println();
-                Serial.println("--------------------------");
-                Serial.print("flipState low battery charge; battery voltage = ");
-                Serial.println(battery_voltage);
-                Serial.println("--------------------------");
-#endif
-            }
-            break;
-
-        case battery_status:
-            if (battery_voltage >= HIGH_BATTERY_VOLTAGE) {
-                flipState = high_battery_charge;
-                Serial.println(F("Battery status case: Battery charge high"));
-
-            } else if ((battery_voltage >= CHARGE_NOW_VOLTAGE) && (battery_voltage < HIGH_BATTERY_VOLTAGE)) {
-                flipState = warning_charge_battery_now;
-                Serial.println(F("Battery status case: Battery adequate - battery voltage 3.7 to 3.2V"));
-
-            } else if ((battery_voltage >= LOW_BATTERY_VOLTAGE) && (battery_voltage < CHARGE_NOW_VOLTAGE)) {
-                flipState = low_battery;
-                Serial.println(F("Battery status case: Battery charge low.  Charge battery now!"));
-            }
-            break;
-
-        case auto_shut_down:
-            ledTimer_msec = millis();
-            do {
-                rgbLed.ledBlink(rgbLed.red_critically_low_battery, 250);
-
-            } while (((millis() - ledTimer_msec) <= 10000));  //? flash red warning for 10 sec before shutdown
-            Serial.println(F("Battery critically low.  Commencing auto-shutdown!"));
-            // trigger auto shut-down (deep sleep) ref: https://esp32.com/viewtopic.php?t=5624
-            //! ESP32 will only wake-up on restart (cycle power switch or manual press reset button)
-            esp_deep_sleep_start();
-            break;
-
-        default:
-            flipState = check_BT_connection;
-            Serial.println(F("processState() default switch-case triggered; check for code bug!"));
-            break;
+    requestedState = no_transition;
+    transition(next, tick);
+
+    const stateDef_t& def = stateDef(currentState);
+    tick.inState_msec = tick.now_msec - stateEntered_msec;
+    if ((def.timeout_msec != 0) && (tick.inState_msec > def.timeout_msec * indication_percent / 100)) {
+        next = def.onTimeout;
+    } else {
+        next = (def.onTick != nullptr) ? def.onTick(tick) : no_transition;
     }
+    transition(next, tick);
 }
-
-//*  ************** not used *******************
-
-/*****************************************************************************
-Description : calculates battery level (percentage) and updates BT Central device
-
-Input Value : battery voltage (in Volts)
-Return Value: -
-*******************************************************************************
-int setBatteryLevel(float battery_voltage) {
-    // do something
-    bleKeyboard.setBatteryLevel(current_battery_level);  // update battery level
-    {
-        // batteryAvg - LOW_VOLTAGE) / (HI_VOLTAGE - LOW_VOLTAGE)
-*/
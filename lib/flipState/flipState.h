@@ -6,6 +6,10 @@
  *  C W Greenstreet, Ver1, 10Dec23
  *    MIT Licence - Released into the public domain
  *
+ *  Ver2, 17Oct26: compile-time transition table with entry / tick / exit hooks
+ *    and per-state timeouts replaces the processState() switch; states are
+ *    requested with requestState() rather than by writing a global flipState
+ *
  * ************************************************************ */
 
 #ifndef FLIP_STATE_H  // begin header guard
@@ -19,37 +23,27 @@
 #include <pins_arduino.h>
 #endif  // end if-block
 
-// required in header file as BLEKeyboard object referred to as extern; otherwise compiler error
-#include <BleKeyboard.h>  
-
-
-
-// declare case names for flipTurn State Machine switch-case stucture
-enum entryStates_t { check_BT_connection = 1,  // set enum 1 to 10 rather than default 0 for first element
+// declare state names for flipTurn State Machine (see stateTable in flipState.cpp)
+enum entryStates_t { no_transition = 0,        // hook return value: stay in current state
+                     check_BT_connection = 1,  // set enum 1 to 10 rather than default 0 for first element
                      high_battery_charge,
                      warning_charge_battery_now,
                      low_battery,
                      battery_status,
-                     auto_shut_down };  // 6
-
-// make flipState global (visible everywhere)
-extern entryStates_t flipState;  
-
-extern BleKeyboard bleKeyboard; 
-
-//timer - declared as global in flipTurn-main.cpp
-extern unsigned long ledTimer_msec;
+                     auto_shut_down,     // 6
+                     entry_states_end };  // sentinel - keep last; new states go above
 
-// run-once flag
-extern bool hasRun;
+constexpr int FLIP_STATE_COUNT = entry_states_end - 1;
 
 /******************************************************
 // Function prototypes:
 ******************************************************/
 void processState();
+void requestState(entryStates_t state);  // transition on the next processState(); call from its task (or set-up)
 float readBattery();
-bool isBatteryLow(uint32_t battery_voltage);
-// int setBatteryLevel(float battery_voltage);  //* not used
+bool isBatteryLow(float battery_voltage);
+void updateBatteryLevel(uint32_t battery_mV);
+void setIndicationScale(uint8_t duration_percent);  // battery saver: shortens timed LED indications
 
 
 
@@ -0,0 +1,154 @@
+/*
+ * *************************************************************
+ * hal.h - Header file for thin flipTurn hardware abstraction layer (HAL)
+ *
+ *   All time, GPIO, LED, power and BLE keyboard access from the flipTurn
+ *   libraries goes through these functions.  Two backends:
+ *     hal_esp32.cpp  - FireBeetle ESP32 (Arduino framework, ARDUINO defined)
+ *     hal_native.cpp - Linux host; deterministic virtual clock, fake GPIO / LED,
+ *                      stub BLE keyboard recording timestamped HID reports
+ *   (fake ADC backend lives with the battery monitor, see batteryAdc.cpp)
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef HAL_H  // begin header guard
+#define HAL_H
+
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <esp_attr.h>  // IRAM_ATTR for interrupt service routines
+#else
+#define IRAM_ATTR
+#endif
+
+// keys flipTurn sends; mapped to BleKeyboard key codes / media reports by the ESP32 backend
+enum halKey_t { HAL_KEY_DOWN_ARROW,
+                HAL_KEY_UP_ARROW,
+                HAL_KEY_MEDIA_EJECT };  // toggles visibility of IOS virtual on-screen keyboard
+
+/******************************************************
+// Function prototypes:
+******************************************************/
+// time
+unsigned long halMillis();
+uint32_t halMicros();
+void halDelay(unsigned long msec);  // blocking; keep off the page turn path
+int halCoreId();                    // CPU core the caller runs on (0 or 1)
+uint32_t halCycleCount();           // CPU clock cycle counter of the calling core (wraps)
+
+// FreeRTOS tick hook + backtrace (stall watchdog); hook runs in the tick ISR of each core, must be IRAM
+bool halAttachTickHook(void (*hook)());  // false if unsupported
+int halInterruptedBacktrace(uint32_t* pcs, int depth, char* task, int taskBytes);  // from a tick hook: PCs of the code it interrupted
+
+// memory
+uint32_t halHeapFree();     // bytes free now
+uint32_t halHeapMinFree();  // low-water mark since boot
+
+// GPIO
+void halPinModeInputPullup(int pin);
+void halPinModeInput(int pin);  // external pull-up fitted (eg GPIO 34-39)
+void halPinModeOutput(int pin);
+bool halDigitalRead(int pin);
+uint64_t halReadInputs();  // all GPIO input levels in one read, bit n = GPIO n
+void halAttachChangeInterrupt(int pin, void (*isr)());  // isr called on both edges
+
+// serial monitor output (non-blocking use: never write more than halSerialWritable())
+int halSerialWritable();
+void halSerialWrite(const char* data, int length);
+
+// RGB LED pwm - ESP32 LEDC, 10 bit duty (0 - 1023)
+void halLedAttach(int channel, int pin);
+void halLedFade(int channel, uint16_t duty, uint32_t fade_msec);  // fade_msec 0 = set immediately
+
+// power
+constexpr int HAL_RETAINED_BYTES = 64;  // RTC slow memory kept through deep sleep (not power-on)
+constexpr int HAL_NOINIT_BYTES = 64;    // RTC slow memory kept through deep sleep and any reset (not power-on)
+
+void halDeepSleep();                    // wakes only on reset / power cycle
+bool halCanWakeOnPin(int pin);          // pin usable as deep sleep (ext0) wake source
+bool halDeepSleepWakeOnPin(int pin);    // deep sleep until pin goes LOW; returns false (awake) if pin can't wake
+bool halWokeFromDeepSleep();            // this boot is a deep sleep wake, retained memory valid
+uint8_t* halRetainedMemory();           // HAL_RETAINED_BYTES
+uint8_t* halNoInitMemory();             // HAL_NOINIT_BYTES; garbage after power-on
+bool halPowerBegin(int maxMhz, int minMhz, int wakePin);  // dynamic frequency + light sleep; false if unsupported
+void halPowerSetMode(bool fullSpeed, bool lightSleep);     // lightSleep arms wake on wakePin going LOW
+bool halPowerSetMaxMhz(int maxMhz);                        // full speed clock (battery saver); false if unsupported
+
+// flash storage (NVS); blocking - keep off the page turn path
+bool halStoreBlob(const char* key, const void* data, int length);
+int halLoadBlob(const char* key, void* data, int capacity);  // bytes read, 0 if missing or larger than capacity
+
+// BLE keyboard
+void halKeyboardBegin();
+bool halKeyboardIsConnected();
+void halKeyboardWrite(halKey_t key);                     // press + release back to back, unpaced
+bool halKeyboardSendReport(halKey_t key, bool pressed);  // one press or release notification; false if the stack refused it
+                                                         //   (ESP32: no free buffer only - later drops show as missing completions)
+int halBleSendCredits();                                 // notifications the stack can take now; -1 if unknown
+uint32_t halBleTakeCompletions();                        // notifications the stack finished since the last call
+void halKeyboardReleaseAll();                            // forget held keys (library report state); sent only if connected
+void halKeyboardSetBatteryLevel(uint8_t level);
+
+// BLE connection parameters (interval x 1.25 ms, timeout x 10 ms)
+struct halConnParamsReport_t {
+    unsigned long time_msec;  // when the stack reported the update
+    bool ok;
+    uint16_t interval;  // negotiated by the central
+    uint16_t latency;
+    uint16_t timeout;
+};
+bool halBleUpdateConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout);
+bool halBleTakeConnParamsReport(halConnParamsReport_t& report);  // true once per negotiated update
+
+// BLE advertising (interval x 0.625 ms); directed = high duty cycle to the last bonded central
+bool halBleBondedHostKnown();  // last bonded central cached in NVS and still bonded; valid after halKeyboardBegin()
+bool halBleAdvertise(bool directed, uint16_t minInterval, uint16_t maxInterval);
+
+#ifndef ARDUINO
+/******************************************************
+// Host simulator controls (hal_native.cpp only)
+******************************************************/
+struct simHidReport_t {
+    uint32_t time_usec;  // virtual time the key left halKeyboardWrite() / halKeyboardSendReport() (press)
+    halKey_t key;
+};
+
+constexpr int SIM_MAX_PINS = 40;           // ESP32 GPIO count
+constexpr int SIM_MAX_HID_REPORTS = 1024;  // report log capacity; oldest reports kept, later ones dropped
+constexpr int SIM_MAX_BLOBS = 4;           // halStoreBlob() keys
+constexpr int SIM_BLOB_BYTES = 16384;
+constexpr uint32_t SIM_LINK_INTERVAL_USEC = 15000;  // until halBleUpdateConnParams() sets one
+constexpr int SIM_LINK_REPORTS_PER_EVENT = 4;       // notifications per connection event
+constexpr int SIM_LINK_BUFFERS = 10;                // stack buffers (halBleSendCredits when empty)
+
+void simReset();                     // virtual clock to zero, pins high (pull-ups), log cleared
+void simAdvanceUsec(uint32_t usec);  // advance virtual clock; tick hook called at each whole msec
+void simAdvanceMsec(unsigned long msec);
+uint64_t simNow_usec();  // virtual clock, not wrapped
+void simSetPin(int pin, bool level);  // drive an input, eg foot switch edge (LOW = pressed); fires attached isr
+void simSetConnected(bool connected);
+void simSetLink(uint32_t interval_usec, int reportsPerEvent, int buffers);  // notification delivery; interval also set by halBleUpdateConnParams()
+void simSetBondedHost(bool known);
+bool simAdvertisingDirected();
+uint16_t simAdvertisingInterval();  // 0 = not advertising (connected)
+uint32_t simLinkInterval_usec();  // connection interval the link model delivers at
+uint16_t simLinkLatency();  // slave latency last negotiated by halBleUpdateConnParams()
+int simLinkQueued();  // notifications waiting for a connection event
+int simLedValue(int pin);  // target pwm duty of the LEDC channel attached to an LED pin
+bool simInDeepSleep();
+void simSetWokeFromDeepSleep(bool woke);  // next halWokeFromDeepSleep(); retained memory survives simReset()
+bool simPowerFullSpeed();
+bool simPowerLightSleep();
+int simPowerMaxMhz();
+int simPowerMinMhz();  // clock when not at full speed (halPowerBegin minMhz)
+uint8_t simKeysHeld();  // bit per halKey_t the keyboard still reports as down
+uint8_t simBatteryLevel();
+int simHidReportCount();
+const simHidReport_t& simHidReport(int index);
+#endif  // ARDUINO
+
+#endif  // end header guard
@@ -0,0 +1,613 @@
+/*
+ * *************************************************************
+ * hal_esp32.cpp - FireBeetle ESP32 backend for the flipTurn HAL
+ *
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifdef ARDUINO
+
+#include "hal.h"
+
+#include <Arduino.h>
+#include <BLEDevice.h>
+#include <BleKeyboard.h>
+#include <Preferences.h>
+#include <driver/gpio.h>
+#include <driver/ledc.h>
+#include <driver/rtc_io.h>
+#include <esp_debug_helpers.h>
+#include <esp_freertos_hooks.h>
+#include <esp_gap_ble_api.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <freertos/xtensa_context.h>
+#include <soc/cpu.h>
+#include <soc/gpio_struct.h>
+
+// battery level until the first halKeyboardSetBatteryLevel() (fully charged, 100%)
+BleKeyboard bleKeyboard("flipTurn", "CW Greenstreet", 100);
+
+// connected central's address + connection id (BleKeyboard does not expose them); written from the BLE stack task
+static esp_bd_addr_t peerAddress;
+static volatile uint16_t peerConnId = 0;
+static volatile bool peerKnown = false;
+
+// HID report notifications the stack has finished with (ESP_GATTS_CONF_EVT on a report
+//   characteristic - battery level notifications are not counted); read as a delta by halBleTakeCompletions()
+static volatile uint32_t notifyCompletions = 0;
+static uint32_t completionsTaken = 0;
+
+// attribute handles of the HID report characteristics, seen as BleKeyboard::begin() adds them
+constexpr int MAX_HID_REPORT_HANDLES = 4;  // keyboard input, output (LEDs), media keys input
+static uint16_t hidReportHandle[MAX_HID_REPORT_HANDLES];
+static int hidReportHandles = 0;
+
+static bool isHidReportHandle(uint16_t handle) {
+    for (int i = 0; i < hidReportHandles; i++) {
+        if (hidReportHandle[i] == handle) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// latest connection parameter update reported by the stack; picked up by halBleTakeConnParamsReport()
+static halConnParamsReport_t connReport;
+static volatile bool connReportPending = false;
+
+static void onGattsEvent(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t* param) {
+    switch (event) {
+        case ESP_GATTS_CONNECT_EVT:
+            memcpy(peerAddress, param->connect.remote_bda, sizeof(esp_bd_addr_t));
+            peerConnId = param->connect.conn_id;
+            peerKnown = true;
+            break;
+        case ESP_GATTS_ADD_CHAR_EVT:
+            if ((param->add_char.status == ESP_GATT_OK) && (param->add_char.char_uuid.len == ESP_UUID_LEN_16) &&
+                (param->add_char.char_uuid.uuid.uuid16 == ESP_GATT_UUID_HID_REPORT) &&
+                (hidReportHandles < MAX_HID_REPORT_HANDLES)) {
+                hidReportHandle[hidReportHandles++] = param->add_char.attr_handle;
+            }
+            break;
+        case ESP_GATTS_CONF_EVT:  // also raised for notifications once sent
+            if (peerKnown && (param->conf.conn_id == peerConnId) && isHidReportHandle(param->conf.handle)) {
+                notifyCompletions++;
+            }
+            break;
+        case ESP_GATTS_DISCONNECT_EVT:
+            peerKnown = false;
+            break;
+        default:
+            break;
+    }
+}
+
+// last bonded central, cached in NVS so the next boot can direct advertising at it
+struct bondedHost_t {
+    esp_bd_addr_t address;
+    esp_ble_addr_type_t type;
+};
+static const char NVS_NAMESPACE[] = "flipTurn";
+static const char NVS_BONDED_HOST_KEY[] = "bondedHost";
+RTC_DATA_ATTR static bondedHost_t bondedHost;  // retained through auto-off: wake skips NVS + bond list
+RTC_DATA_ATTR static bool bondedHostKnown = false;
+
+// called from the BLE stack task once pairing / re-encryption completes; NVS only written on change
+static void cacheBondedHost(const esp_bd_addr_t address, esp_ble_addr_type_t type) {
+    if (bondedHostKnown && (memcmp(bondedHost.address, address, sizeof(esp_bd_addr_t)) == 0) && (bondedHost.type == type)) {
+        return;
+    }
+    memcpy(bondedHost.address, address, sizeof(esp_bd_addr_t));
+    bondedHost.type = type;
+    bondedHostKnown = true;
+
+    Preferences prefs;
+    prefs.begin(NVS_NAMESPACE, false);
+    prefs.putBytes(NVS_BONDED_HOST_KEY, &bondedHost, sizeof(bondedHost));
+    prefs.end();
+}
+
+// loads the cached central; ignored if the bond has since been removed. Needs Bluedroid running.
+static void loadBondedHost() {
+    if (halWokeFromDeepSleep() && bondedHostKnown) {
+        return;  // still valid in RTC memory
+    }
+    bondedHostKnown = false;
+
+    Preferences prefs;
+    prefs.begin(NVS_NAMESPACE, true);
+    bool found = (prefs.getBytes(NVS_BONDED_HOST_KEY, &bondedHost, sizeof(bondedHost)) == sizeof(bondedHost));
+    prefs.end();
+    if (!found) {
+        return;
+    }
+
+    int count = esp_ble_get_bond_device_num();
+    if (count <= 0) {
+        return;
+    }
+    esp_ble_bond_dev_t* bonds = (esp_ble_bond_dev_t*)malloc(sizeof(esp_ble_bond_dev_t) * count);  // boot only
+    if ((bonds != nullptr) && (esp_ble_get_bond_device_list(&count, bonds) == ESP_OK)) {
+        for (int i = 0; i < count; i++) {
+            if (memcmp(bonds[i].bd_addr, bondedHost.address, sizeof(esp_bd_addr_t)) == 0) {
+                bondedHostKnown = true;
+            }
+        }
+    }
+    free(bonds);
+}
+
+static void onGapEvent(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param) {
+    switch (event) {
+        case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
+            connReport.time_msec = millis();
+            connReport.ok = (param->update_conn_params.status == ESP_BT_STATUS_SUCCESS);
+            connReport.interval = param->update_conn_params.conn_int;
+            connReport.latency = param->update_conn_params.latency;
+            connReport.timeout = param->update_conn_params.timeout;
+            connReportPending = true;
+            break;
+        case ESP_GAP_BLE_AUTH_CMPL_EVT:
+            if (param->ble_security.auth_cmpl.success) {
+                cacheBondedHost(param->ble_security.auth_cmpl.bd_addr, param->ble_security.auth_cmpl.addr_type);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// ------------------------- time -------------------------
+// IRAM - called from the stall watchdog tick hook
+unsigned long IRAM_ATTR halMillis() {
+    return millis();
+}
+
+// IRAM - called from the foot switch ISR
+uint32_t IRAM_ATTR halMicros() {
+    return micros();
+}
+
+void halDelay(unsigned long msec) {
+    delay(msec);
+}
+
+// IRAM - called from the stall watchdog tick hook
+int IRAM_ATTR halCoreId() {
+    return xPortGetCoreID();
+}
+
+uint32_t halCycleCount() {
+    return ESP.getCycleCount();  // CCOUNT register; counts at the current (scaled) CPU clock
+}
+
+bool halAttachTickHook(void (*hook)()) {
+    return (esp_register_freertos_tick_hook_for_cpu(hook, 0) == ESP_OK) &&
+           (esp_register_freertos_tick_hook_for_cpu(hook, 1) == ESP_OK);
+}
+
+/*****************************************************************************
+Description : Backtrace of the task a tick hook interrupted.  On (outermost)
+                interrupt entry the port saves the task's exception frame on its
+                stack and points the TCB's first member, pxTopOfStack, at it;
+                the walk starts from that frame.  Decode the PCs with
+                xtensa-esp32-elf-addr2line -e firmware.elf
+
+Input Value : pcs, depth - room for depth PCs, task, taskBytes - task name out
+Return Value: PCs stored (innermost first)
+********************************************************************************/
+int IRAM_ATTR halInterruptedBacktrace(uint32_t* pcs, int depth, char* task, int taskBytes) {
+    TaskHandle_t current = xTaskGetCurrentTaskHandleForCPU(xPortGetCoreID());
+    if ((current == nullptr) || (depth <= 0) || (taskBytes <= 0)) {
+        return 0;
+    }
+    strncpy(task, pcTaskGetTaskName(current), taskBytes - 1);
+    task[taskBytes - 1] = 0;
+
+    const XtExcFrame* frame = *(XtExcFrame* const*)current;
+    esp_backtrace_frame_t walk = {};
+    walk.pc = frame->pc;
+    walk.sp = frame->a1;
+    walk.next_pc = frame->a0;
+    int count = 0;
+    pcs[count++] = esp_cpu_process_stack_pc(walk.pc);
+    while ((count < depth) && (walk.next_pc != 0) && esp_backtrace_get_next_frame(&walk)) {
+        pcs[count++] = esp_cpu_process_stack_pc(walk.pc);
+    }
+    return count;
+}
+
+uint32_t halHeapFree() {
+    return ESP.getFreeHeap();
+}
+
+uint32_t halHeapMinFree() {
+    return ESP.getMinFreeHeap();
+}
+
+// ------------------------- GPIO -------------------------
+void halPinModeInputPullup(int pin) {
+    if (rtc_gpio_is_valid_gpio((gpio_num_t)pin)) {
+        rtc_gpio_deinit((gpio_num_t)pin);  // back to the digital pad after an ext0 deep sleep wake
+    }
+    pinMode(pin, INPUT_PULLUP);
+}
+
+void halPinModeInput(int pin) {
+    if (rtc_gpio_is_valid_gpio((gpio_num_t)pin)) {
+        rtc_gpio_deinit((gpio_num_t)pin);
+    }
+    pinMode(pin, INPUT);
+}
+
+void halPinModeOutput(int pin) {
+    pinMode(pin, OUTPUT);
+}
+
+// IRAM - called from the foot switch ISR
+bool IRAM_ATTR halDigitalRead(int pin) {
+    return digitalRead(pin);
+}
+
+// IRAM - called from the pedal ISR; GPIO 0-31 and 32-39 input registers
+uint64_t IRAM_ATTR halReadInputs() {
+    return ((uint64_t)GPIO.in1.val << 32) | GPIO.in;
+}
+
+// light sleep wake pin: LOW level interrupt while armed, restored to CHANGE by the first interrupt
+static int lightSleepWakePin = -1;
+static volatile bool wakeArmed = false;
+static void (*pinIsr[GPIO_PIN_COUNT])();
+
+static void IRAM_ATTR onPinChange(void* arg) {
+    int pin = (int)(intptr_t)arg;
+    if (wakeArmed && (pin == lightSleepWakePin)) {
+        GPIO.pin[pin].int_type = GPIO_INTR_ANYEDGE;  // register writes only - ISR safe
+        GPIO.pin[pin].wakeup_enable = 0;
+        wakeArmed = false;
+    }
+    pinIsr[pin]();
+}
+
+void halAttachChangeInterrupt(int pin, void (*isr)()) {
+    pinIsr[pin] = isr;
+    attachInterruptArg(digitalPinToInterrupt(pin), onPinChange, (void*)(intptr_t)pin, CHANGE);
+}
+
+// ------------------------- serial -------------------------
+int halSerialWritable() {
+    return Serial.availableForWrite();
+}
+
+void halSerialWrite(const char* data, int length) {
+    Serial.write((const uint8_t*)data, length);
+}
+
+// ------------------------- LEDC pwm -------------------------
+constexpr uint32_t LED_PWM_FREQ_HZ = 5000;
+static bool ledcReady = false;
+
+void halLedAttach(int channel, int pin) {
+    if (!ledcReady) {
+        // low speed mode on the RTC8M clock: keeps running through automatic light sleep
+        ledc_timer_config_t timer = {};
+        timer.speed_mode = LEDC_LOW_SPEED_MODE;
+        timer.duty_resolution = LEDC_TIMER_10_BIT;
+        timer.timer_num = LEDC_TIMER_0;
+        timer.freq_hz = LED_PWM_FREQ_HZ;
+        timer.clk_cfg = LEDC_USE_RTC8M_CLK;
+        ledc_timer_config(&timer);
+        ledc_fade_func_install(0);  // hardware fade engine (blink / breathe without CPU)
+        ledcReady = true;
+    }
+    ledc_channel_config_t config = {};
+    config.gpio_num = pin;
+    config.speed_mode = LEDC_LOW_SPEED_MODE;
+    config.channel = (ledc_channel_t)channel;
+    config.timer_sel = LEDC_TIMER_0;
+    config.duty = 0;
+    config.hpoint = 0;
+    ledc_channel_config(&config);
+}
+
+void halLedFade(int channel, uint16_t duty, uint32_t fade_msec) {
+    if (fade_msec == 0) {
+        ledc_set_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)channel, duty);
+        ledc_update_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)channel);
+    } else {
+        ledc_set_fade_with_time(LEDC_LOW_SPEED_MODE, (ledc_channel_t)channel, duty, fade_msec);
+        ledc_fade_start(LEDC_LOW_SPEED_MODE, (ledc_channel_t)channel, LEDC_FADE_NO_WAIT);
+    }
+}
+
+// ------------------------- power -------------------------
+void halDeepSleep() {
+    // trigger auto shut-down (deep sleep) ref: https://esp32.com/viewtopic.php?t=5624
+    esp_deep_sleep_start();
+}
+
+RTC_DATA_ATTR static uint8_t retainedMemory[HAL_RETAINED_BYTES];
+RTC_NOINIT_ATTR static uint8_t noInitMemory[HAL_NOINIT_BYTES];  // not reloaded by the bootloader on reset
+
+bool halCanWakeOnPin(int pin) {
+    return rtc_gpio_is_valid_gpio((gpio_num_t)pin);
+}
+
+/*****************************************************************************
+Description : Deep sleep with ext0 wake when the foot switch closes (LOW).
+                The RTC pull-up holds the pin high while the digital pad is off.
+
+Input Value : pin - must be an RTC GPIO (0, 2, 4, 12 - 15, 25 - 27, 32 - 39)
+Return Value: false if the pin can't wake the chip (does not sleep)
+********************************************************************************/
+bool halDeepSleepWakeOnPin(int pin) {
+    if (!halCanWakeOnPin(pin)) {
+        return false;
+    }
+    rtc_gpio_pullup_en((gpio_num_t)pin);
+    rtc_gpio_pulldown_dis((gpio_num_t)pin);
+    esp_sleep_enable_ext0_wakeup((gpio_num_t)pin, 0);
+    esp_deep_sleep_start();
+    return true;  // not reached
+}
+
+bool halWokeFromDeepSleep() {
+    return esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_UNDEFINED;
+}
+
+uint8_t* halRetainedMemory() {
+    return retainedMemory;
+}
+
+uint8_t* halNoInitMemory() {
+    return noInitMemory;
+}
+
+static esp_pm_lock_handle_t fullSpeedLock;  // ESP_PM_CPU_FREQ_MAX
+static esp_pm_lock_handle_t awakeLock;      // ESP_PM_NO_LIGHT_SLEEP
+static bool pmReady = false;
+static bool pmFullSpeed = false;
+static bool pmAwake = false;
+static int pmMinMhz = 80;
+
+/*****************************************************************************
+Description : Enables ESP-IDF power management: CPU clock scaled between minMhz
+                and maxMhz by lock, automatic light sleep from the idle task
+                (needs CONFIG_PM_ENABLE + CONFIG_FREERTOS_USE_TICKLESS_IDLE in the
+                framework build).  RTC8M stays powered so the LEDC (RTC8M clocked)
+                keeps driving the status LED while asleep.
+
+Input Value : maxMhz, minMhz (>= 80 for BLE), wakePin - foot switch
+Return Value: false if power management is not available (full clock, no sleep)
+********************************************************************************/
+#if CONFIG_PM_ENABLE
+static bool pmConfigure(int maxMhz, int minMhz) {
+    esp_pm_config_esp32_t config = {};
+    config.max_freq_mhz = maxMhz;
+    config.min_freq_mhz = minMhz;
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    config.light_sleep_enable = true;
+#endif
+    return esp_pm_configure(&config) == ESP_OK;
+}
+#endif
+
+bool halPowerBegin(int maxMhz, int minMhz, int wakePin) {
+#if CONFIG_PM_ENABLE
+    if (!pmConfigure(maxMhz, minMhz)) {
+        return false;
+    }
+    pmMinMhz = minMhz;
+    esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "fullSpeed", &fullSpeedLock);
+    esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "awake", &awakeLock);
+    esp_sleep_enable_gpio_wakeup();
+    esp_sleep_pd_config(ESP_PD_DOMAIN_RTC8M, ESP_PD_OPTION_ON);
+    lightSleepWakePin = wakePin;
+    pmReady = true;
+    halPowerSetMode(true, false);
+    return true;
+#else
+    (void)maxMhz;
+    (void)minMhz;
+    (void)wakePin;
+    return false;
+#endif
+}
+
+void halPowerSetMode(bool fullSpeed, bool lightSleep) {
+    if (!pmReady) {
+        return;
+    }
+    if (fullSpeed != pmFullSpeed) {
+        pmFullSpeed = fullSpeed;
+        fullSpeed ? esp_pm_lock_acquire(fullSpeedLock) : esp_pm_lock_release(fullSpeedLock);
+    }
+    bool awake = !lightSleep;
+    if (awake != pmAwake) {
+        pmAwake = awake;
+        if (awake) {
+            esp_pm_lock_acquire(awakeLock);
+        } else {
+            // GPIO wake is level only; first interrupt switches the pin back to CHANGE (see onPinChange)
+            wakeArmed = true;
+            gpio_wakeup_enable((gpio_num_t)lightSleepWakePin, GPIO_INTR_LOW_LEVEL);
+            esp_pm_lock_release(awakeLock);
+        }
+    }
+}
+
+// new full speed clock for the CPU_FREQ_MAX lock; light sleep and the minimum clock are unchanged
+bool halPowerSetMaxMhz(int maxMhz) {
+#if CONFIG_PM_ENABLE
+    return pmReady && pmConfigure(maxMhz, pmMinMhz);
+#else
+    (void)maxMhz;
+    return false;
+#endif
+}
+
+// ------------------------- flash storage -------------------------
+bool halStoreBlob(const char* key, const void* data, int length) {
+    Preferences prefs;
+    prefs.begin(NVS_NAMESPACE, false);
+    bool ok = (prefs.putBytes(key, data, length) == (size_t)length);
+    prefs.end();
+    return ok;
+}
+
+int halLoadBlob(const char* key, void* data, int capacity) {
+    Preferences prefs;
+    prefs.begin(NVS_NAMESPACE, true);
+    size_t length = prefs.getBytesLength(key);
+    if ((length == 0) || (length > (size_t)capacity)) {
+        length = 0;
+    } else {
+        length = prefs.getBytes(key, data, length);
+    }
+    prefs.end();
+    return (int)length;
+}
+
+// ------------------------- BLE keyboard -------------------------
+void halKeyboardBegin() {
+    BLEDevice::setCustomGattsHandler(onGattsEvent);
+    BLEDevice::setCustomGapHandler(onGapEvent);
+    bleKeyboard.begin();  // starts undirected advertising at library defaults
+    bleKeyboard.setDelay(0);  // no fixed sleep after each report: paced by halBleSendCredits() / completions
+    loadBondedHost();
+}
+
+bool halKeyboardIsConnected() {
+    return bleKeyboard.isConnected();
+}
+
+void halKeyboardWrite(halKey_t key) {
+    switch (key) {
+        case HAL_KEY_DOWN_ARROW:
+            bleKeyboard.write(KEY_DOWN_ARROW);
+            break;
+        case HAL_KEY_UP_ARROW:
+            bleKeyboard.write(KEY_UP_ARROW);
+            break;
+        case HAL_KEY_MEDIA_EJECT:
+            bleKeyboard.write(KEY_MEDIA_EJECT);
+            break;
+    }
+}
+
+/*****************************************************************************
+Description : Sends one key report (press or release) as a single notification,
+                without the library's per-report delay.  Refused while the
+                stack has no buffer for it, rather than queued or blocked on.
+                That up-front check is the only refusal this backend can
+                see: BleKeyboard's notify() returns nothing, so a report the
+                stack still drops reads as sent.  It never gets a completion
+                event, and HidPipeline gives up on it after
+                HID_COMPLETION_TIMEOUT_MSEC (counted as lost) - delivery is
+                tracked by completions and that expiry only.
+
+Input Value : key, pressed - press report, else release report
+Return Value: false if not connected or the stack is out of buffers; true
+                does not mean the notification went out
+********************************************************************************/
+bool halKeyboardSendReport(halKey_t key, bool pressed) {
+    if (!bleKeyboard.isConnected() || (halBleSendCredits() == 0)) {
+        return false;
+    }
+    switch (key) {
+        case HAL_KEY_DOWN_ARROW:
+            pressed ? bleKeyboard.press(KEY_DOWN_ARROW) : bleKeyboard.release(KEY_DOWN_ARROW);
+            break;
+        case HAL_KEY_UP_ARROW:
+            pressed ? bleKeyboard.press(KEY_UP_ARROW) : bleKeyboard.release(KEY_UP_ARROW);
+            break;
+        case HAL_KEY_MEDIA_EJECT:
+            pressed ? bleKeyboard.press(KEY_MEDIA_EJECT) : bleKeyboard.release(KEY_MEDIA_EJECT);
+            break;
+    }
+    return true;
+}
+
+// free ACL buffers for the connection: the controller's own flow control
+int halBleSendCredits() {
+    return peerKnown ? esp_ble_get_cur_sendable_packets_num(peerConnId) : 0;
+}
+
+uint32_t halBleTakeCompletions() {
+    uint32_t total = notifyCompletions;
+    uint32_t count = total - completionsTaken;
+    completionsTaken = total;
+    return count;
+}
+
+// clears the library's held keys; it only notifies the central while connected
+void halKeyboardReleaseAll() {
+    bleKeyboard.releaseAll();
+}
+
+void halKeyboardSetBatteryLevel(uint8_t level) {
+    bleKeyboard.setBatteryLevel(level);
+}
+
+// ------------------------- BLE connection parameters -------------------------
+bool halBleUpdateConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout) {
+    if (!peerKnown) {
+        return false;
+    }
+    esp_ble_conn_update_params_t params;
+    memcpy(params.bda, peerAddress, sizeof(esp_bd_addr_t));
+    params.min_int = minInterval;
+    params.max_int = maxInterval;
+    params.latency = latency;
+    params.timeout = timeout;
+    return esp_ble_gap_update_conn_params(&params) == ESP_OK;
+}
+
+bool halBleTakeConnParamsReport(halConnParamsReport_t& report) {
+    if (!connReportPending) {
+        return false;
+    }
+    report = connReport;
+    connReportPending = false;
+    return true;
+}
+
+// ------------------------- BLE advertising -------------------------
+bool halBleBondedHostKnown() {
+    return bondedHostKnown;
+}
+
+bool halBleAdvertise(bool directed, uint16_t minInterval, uint16_t maxInterval) {
+    if (bleKeyboard.isConnected()) {
+        return false;
+    }
+    BLEAdvertising* advertising = BLEDevice::getAdvertising();
+    advertising->stop();
+
+    if (!directed) {
+        // BleKeyboard restarts advertising on disconnect with these, so they always reflect the schedule
+        advertising->setMinInterval(minInterval);
+        advertising->setMaxInterval(maxInterval);
+        advertising->start();
+        return true;
+    }
+    if (!bondedHostKnown) {
+        return false;
+    }
+    esp_ble_adv_params_t params = {};
+    params.adv_int_min = minInterval;
+    params.adv_int_max = maxInterval;
+    params.adv_type = ADV_TYPE_DIRECT_IND_HIGH;
+    params.own_addr_type = BLE_ADDR_TYPE_PUBLIC;
+    memcpy(params.peer_addr, bondedHost.address, sizeof(esp_bd_addr_t));
+    params.peer_addr_type = bondedHost.type;
+    params.channel_map = ADV_CHNL_ALL;
+    params.adv_filter_policy = ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY;
+    return esp_ble_gap_start_advertising(&params) == ESP_OK;
+}
+
+#endif  // ARDUINO
@@ -0,0 +1,514 @@
+/*
+ * *************************************************************
+ * hal_native.cpp - Linux host backend for the flipTurn HAL
+ *
+ *   Time only moves when the simulator advances it, so runs are fully
+ *   deterministic: scripted switch edges in, timestamped HID reports and
+ *   LED values out.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef ARDUINO
+
+#include "hal.h"
+
+#ifdef FLIPTURN_NATIVE_ARDUINO
+#include <Arduino.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+static uint64_t virtual_usec = 0;
+static bool pinLevel[SIM_MAX_PINS];
+static void (*pinIsr[SIM_MAX_PINS])();
+static int ledValue[SIM_MAX_PINS];
+static int ledChannelPin[16] = {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+static bool connected = false;
+static bool deepSleep = false;
+static bool wokeFromDeepSleep = false;
+static uint8_t retainedMemory[HAL_RETAINED_BYTES];
+static uint8_t noInitMemory[HAL_NOINIT_BYTES];  // survives simReset() like a reset survives RTC no-init memory
+static void (*tickHook)() = nullptr;
+// notifications: held in stack buffers, sent at connection events, then reported complete
+static uint32_t linkInterval_usec = SIM_LINK_INTERVAL_USEC;
+static int linkReportsPerEvent = SIM_LINK_REPORTS_PER_EVENT;
+static int linkBuffers = SIM_LINK_BUFFERS;
+static int linkQueued = 0;
+static uint16_t linkLatency = 0;
+static uint64_t nextConnEvent_usec = 0;
+static uint32_t linkCompletions = 0;
+struct simBlob_t {
+    char key[16];
+    int length;
+    uint8_t data[SIM_BLOB_BYTES];
+};
+static simBlob_t blob[SIM_MAX_BLOBS];  // "flash": survives simReset()
+static bool powerFullSpeed = true;
+static bool powerLightSleep = false;
+static int powerMaxMhz = 240;
+static int powerMinMhz = 240;
+static uint8_t batteryLevel = 100;
+static halConnParamsReport_t connReport;
+static bool connReportPending = false;
+static bool bondedHost = false;
+static bool advDirected = false;
+static uint16_t advInterval = 0;
+static simHidReport_t hidReports[SIM_MAX_HID_REPORTS];
+static int hidReportCount = 0;
+static uint8_t keysHeld = 0;  // like BleKeyboard's report: kept through a disconnect until released
+
+static bool validPin(int pin) {
+    return (pin >= 0) && (pin < SIM_MAX_PINS);
+}
+
+// ------------------------- time -------------------------
+unsigned long halMillis() {
+    return (unsigned long)(virtual_usec / 1000);
+}
+
+uint32_t halMicros() {
+    return (uint32_t)virtual_usec;  // wraps like the ESP32 micros()
+}
+
+void halDelay(unsigned long msec) {
+#ifdef FLIPTURN_NATIVE_ARDUINO
+    delay(msec);  // blocks the calling task on the host scheduler, as on the ESP32
+#else
+    virtual_usec += (uint64_t)msec * 1000;
+#endif
+}
+
+int halCoreId() {
+    return 0;
+}
+
+uint32_t halCycleCount() {
+    return (uint32_t)(virtual_usec * 240);  // as if at 240 MHz; work takes no virtual time
+}
+
+bool halAttachTickHook(void (*hook)()) {
+    tickHook = hook;
+    return true;
+}
+
+// nothing was interrupted on the host
+int halInterruptedBacktrace(uint32_t* pcs, int depth, char* task, int taskBytes) {
+    (void)pcs;
+    (void)depth;
+    if (taskBytes > 0) {
+        task[0] = 0;
+    }
+    return 0;
+}
+
+uint32_t halHeapFree() {
+    return 0;  // not modelled
+}
+
+uint32_t halHeapMinFree() {
+    return 0;
+}
+
+// ------------------------- GPIO -------------------------
+void halPinModeInputPullup(int pin) {
+    if (validPin(pin)) {
+        pinLevel[pin] = true;
+    }
+}
+
+void halPinModeInput(int pin) {
+    halPinModeInputPullup(pin);  // simulated external pull-up idles high too
+}
+
+void halPinModeOutput(int pin) {
+    if (validPin(pin)) {
+        ledValue[pin] = 0;
+    }
+}
+
+bool halDigitalRead(int pin) {
+    return validPin(pin) ? pinLevel[pin] : true;
+}
+
+uint64_t halReadInputs() {
+    uint64_t levels = 0;
+    for (int pin = 0; pin < SIM_MAX_PINS; pin++) {
+        levels |= (uint64_t)pinLevel[pin] << pin;
+    }
+    return levels;
+}
+
+void halAttachChangeInterrupt(int pin, void (*isr)()) {
+    if (validPin(pin)) {
+        pinIsr[pin] = isr;
+    }
+}
+
+// ------------------------- serial -------------------------
+int halSerialWritable() {
+    return 256;
+}
+
+void halSerialWrite(const char* data, int length) {
+#ifdef FLIPTURN_NATIVE_ARDUINO
+    Serial.write((const uint8_t*)data, length);  // the shim's Serial, so hostSerialMute() covers the logger too
+#else
+    fwrite(data, 1, length, stdout);
+#endif
+}
+
+void halLedAttach(int channel, int pin) {
+    if ((channel >= 0) && (channel < 16)) {
+        ledChannelPin[channel] = pin;
+    }
+}
+
+// fades complete instantly in the simulator
+void halLedFade(int channel, uint16_t duty, uint32_t fade_msec) {
+    (void)fade_msec;
+    if ((channel >= 0) && (channel < 16) && validPin(ledChannelPin[channel])) {
+        ledValue[ledChannelPin[channel]] = duty;
+    }
+}
+
+// ------------------------- power -------------------------
+void halDeepSleep() {
+    deepSleep = true;  // caller keeps running; simulator checks simInDeepSleep()
+}
+
+// any pin can wake the simulator
+bool halCanWakeOnPin(int pin) {
+    return validPin(pin);
+}
+
+bool halDeepSleepWakeOnPin(int pin) {
+    if (!halCanWakeOnPin(pin)) {
+        return false;
+    }
+    deepSleep = true;
+    return true;
+}
+
+bool halWokeFromDeepSleep() {
+    return wokeFromDeepSleep;
+}
+
+uint8_t* halRetainedMemory() {
+    return retainedMemory;
+}
+
+uint8_t* halNoInitMemory() {
+    return noInitMemory;
+}
+
+bool halPowerBegin(int maxMhz, int minMhz, int wakePin) {
+    powerMaxMhz = maxMhz;
+    powerMinMhz = minMhz;
+    (void)wakePin;
+    return true;
+}
+
+void halPowerSetMode(bool fullSpeed, bool lightSleep) {
+    powerFullSpeed = fullSpeed;
+    powerLightSleep = lightSleep;
+}
+
+bool halPowerSetMaxMhz(int maxMhz) {
+    powerMaxMhz = maxMhz;
+    return true;
+}
+
+// ------------------------- flash storage -------------------------
+static simBlob_t* findBlob(const char* key, bool create) {
+    for (int i = 0; i < SIM_MAX_BLOBS; i++) {
+        if ((blob[i].key[0] != 0) && (strncmp(blob[i].key, key, sizeof(blob[i].key)) == 0)) {
+            return &blob[i];
+        }
+    }
+    for (int i = 0; create && (i < SIM_MAX_BLOBS); i++) {
+        if (blob[i].key[0] == 0) {
+            strncpy(blob[i].key, key, sizeof(blob[i].key) - 1);
+            return &blob[i];
+        }
+    }
+    return nullptr;
+}
+
+bool halStoreBlob(const char* key, const void* data, int length) {
+    simBlob_t* b = (length <= SIM_BLOB_BYTES) ? findBlob(key, true) : nullptr;
+    if (b == nullptr) {
+        return false;
+    }
+    memcpy(b->data, data, length);
+    b->length = length;
+    return true;
+}
+
+int halLoadBlob(const char* key, void* data, int capacity) {
+    const simBlob_t* b = findBlob(key, false);
+    if ((b == nullptr) || (b->length > capacity)) {
+        return 0;
+    }
+    memcpy(data, b->data, b->length);
+    return b->length;
+}
+
+// ------------------------- BLE keyboard -------------------------
+void halKeyboardBegin() {
+}
+
+bool halKeyboardIsConnected() {
+    return connected;
+}
+
+void halKeyboardWrite(halKey_t key) {
+    if (hidReportCount < SIM_MAX_HID_REPORTS) {
+        hidReports[hidReportCount].time_usec = halMicros();
+        hidReports[hidReportCount].key = key;
+        hidReportCount++;
+    }
+}
+
+// one notification into the simulated stack buffers; presses logged like halKeyboardWrite()
+bool halKeyboardSendReport(halKey_t key, bool pressed) {
+    if (!connected || (linkQueued >= linkBuffers)) {
+        return false;
+    }
+    if (linkQueued == 0) {
+        nextConnEvent_usec = (virtual_usec / linkInterval_usec + 1) * linkInterval_usec;
+    }
+    linkQueued++;
+    if (pressed) {
+        keysHeld |= (1 << key);
+        halKeyboardWrite(key);
+    } else {
+        keysHeld &= ~(1 << key);
+    }
+    return true;
+}
+
+int halBleSendCredits() {
+    return connected ? linkBuffers - linkQueued : 0;
+}
+
+uint32_t halBleTakeCompletions() {
+    uint32_t count = linkCompletions;
+    linkCompletions = 0;
+    return count;
+}
+
+// no notification modelled: flipTurn only calls it once the link is down
+void halKeyboardReleaseAll() {
+    keysHeld = 0;
+}
+
+void halKeyboardSetBatteryLevel(uint8_t level) {
+    batteryLevel = level;
+}
+
+// simulated central accepts every request and settles on the maximum interval
+bool halBleUpdateConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout) {
+    (void)minInterval;
+    if (!connected) {
+        return false;
+    }
+    connReport.time_msec = halMillis();
+    connReport.ok = true;
+    connReport.interval = maxInterval;
+    connReport.latency = latency;
+    linkInterval_usec = maxInterval * 1250UL;
+    linkLatency = latency;  // only skips events with nothing queued: pending notifications go at the next event
+    connReport.timeout = timeout;
+    connReportPending = true;
+    return true;
+}
+
+bool halBleTakeConnParamsReport(halConnParamsReport_t& report) {
+    if (!connReportPending) {
+        return false;
+    }
+    report = connReport;
+    connReportPending = false;
+    return true;
+}
+
+bool halBleBondedHostKnown() {
+    return bondedHost;
+}
+
+bool halBleAdvertise(bool directed, uint16_t minInterval, uint16_t maxInterval) {
+    (void)minInterval;
+    if (connected || (directed && !bondedHost)) {
+        return false;
+    }
+    advDirected = directed;
+    advInterval = maxInterval;
+    return true;
+}
+
+// ------------------------- simulator controls -------------------------
+void simReset() {
+    virtual_usec = 0;
+    for (int pin = 0; pin < SIM_MAX_PINS; pin++) {
+        pinLevel[pin] = true;
+        pinIsr[pin] = nullptr;
+        ledValue[pin] = 0;
+    }
+    connected = false;
+    deepSleep = false;
+    powerFullSpeed = true;
+    powerLightSleep = false;
+    powerMaxMhz = 240;
+    powerMinMhz = 240;
+    batteryLevel = 100;
+    connReportPending = false;
+    bondedHost = false;
+    advDirected = false;
+    advInterval = 0;
+    hidReportCount = 0;
+    keysHeld = 0;
+    tickHook = nullptr;
+    linkInterval_usec = SIM_LINK_INTERVAL_USEC;
+    linkReportsPerEvent = SIM_LINK_REPORTS_PER_EVENT;
+    linkBuffers = SIM_LINK_BUFFERS;
+    linkQueued = 0;
+    linkLatency = 0;
+    linkCompletions = 0;
+}
+
+// advances in steps to each msec boundary, where the tick hook (if any) runs, and to each
+//   connection event while notifications are waiting
+static void advance(uint64_t usec) {
+    uint64_t end_usec = virtual_usec + usec;
+    while (virtual_usec < end_usec) {
+        uint64_t step_usec = end_usec;
+        if (tickHook != nullptr) {
+            uint64_t tick_usec = (virtual_usec / 1000 + 1) * 1000;
+            step_usec = (tick_usec < step_usec) ? tick_usec : step_usec;
+        }
+        if (linkQueued > 0) {
+            step_usec = (nextConnEvent_usec < step_usec) ? nextConnEvent_usec : step_usec;
+        }
+        virtual_usec = step_usec;
+        if ((linkQueued > 0) && (virtual_usec >= nextConnEvent_usec)) {
+            int sent = (linkQueued < linkReportsPerEvent) ? linkQueued : linkReportsPerEvent;
+            linkQueued -= sent;
+            linkCompletions += sent;
+            nextConnEvent_usec += linkInterval_usec;
+        }
+        if ((tickHook != nullptr) && ((virtual_usec % 1000) == 0)) {
+            tickHook();
+        }
+    }
+}
+
+void simAdvanceUsec(uint32_t usec) {
+    advance(usec);
+}
+
+void simAdvanceMsec(unsigned long msec) {
+    advance((uint64_t)msec * 1000);
+}
+
+uint64_t simNow_usec() {
+    return virtual_usec;
+}
+
+void simSetPin(int pin, bool level) {
+    if (validPin(pin) && (pinLevel[pin] != level)) {
+        pinLevel[pin] = level;
+        if (pinIsr[pin] != nullptr) {
+            pinIsr[pin]();  // simulated GPIO interrupt, runs "immediately" at current virtual time
+        }
+    }
+}
+
+void simSetLink(uint32_t interval_usec, int reportsPerEvent, int buffers) {
+    linkInterval_usec = interval_usec;
+    linkReportsPerEvent = reportsPerEvent;
+    linkBuffers = buffers;
+}
+
+void simSetConnected(bool isConnected) {
+    connected = isConnected;
+    if (!connected) {
+        linkQueued = 0;  // stack drops undelivered notifications
+    }
+    if (connected) {
+        advInterval = 0;  // stack stops advertising on connect
+    }
+}
+
+void simSetBondedHost(bool known) {
+    bondedHost = known;
+}
+
+bool simAdvertisingDirected() {
+    return advDirected;
+}
+
+uint16_t simAdvertisingInterval() {
+    return advInterval;
+}
+
+uint32_t simLinkInterval_usec() {
+    return linkInterval_usec;
+}
+
+uint16_t simLinkLatency() {
+    return linkLatency;
+}
+
+int simLinkQueued() {
+    return linkQueued;
+}
+
+int simLedValue(int pin) {
+    return validPin(pin) ? ledValue[pin] : 0;
+}
+
+bool simInDeepSleep() {
+    return deepSleep;
+}
+
+void simSetWokeFromDeepSleep(bool woke) {
+    wokeFromDeepSleep = woke;
+}
+
+bool simPowerFullSpeed() {
+    return powerFullSpeed;
+}
+
+bool simPowerLightSleep() {
+    return powerLightSleep;
+}
+
+int simPowerMaxMhz() {
+    return powerMaxMhz;
+}
+
+int simPowerMinMhz() {
+    return powerMinMhz;
+}
+
+uint8_t simKeysHeld() {
+    return keysHeld;
+}
+
+uint8_t simBatteryLevel() {
+    return batteryLevel;
+}
+
+int simHidReportCount() {
+    return hidReportCount;
+}
+
+const simHidReport_t& simHidReport(int index) {
+    return hidReports[index];
+}
+
+#endif  // ARDUINO
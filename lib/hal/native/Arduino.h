@@ -0,0 +1,131 @@
+/*
+ * *************************************************************
+ * Arduino.h - host stand-in for the Arduino core + FreeRTOS task API
+ *
+ *   Used by [env:native] only (build_flags -I lib/hal/native, plus
+ *   FLIPTURN_NATIVE_ARDUINO for code that otherwise needs ARDUINO), so main
+ *   and its libraries compile on Linux against the native HAL.  Time and
+ *   pins go to the HAL's virtual clock and fake GPIO; Serial writes to
+ *   stdout and reads what the runner feeds it.  Tasks are run one at a time
+ *   by a cooperative scheduler on the virtual clock (arduino_native.cpp): a
+ *   task runs until it blocks in ulTaskNotifyTake(), vTaskDelay(),
+ *   vTaskDelayUntil() or delay(), and work takes no virtual time, so a run
+ *   is repeatable.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef ARDUINO_NATIVE_H  // begin header guard
+#define ARDUINO_NATIVE_H
+
+#ifdef ARDUINO
+#error "lib/hal/native is the host stand-in; the ESP32 build uses the real Arduino core"
+#endif
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hal.h"
+#include "pins_arduino.h"
+
+typedef uint8_t byte;
+
+#define F(text) (text)
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+/******************************************************
+// time and pins, on the native HAL
+******************************************************/
+inline unsigned long millis() { return halMillis(); }
+inline unsigned long micros() { return halMicros(); }
+void delay(unsigned long msec);  // vTaskDelay(), as the ESP32 core does
+inline void yield() {}
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+    if (mode == OUTPUT) {
+        halPinModeOutput(pin);
+    } else {
+        halPinModeInputPullup(pin);  // the foot switch is the only input
+    }
+}
+inline int digitalRead(uint8_t pin) { return halDigitalRead(pin) ? HIGH : LOW; }
+
+/******************************************************
+// Serial
+******************************************************/
+class Print {
+   public:
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t length);  // stdout, unless hostSerialMute()
+    size_t print(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(long value) { return printf("%ld", value); }
+    size_t print(unsigned long value) { return printf("%lu", value); }
+    size_t print(int value) { return print((long)value); }
+    size_t print(unsigned int value) { return print((unsigned long)value); }
+    size_t print(double value, int digits = 2) { return printf("%.*f", digits, value); }
+    template <typename T>
+    size_t println(T value) { return print(value) + print("\r\n"); }
+    size_t println() { return print("\r\n"); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    void flush() { fflush(stdout); }
+};
+
+class HardwareSerial : public Print {
+   public:
+    void begin(unsigned long baud) { (void)baud; }
+    int available();
+    int read();
+};
+extern HardwareSerial Serial;
+
+/******************************************************
+// FreeRTOS (ESP-IDF flavour), 1 ms tick
+******************************************************/
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void* parameter);
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(msec) ((TickType_t)(msec))
+#define portYIELD_FROM_ISR(woken) ((void)(woken))  // ready tasks run when the caller next blocks
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stackBytes, void* parameter,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core);
+void vTaskDelete(TaskHandle_t task);  // nullptr = the calling task; only the calling task is supported
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t increment);
+TickType_t xTaskGetTickCount();
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t wait);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityWoken);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);  // bytes never touched, of the host stack
+
+/******************************************************
+// Host runner controls (arduino_native.cpp)
+******************************************************/
+void setup();  // the sketch's, as with the Arduino core
+void loop();
+void hostStartArduino();                  // loopTask: setup() then loop() forever, as the ESP32 core starts it
+bool hostRunUntil(uint64_t until_usec);  // runs ready tasks on the virtual clock; false in deep sleep / no task left
+void hostSetStepHook(void (*hook)());     // called after each task step, eg to report new HID reports / LED colours
+void hostSerialInput(const char* text);   // queued for Serial.read()
+void hostSerialMute(bool muted);          // drop Serial output, eg while a long run reports on stdout itself
+
+#endif  // end header guard
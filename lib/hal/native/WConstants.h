@@ -0,0 +1 @@
+// host stand-in for the pre-1.0 Arduino header - see WProgram.h
@@ -0,0 +1,3 @@
+// host stand-in for the pre-1.0 Arduino header (flipTurn headers fall back to it when
+//   ARDUINO is not defined) - see Arduino.h
+#include "Arduino.h"
@@ -0,0 +1,291 @@
+/*
+ * *************************************************************
+ * arduino_native.cpp - host stand-in for Serial and the FreeRTOS task API
+ *
+ *   Each task gets its own stack (ucontext) and runs until it blocks; the
+ *   scheduler then resumes the highest priority ready task, or advances the
+ *   native HAL's virtual clock to the next wake-up.  Pin ISRs fired by the
+ *   runner (simSetPin) can notify a task, which is ready from that moment.
+ *   Single threaded: the two ESP32 cores are not modelled.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef ARDUINO
+
+#include "Arduino.h"
+
+#include <ucontext.h>
+
+#include "hal.h"  // virtual clock
+
+HardwareSerial Serial;
+
+constexpr int HOST_MAX_TASKS = 8;
+constexpr uint32_t HOST_MIN_STACK_BYTES = 65536;  // glibc printf needs more than an ESP32 task stack
+constexpr uint8_t HOST_STACK_FILL = 0xa5;          // painted for uxTaskGetStackHighWaterMark()
+constexpr uint64_t HOST_NEVER = 0xffffffffffffffffULL;
+constexpr uint32_t HOST_MAX_STEPS_AT_ONCE = 100000;  // task steps without the clock moving: a task that never blocks
+
+struct hostTask_t {
+    TaskFunction_t function;
+    void* parameter;
+    const char* name;
+    UBaseType_t priority;
+    ucontext_t context;
+    uint8_t* stack;
+    uint32_t stackBytes;
+    bool finished;
+    bool waitNotify;     // blocked in ulTaskNotifyTake()
+    uint64_t wake_usec;  // HOST_NEVER = no timeout
+    uint32_t notifications;
+};
+
+static hostTask_t task[HOST_MAX_TASKS];
+static int tasks = 0;
+static int current = -1;  // task running; -1 = scheduler / runner
+static int lastRun = -1;  // round robin among equal priorities
+static ucontext_t schedulerContext;
+static void (*stepHook)() = nullptr;
+
+static char serialInput[256];
+static int serialHead = 0, serialCount = 0;
+static bool serialMuted = false;
+
+// ------------------------- Serial -------------------------
+int HardwareSerial::available() {
+    return serialCount;
+}
+
+int HardwareSerial::read() {
+    if (serialCount == 0) {
+        return -1;
+    }
+    char c = serialInput[serialHead];
+    serialHead = (serialHead + 1) % (int)sizeof(serialInput);
+    serialCount--;
+    return (uint8_t)c;
+}
+
+size_t Print::write(const uint8_t* data, size_t length) {
+    return serialMuted ? length : fwrite(data, 1, length, stdout);
+}
+
+size_t Print::printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int written = serialMuted ? vsnprintf(nullptr, 0, format, args) : vfprintf(stdout, format, args);
+    va_end(args);
+    return written < 0 ? 0 : (size_t)written;
+}
+
+void hostSerialInput(const char* text) {
+    for (; (*text != 0) && (serialCount < (int)sizeof(serialInput)); text++, serialCount++) {
+        serialInput[(serialHead + serialCount) % (int)sizeof(serialInput)] = *text;
+    }
+}
+
+void hostSerialMute(bool muted) {
+    serialMuted = muted;
+}
+
+// ------------------------- tasks -------------------------
+static void taskEntry(int index) {
+    task[index].function(task[index].parameter);
+    task[index].finished = true;  // a FreeRTOS task must not return; treated as vTaskDelete(nullptr)
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackBytes, void* parameter,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    (void)core;
+    if (tasks == HOST_MAX_TASKS) {
+        return pdFALSE;
+    }
+    hostTask_t& t = task[tasks];
+    memset(&t, 0, sizeof(t));
+    t.function = function;
+    t.parameter = parameter;
+    t.name = name;
+    t.priority = priority;
+    t.stackBytes = (stackBytes > HOST_MIN_STACK_BYTES) ? stackBytes : HOST_MIN_STACK_BYTES;
+    t.stack = (uint8_t*)malloc(t.stackBytes);
+    if (t.stack == nullptr) {
+        return pdFALSE;
+    }
+    memset(t.stack, HOST_STACK_FILL, t.stackBytes);
+    getcontext(&t.context);
+    t.context.uc_stack.ss_sp = t.stack;
+    t.context.uc_stack.ss_size = t.stackBytes;
+    t.context.uc_link = &schedulerContext;  // returning from the task function ends up in the scheduler
+    makecontext(&t.context, (void (*)())taskEntry, 1, tasks);
+    t.wake_usec = 0;  // ready
+    if (handle != nullptr) {
+        *handle = &t;
+    }
+    tasks++;
+    return pdPASS;
+}
+
+// back to the scheduler until the task is ready again
+static void block(uint64_t wake_usec, bool waitNotify) {
+    hostTask_t& t = task[current];
+    t.wake_usec = wake_usec;
+    t.waitNotify = waitNotify;
+    swapcontext(&t.context, &schedulerContext);
+}
+
+void vTaskDelete(TaskHandle_t handle) {
+    if ((current < 0) || ((handle != nullptr) && (handle != &task[current]))) {
+        return;  // deleting another task is not needed by flipTurn
+    }
+    task[current].finished = true;
+    swapcontext(&task[current].context, &schedulerContext);  // never resumed
+}
+
+void vTaskDelay(TickType_t ticks) {
+    if (current >= 0) {
+        block(simNow_usec() + (uint64_t)ticks * 1000, false);
+    } else {
+        simAdvanceMsec(ticks);  // no task running (unit tests): just move the clock
+    }
+}
+
+void delay(unsigned long msec) {
+    vTaskDelay(pdMS_TO_TICKS(msec));
+}
+
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t increment) {
+    *previousWake += increment;
+    int32_t wait = (int32_t)(*previousWake - xTaskGetTickCount());
+    if ((wait > 0) && (current >= 0)) {
+        block(simNow_usec() + (uint64_t)wait * 1000 - simNow_usec() % 1000, false);
+    }
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)halMillis();
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t wait) {
+    hostTask_t& t = task[current];
+    if ((t.notifications == 0) && (wait != 0)) {
+        block((wait == portMAX_DELAY) ? HOST_NEVER : simNow_usec() + (uint64_t)wait * 1000, true);
+    }
+    uint32_t count = t.notifications;
+    if (count > 0) {
+        t.notifications = clearOnExit ? 0 : count - 1;
+    }
+    return count;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t handle, BaseType_t* higherPriorityWoken) {
+    hostTask_t* t = (hostTask_t*)handle;
+    t->notifications++;
+    if (higherPriorityWoken != nullptr) {
+        *higherPriorityWoken = pdFALSE;
+    }
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t handle) {
+    hostTask_t* t = (handle != nullptr) ? (hostTask_t*)handle : &task[current];
+    uint32_t untouched = 0;
+    while ((untouched < t->stackBytes) && (t->stack[untouched] == HOST_STACK_FILL)) {  // stacks grow down
+        untouched++;
+    }
+    return untouched;
+}
+
+// ------------------------- scheduler -------------------------
+static bool isReady(const hostTask_t& t, uint64_t now_usec) {
+    return !t.finished && ((t.waitNotify && (t.notifications > 0)) || (t.wake_usec <= now_usec));
+}
+
+// highest priority ready task, round robin among equals; -1 if none
+static int pickTask(uint64_t now_usec) {
+    int best = -1;
+    for (int n = 1; n <= tasks; n++) {
+        int i = (lastRun + n + tasks) % tasks;
+        if (isReady(task[i], now_usec) && ((best < 0) || (task[i].priority > task[best].priority))) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+static void loopTask(void* parameter) {
+    (void)parameter;
+    setup();
+    for (;;) {
+        loop();
+    }
+}
+
+void hostStartArduino() {
+    xTaskCreatePinnedToCore(loopTask, "loopTask", 8192, nullptr, 1, nullptr, 1);  // as the ESP32 core's app_main does
+}
+
+void hostSetStepHook(void (*hook)()) {
+    stepHook = hook;
+}
+
+/*****************************************************************************
+Description : Runs tasks until the virtual clock reaches until_usec.  Ready
+                tasks run first (no virtual time passes while they do), then
+                the clock is advanced to the next task wake-up - the HAL's
+                tick hook and BLE link model run on the way.
+
+Input Value : until_usec - virtual time to stop at
+Return Value: false once the firmware is in deep sleep (nothing runs after
+                that on the ESP32), or every task has finished (or the
+                scheduler gave up on a task that never blocks)
+********************************************************************************/
+bool hostRunUntil(uint64_t until_usec) {
+    uint32_t steps = 0;
+    for (;;) {
+        if (simInDeepSleep()) {
+            return false;
+        }
+        uint64_t now_usec = simNow_usec();
+        int next = pickTask(now_usec);
+        if ((next >= 0) && (now_usec <= until_usec)) {
+            if (++steps > HOST_MAX_STEPS_AT_ONCE) {
+                fprintf(stderr, "host scheduler: task '%s' never blocks\n", task[next].name);
+                return false;
+            }
+            current = lastRun = next;
+            task[next].waitNotify = false;
+            swapcontext(&schedulerContext, &task[next].context);
+            current = -1;
+            if (stepHook != nullptr) {
+                stepHook();
+            }
+            continue;
+        }
+
+        uint64_t wake_usec = HOST_NEVER;
+        bool alive = false;
+        for (int i = 0; i < tasks; i++) {
+            alive |= !task[i].finished;
+            if (!task[i].finished && (task[i].wake_usec < wake_usec)) {
+                wake_usec = task[i].wake_usec;
+            }
+        }
+        if (!alive && (tasks > 0)) {
+            return false;
+        }
+        if (now_usec >= until_usec) {
+            return true;
+        }
+        uint64_t step_usec = ((wake_usec < until_usec) ? wake_usec : until_usec) - now_usec;
+        while (step_usec > 0) {
+            uint32_t chunk_usec = (step_usec > 0x7fffffffULL) ? 0x7fffffffUL : (uint32_t)step_usec;
+            simAdvanceUsec(chunk_usec);
+            step_usec -= chunk_usec;
+        }
+        steps = 0;
+    }
+}
+
+#endif  // ARDUINO
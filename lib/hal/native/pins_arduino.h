@@ -0,0 +1,11 @@
+// host stand-in for the board variant's pins_arduino.h (firebeetle32): the pin names flipTurn uses,
+//   as in myConstants.h's pin-out table - see Arduino.h
+#ifndef PINS_ARDUINO_NATIVE_H  // begin header guard
+#define PINS_ARDUINO_NATIVE_H
+
+#include <stdint.h>
+
+static const uint8_t A0 = 36;
+static const uint8_t D6 = 10;
+
+#endif  // end header guard
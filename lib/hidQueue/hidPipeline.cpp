@@ -0,0 +1,162 @@
+/*
+ * *************************************************************
+ * hidPipeline.cpp - implementation file for flow-controlled HID report pipeline
+ *
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include "hidPipeline.h"
+
+#include <string.h>
+
+// HidPipeline constructor; maxOutstanding capped at HID_MAX_IN_FLIGHT
+HidPipeline::HidPipeline(HidEventQueue& queue, uint8_t maxOutstanding, uint32_t completionTimeout_msec,
+                         uint32_t repeatInterval_msec)
+    : _queue(queue),
+      _maxOutstanding(maxOutstanding < HID_MAX_IN_FLIGHT ? maxOutstanding : HID_MAX_IN_FLIGHT),
+      _completionTimeout_usec(completionTimeout_msec * 1000UL),
+      _repeatInterval_msec(repeatInterval_msec),
+      _inFlight(0),
+      _offered(false),
+      _retry(false),
+      _releasePending(false),
+      _pressedKey(HAL_KEY_DOWN_ARROW),
+      _wasFull(false),
+      _repeating(false),
+      _repeatKey(HAL_KEY_DOWN_ARROW),
+      _nextRepeat_msec(0) {
+    resetStats();
+}
+
+void HidPipeline::resetStats() {
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+// gives up on notifications whose completion never came (eg event lost), so the window can't jam
+void HidPipeline::expire(uint32_t now_usec) {
+    while ((_inFlight > 0) && ((now_usec - _sent_usec[0]) > _completionTimeout_usec)) {
+        memmove(&_sent_usec[0], &_sent_usec[1], (_inFlight - 1) * sizeof(_sent_usec[0]));
+        _inFlight--;
+        _stats.lost++;
+    }
+}
+
+/*****************************************************************************
+Description : Offers the next report to send: the release of a key already
+                pressed, else a refused report again, else the press of the
+                next key from the queue.  Nothing while the window of
+                outstanding notifications or the stack's buffers are full
+                (backpressure), or while disconnected.  Also queues the next
+                auto-repeat key when it is due.
+
+Input Value : now_msec, now_usec, connected - BLE link state
+              credits - notifications the stack can take now, -1 if unknown
+Return Value: true with report set; send it, then call sent()
+********************************************************************************/
+bool HidPipeline::next(uint32_t now_msec, uint32_t now_usec, bool connected, int credits, hidReport_t& report) {
+    _offered = false;
+    if (!connected) {
+        // stack drops its buffers and the central releases all keys on disconnect; no completions follow.
+        //   The caller clears the keyboard's own held keys (halKeyboardReleaseAll) so a dropped
+        //   release can't leave a key down in the next report after reconnect
+        _inFlight = 0;
+        _releasePending = false;
+        if (_retry) {
+            _queue.requeue(_report.key, now_msec);  // refused press: replayed first after reconnect
+            _retry = false;
+        }
+        halKey_t unused;
+        _queue.next(now_msec, false, unused);  // queue marks what it holds for replay
+        return false;
+    }
+    expire(now_usec);
+
+    if (_repeating && ((int32_t)(now_msec - _nextRepeat_msec) >= 0)) {
+        _nextRepeat_msec = now_msec + _repeatInterval_msec;
+        if (_queue.isEmpty() && !_releasePending && (_inFlight == 0)) {
+            _queue.push(_repeatKey, now_msec, true);
+            _stats.repeats++;
+        } else {
+            _stats.repeatsSkipped++;  // last key not delivered yet: lower the rate rather than build a backlog
+        }
+    }
+
+    bool ready = _releasePending || _retry || !_queue.isEmpty();
+    if ((_inFlight >= _maxOutstanding) || (credits == 0)) {
+        if (ready && !_wasFull) {
+            _wasFull = true;
+            _stats.backpressure++;
+        }
+        return false;
+    }
+
+    if (_releasePending) {
+        _report.key = _pressedKey;
+        _report.pressed = false;
+    } else if (!_retry) {
+        halKey_t key;
+        if (!_queue.next(now_msec, true, key)) {
+            return false;
+        }
+        _report.key = key;
+        _report.pressed = true;
+    }
+    report = _report;
+    _offered = true;
+    return true;
+}
+
+/*****************************************************************************
+Description : Commits the report next() offered.  An accepted report counts as
+                outstanding until its completion event; a refused one is
+                offered again.
+
+Input Value : accepted - stack took the notification, now_usec
+Return Value: -
+********************************************************************************/
+void HidPipeline::sent(bool accepted, uint32_t now_usec) {
+    if (!_offered) {
+        return;
+    }
+    _offered = false;
+    if (!accepted) {
+        _retry = !_releasePending;  // a pending release is offered again anyway
+        _stats.refused++;
+        return;
+    }
+    _retry = false;
+    _wasFull = false;
+    if (_inFlight < HID_MAX_IN_FLIGHT) {
+        _sent_usec[_inFlight++] = now_usec;
+    }
+    if (_inFlight > _stats.maxInFlight) {
+        _stats.maxInFlight = _inFlight;
+    }
+    _stats.reports++;
+    _releasePending = _report.pressed;
+    _pressedKey = _report.key;
+}
+
+// completion events (stack finished with a notification) retire the oldest outstanding reports
+void HidPipeline::completed(uint32_t count, uint32_t now_usec) {
+    for (; (count > 0) && (_inFlight > 0); count--) {
+        uint32_t complete_usec = now_usec - _sent_usec[0];
+        memmove(&_sent_usec[0], &_sent_usec[1], (_inFlight - 1) * sizeof(_sent_usec[0]));
+        _inFlight--;
+        _stats.completed++;
+        _stats.totalComplete_usec += complete_usec;
+        if (complete_usec > _stats.maxComplete_usec) {
+            _stats.maxComplete_usec = complete_usec;
+        }
+    }
+}
+
+// hold-to-scroll: key now, then every repeat interval until stopRepeat()
+void HidPipeline::startRepeat(halKey_t key, uint32_t now_msec) {
+    _repeating = true;
+    _repeatKey = key;
+    _nextRepeat_msec = now_msec;
+}
@@ -0,0 +1,101 @@
+/*
+ * *************************************************************
+ * hidPipeline.h - Header file for flow-controlled HID report pipeline
+ *
+ *   Turns keys from the HidEventQueue into BLE keyboard reports (a press
+ *   report then a release report, one notification each) and paces them by
+ *   the stack rather than by a fixed delay: a report goes out as soon as
+ *   fewer than maxOutstanding notifications are waiting for their completion
+ *   event and the stack has a free buffer (send credits).  When either runs
+ *   out the pipeline stops taking keys, so they stay in the queue - where
+ *   page turns still coalesce - until the link catches up.
+ *
+ *   Hold-to-scroll: startRepeat() feeds one key into the queue every repeat
+ *   interval, and only once the previous key has been delivered (queue empty,
+ *   nothing outstanding), so a slow link lowers the rate instead of building
+ *   a backlog - in the queue or the stack - that keeps scrolling after release.
+ *
+ *   next() never waits: the caller passes the clock, link state and send
+ *   credits on every call and reports back through sent() / completed(), so
+ *   the same code runs against the native HAL link model in tools/hidBench.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef HID_PIPELINE_H  // begin header guard
+#define HID_PIPELINE_H
+
+#include <stdint.h>
+
+#include "hal.h"  // halKey_t
+#include "hidQueue.h"
+
+constexpr int HID_MAX_IN_FLIGHT = 8;  // notifications tracked for completion (maxOutstanding limit)
+
+struct hidReport_t {
+    halKey_t key;
+    bool pressed;  // press report; false = release report
+};
+
+// counters for the serial monitor; reports are notifications (two per key)
+struct hidPipelineStats_t {
+    uint32_t reports;          // accepted by the stack
+    uint32_t refused;          // stack refused a report (retried)
+    uint32_t completed;        // completion events matched to a report
+    uint32_t lost;             // reports given up on after the completion timeout
+    uint32_t backpressure;     // times a report was ready but the window or stack buffers were full
+    uint32_t repeats;          // auto-repeat keys queued
+    uint32_t repeatsSkipped;   // auto-repeat ticks skipped, previous key not yet delivered
+    uint16_t maxInFlight;
+    uint64_t totalComplete_usec;  // send -> completion, for the mean
+    uint32_t maxComplete_usec;
+};
+
+class HidPipeline {
+   public:
+    HidPipeline(HidEventQueue& queue, uint8_t maxOutstanding, uint32_t completionTimeout_msec,
+                uint32_t repeatInterval_msec);  // constructor prototype
+
+    // method prototypes:
+    bool next(uint32_t now_msec, uint32_t now_usec, bool connected, int credits, hidReport_t& report);
+    void sent(bool accepted, uint32_t now_usec);  // after sending the report next() returned
+    void completed(uint32_t count, uint32_t now_usec);  // completion events since the last call
+
+    void startRepeat(halKey_t key, uint32_t now_msec);
+    void stopRepeat() { _repeating = false; }
+    bool isRepeating() const { return _repeating; }
+
+    // input task must keep polling: release report, completions or repeats pending
+    bool isBusy() const { return _releasePending || _repeating || (_inFlight > 0); }
+    uint8_t inFlight() const { return _inFlight; }
+    const hidPipelineStats_t& stats() const { return _stats; }
+    void resetStats();
+
+   private:
+    void expire(uint32_t now_usec);
+
+    HidEventQueue& _queue;
+    uint8_t _maxOutstanding;
+    uint32_t _completionTimeout_usec;
+    uint32_t _repeatInterval_msec;
+
+    uint32_t _sent_usec[HID_MAX_IN_FLIGHT];  // send time per notification awaiting completion, oldest first
+    uint8_t _inFlight;
+
+    hidReport_t _report;       // offered by next(), committed by sent()
+    bool _offered;
+    bool _retry;               // _report refused by the stack; offer it again
+    bool _releasePending;      // press sent; its release goes next
+    halKey_t _pressedKey;
+    bool _wasFull;
+
+    bool _repeating;
+    halKey_t _repeatKey;
+    uint32_t _nextRepeat_msec;
+
+    hidPipelineStats_t _stats;
+};
+
+#endif  // end header guard
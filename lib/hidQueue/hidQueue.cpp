@@ -0,0 +1,211 @@
+/*
+ * *************************************************************
+ * hidQueue.cpp - implementation file for bounded HID event queue
+ *
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include "hidQueue.h"
+
+#include <string.h>
+
+static int16_t stepsOf(int16_t steps) {
+    return steps < 0 ? -steps : steps;
+}
+
+// HidEventQueue constructor; all times in msec
+HidEventQueue::HidEventQueue(uint32_t maxAge_msec, uint32_t maxLatency_msec, uint32_t sendGap_msec,
+                             uint32_t reconnectSettle_msec)
+    : _maxAge_msec(maxAge_msec),
+      _maxLatency_msec(maxLatency_msec),
+      _sendGap_msec(sendGap_msec),
+      _reconnectSettle_msec(reconnectSettle_msec),
+      _head(0),
+      _count(0),
+      _wasConnected(false),
+      _nextSend_msec(0) {
+    resetStats();
+}
+
+void HidEventQueue::resetStats() {
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+void HidEventQueue::clear() {
+    _head = 0;
+    _count = 0;
+}
+
+// removes the oldest entry, adding its remaining presses to counter
+void HidEventQueue::discardHead(uint32_t& counter) {
+    counter += stepsOf(entry(0).steps);
+    _head = (_head + 1) % HID_QUEUE_SIZE;
+    _count--;
+}
+
+void HidEventQueue::expire(uint32_t now_msec) {
+    while ((_count > 0) && ((now_msec - entry(0).last_msec) > _maxAge_msec)) {
+        discardHead(_stats.expired);
+    }
+}
+
+// connected: drops entries whose newest press has waited longer than the latency bound;
+//   replay entries (deferred) are only subject to the maximum age
+void HidEventQueue::dropStale(uint32_t now_msec) {
+    while ((_maxLatency_msec != 0) && (_count > 0) && !entry(0).deferred &&
+           ((now_msec - entry(0).last_msec) > _maxLatency_msec)) {
+        discardHead(_stats.stale);
+    }
+}
+
+/*****************************************************************************
+Description : Queues a key press.  An arrow key landing on an arrow key entry
+                at the tail is merged into its net step count (down + up
+                cancel); a full queue discards its oldest entry.
+
+Input Value : key, now_msec, connected - current BLE link state
+Return Value: -
+********************************************************************************/
+void HidEventQueue::push(halKey_t key, uint32_t now_msec, bool connected) {
+    bool navigation = (key != HAL_KEY_MEDIA_EJECT);
+    int16_t step = (key == HAL_KEY_UP_ARROW) ? -1 : 1;
+
+    _stats.queued++;
+    expire(now_msec);
+
+    if (navigation && (_count > 0)) {
+        hidEntry_t& tail = entry(_count - 1);
+        if (tail.navigation) {
+            tail.steps += step;
+            tail.last_msec = now_msec;
+            tail.deferred |= !connected;
+            _stats.coalesced++;
+            if (tail.steps == 0) {  // net zero page turns, nothing left to send
+                _count--;
+            }
+            return;
+        }
+    }
+
+    if (_count == HID_QUEUE_SIZE) {
+        discardHead(_stats.dropped);
+    }
+    hidEntry_t& tail = entry(_count);
+    tail.navigation = navigation;
+    tail.steps = step;
+    tail.first_msec = now_msec;
+    tail.last_msec = now_msec;
+    tail.deferred = !connected;
+    tail.started = false;
+    _count++;
+    if (_count > _stats.maxDepth) {
+        _stats.maxDepth = _count;
+    }
+}
+
+/*****************************************************************************
+Description : Takes the next key to send, if one is due.  Nothing is released
+                while disconnected, until the link has settled after a
+                reconnect (central subscribing to HID reports), or within
+                the send gap of the previous key.  Keys held up past the
+                latency bound on a live link are dropped (counted as stale).
+
+Input Value : now_msec, connected - current BLE link state
+Return Value: true with key set if the caller should send key now
+********************************************************************************/
+bool HidEventQueue::next(uint32_t now_msec, bool connected, halKey_t& key) {
+    expire(now_msec);
+
+    if (!connected) {
+        _wasConnected = false;
+        for (int i = 0; i < _count; i++) {
+            entry(i).deferred = true;
+        }
+        return false;
+    }
+    if (!_wasConnected) {
+        _wasConnected = true;
+        _nextSend_msec = now_msec + _reconnectSettle_msec;
+    }
+    dropStale(now_msec);
+    if ((_count == 0) || ((int32_t)(now_msec - _nextSend_msec) < 0)) {
+        return false;
+    }
+
+    hidEntry_t& head = entry(0);
+    if (!head.navigation) {
+        key = HAL_KEY_MEDIA_EJECT;
+        head.steps = 0;
+    } else if (head.steps > 0) {
+        key = HAL_KEY_DOWN_ARROW;
+        head.steps--;
+    } else {
+        key = HAL_KEY_UP_ARROW;
+        head.steps++;
+    }
+
+    _stats.sent++;
+    if (head.deferred) {
+        _stats.replayed++;
+        if (!head.started) {
+            _stats.lastReplay_msec = now_msec - head.first_msec;
+            if (_stats.lastReplay_msec > _stats.maxReplay_msec) {
+                _stats.maxReplay_msec = _stats.lastReplay_msec;
+            }
+        }
+    }
+    head.started = true;
+
+    if (head.steps == 0) {
+        _head = (_head + 1) % HID_QUEUE_SIZE;
+        _count--;
+    }
+    _nextSend_msec = now_msec + _sendGap_msec;
+    return true;
+}
+
+/*****************************************************************************
+Description : Puts a key taken by next() back at the head of the queue, eg a
+                press the stack refused just before the link dropped.  It is
+                replayed first after reconnect, merged into an arrow key
+                entry at the head.  Its press time is lost, so it ages from
+                now; a full queue drops it (the queue discards oldest first).
+
+Input Value : key, now_msec
+Return Value: -
+********************************************************************************/
+void HidEventQueue::requeue(halKey_t key, uint32_t now_msec) {
+    bool navigation = (key != HAL_KEY_MEDIA_EJECT);
+    int16_t step = (key == HAL_KEY_UP_ARROW) ? -1 : 1;
+
+    _stats.sent--;  // taken back, not delivered
+    if (navigation && (_count > 0) && entry(0).navigation) {
+        hidEntry_t& head = entry(0);
+        head.steps += step;
+        head.deferred = true;
+        if (head.steps == 0) {  // cancels the next page turn out; nothing left to send
+            _head = (_head + 1) % HID_QUEUE_SIZE;
+            _count--;
+        }
+        return;
+    }
+    if (_count == HID_QUEUE_SIZE) {
+        _stats.dropped++;
+        return;
+    }
+    _head = (_head + HID_QUEUE_SIZE - 1) % HID_QUEUE_SIZE;
+    _count++;
+    hidEntry_t& head = entry(0);
+    head.navigation = navigation;
+    head.steps = step;
+    head.first_msec = now_msec;
+    head.last_msec = now_msec;
+    head.deferred = true;
+    head.started = false;
+    if (_count > _stats.maxDepth) {
+        _stats.maxDepth = _count;
+    }
+}
@@ -0,0 +1,88 @@
+/*
+ * *************************************************************
+ * hidQueue.h - Header file for bounded HID event queue
+ *
+ *   Sits between gesture recognition and the BLE keyboard.  Page down / page
+ *   up presses are coalesced into a net step count, presses older than a
+ *   maximum age are discarded, and whatever is left is replayed in order
+ *   (paced, one key per send gap) once the BLE link is back.  While the link
+ *   is up, keys still queued longer than maxLatency (a slow or congested
+ *   link) are dropped instead: a page turn that late is worse than none.
+ *   Only the input task pushes and pops, so there is no locking; entries are
+ *   held in place in a HID_QUEUE_SIZE ring and the caller passes in the
+ *   clock and link state, which is how tools/hidBench drives it on a host.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef HID_QUEUE_H  // begin header guard
+#define HID_QUEUE_H
+
+#include <stdint.h>
+
+#include "hal.h"  // halKey_t
+
+constexpr int HID_QUEUE_SIZE = 8;  // entries; a run of arrow keys only ever uses one
+
+// counters for the serial monitor; press counts, not entries
+struct hidQueueStats_t {
+    uint32_t queued;     // presses pushed
+    uint32_t coalesced;  // presses merged into an existing page turn entry
+    uint32_t sent;       // key reports handed to the keyboard
+    uint32_t replayed;   // key reports sent after waiting out a disconnect
+    uint32_t dropped;    // presses lost to a full queue (oldest entry discarded)
+    uint32_t expired;    // presses discarded as older than the maximum age
+    uint32_t stale;      // presses dropped while connected, queued longer than the maximum latency
+    uint32_t lastReplay_msec;  // press -> send time of the most recent replayed entry
+    uint32_t maxReplay_msec;
+    uint16_t maxDepth;
+};
+
+class HidEventQueue {
+   public:
+    HidEventQueue(uint32_t maxAge_msec, uint32_t maxLatency_msec, uint32_t sendGap_msec,
+                  uint32_t reconnectSettle_msec);  // constructor prototype; maxLatency 0 = no bound
+
+    // method prototypes:
+    void push(halKey_t key, uint32_t now_msec, bool connected);
+    bool next(uint32_t now_msec, bool connected, halKey_t& key);
+    void requeue(halKey_t key, uint32_t now_msec);  // key from next() that was never delivered
+    void clear();
+
+    bool isEmpty() const { return _count == 0; }
+    uint16_t depth() const { return _count; }
+    const hidQueueStats_t& stats() const { return _stats; }
+    void resetStats();
+
+   private:
+    struct hidEntry_t {
+        bool navigation;      // arrow keys; steps > 0 = down arrows, < 0 = up arrows
+        int16_t steps;        // eject entries always 1
+        uint32_t first_msec;  // oldest press in the entry (replay latency)
+        uint32_t last_msec;   // newest press in the entry (age limit)
+        bool deferred;        // queued or held while the link was down
+        bool started;         // at least one key of the entry sent
+    };
+
+    hidEntry_t& entry(int index) { return _entry[(_head + index) % HID_QUEUE_SIZE]; }
+    void discardHead(uint32_t& counter);
+    void expire(uint32_t now_msec);
+    void dropStale(uint32_t now_msec);
+
+    uint32_t _maxAge_msec;
+    uint32_t _maxLatency_msec;
+    uint32_t _sendGap_msec;
+    uint32_t _reconnectSettle_msec;
+
+    hidEntry_t _entry[HID_QUEUE_SIZE];
+    uint16_t _head;
+    uint16_t _count;
+
+    bool _wasConnected;
+    uint32_t _nextSend_msec;
+    hidQueueStats_t _stats;
+};
+
+#endif  // end header guard
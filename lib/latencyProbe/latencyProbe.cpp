@@ -0,0 +1,149 @@
+/*
+ * *************************************************************
+ * latencyProbe.cpp - implementation file for press-to-HID latency instrumentation
+ *
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include "latencyProbe.h"
+
+#include <string.h>
+
+LatencyProbe latencyProbe;
+
+// LatencyProbe constructor; histograms start empty
+LatencyProbe::LatencyProbe() : _inFlight(LATENCY_SINGLE), _active(false) {
+    reset();
+}
+
+void LatencyProbe::reset() {
+    memset(_histogram, 0, sizeof(_histogram));
+    _active = false;
+}
+
+/*****************************************************************************
+Purpose     : Opens a latency sample once the press type is known
+
+Input Value : gesture - press type being timed
+              edge_usec - ISR timestamp of the press edge that started the gesture
+              classified_usec - time the classifier reported it
+Return Value: -
+********************************************************************************/
+void LatencyProbe::gesture(latencyGesture_t gesture, uint32_t edge_usec, uint32_t classified_usec) {
+    _inFlight = gesture;
+    _active = true;
+    _stage_usec[STAGE_EDGE] = edge_usec;
+    _stage_usec[STAGE_CLASSIFIED] = classified_usec;
+    _stage_usec[STAGE_DISPATCH] = classified_usec;
+}
+
+/*****************************************************************************
+Purpose     : Records a stage time; STAGE_HID_DONE closes the sample and adds
+                edge -> HID_DONE to the gesture's histogram
+
+Input Value : stage, now_usec
+Return Value: -
+********************************************************************************/
+void LatencyProbe::mark(latencyStage_t stage, uint32_t now_usec) {
+    if (!_active) {
+        return;
+    }
+    _stage_usec[stage] = now_usec;
+    if (stage != STAGE_HID_DONE) {
+        return;
+    }
+
+    latencyHistogram_t& h = _histogram[_inFlight];
+    uint32_t total_usec = now_usec - _stage_usec[STAGE_EDGE];
+
+    h.count[bucketIndex(total_usec)]++;
+    h.samples++;
+    if (total_usec > h.max_usec) {
+        h.max_usec = total_usec;
+    }
+    for (int s = STAGE_CLASSIFIED; s < STAGE_COUNT; s++) {
+        h.stageSum_usec[s] += _stage_usec[s] - _stage_usec[s - 1];
+    }
+    _active = false;
+}
+
+/*****************************************************************************
+Purpose     : Approximate percentile from the histogram (upper edge of bucket)
+
+Input Value : gesture, percent (0 - 100)
+Return Value: latency in usec; 0 if no samples
+********************************************************************************/
+uint32_t LatencyProbe::percentile(latencyGesture_t gesture, uint8_t percent) const {
+    const latencyHistogram_t& h = _histogram[gesture];
+    if (h.samples == 0) {
+        return 0;
+    }
+    uint32_t target = ((uint32_t)h.samples * percent + 99) / 100;  // rank, rounded up
+    if (target == 0) {
+        target = 1;
+    }
+    uint32_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += h.count[i];
+        if (seen >= target) {
+            uint32_t upper = bucketUpperBound(i);
+            return upper < h.max_usec ? upper : h.max_usec;
+        }
+    }
+    return h.max_usec;
+}
+
+// 0..3 usec exact, then 4 buckets per power of 2
+int LatencyProbe::bucketIndex(uint32_t usec) {
+    if (usec < 4) {
+        return (int)usec;
+    }
+    int msb = 31 - __builtin_clz(usec);
+    int index = (msb - 1) * 4 + (int)((usec >> (msb - 2)) & 3);
+    return index < LATENCY_BUCKETS ? index : LATENCY_BUCKETS - 1;
+}
+
+uint32_t LatencyProbe::bucketUpperBound(int index) {
+    if (index < 4) {
+        return (uint32_t)index;
+    }
+    int msb = index / 4 + 1;
+    uint32_t lower = (uint32_t)(4 + index % 4) << (msb - 2);
+    return lower + (1UL << (msb - 2)) - 1;
+}
+
+#if defined(ARDUINO) || defined(FLIPTURN_NATIVE_ARDUINO)  // Arduino core, or its [env:native] stand-in
+
+#include <Arduino.h>
+
+static const char* const gestureName[LATENCY_GESTURE_COUNT] = {"single", "double", "hold", "chord"};
+
+/*****************************************************************************
+Purpose     : Prints percentile summary + mean stage breakdown per press type
+
+Input Value : out - eg Serial
+Return Value: -
+********************************************************************************/
+void printLatencySummary(Print& out) {
+    out.println(F("press -> HID latency (usec)"));
+    out.println(F("gesture     n     p50     p90     p99     max | classify dispatch  hid"));
+    for (int g = 0; g < LATENCY_GESTURE_COUNT; g++) {
+        const latencyHistogram_t& h = latencyProbe.histogram((latencyGesture_t)g);
+        uint32_t n = h.samples ? h.samples : 1;
+        out.printf("%-7s %5u %7u %7u %7u %7u | %8u %8u %4u\r\n",
+                   gestureName[g],
+                   h.samples,
+                   latencyProbe.percentile((latencyGesture_t)g, 50),
+                   latencyProbe.percentile((latencyGesture_t)g, 90),
+                   latencyProbe.percentile((latencyGesture_t)g, 99),
+                   h.max_usec,
+                   h.stageSum_usec[STAGE_CLASSIFIED] / n,
+                   h.stageSum_usec[STAGE_DISPATCH] / n,
+                   h.stageSum_usec[STAGE_HID_DONE] / n);
+    }
+}
+
+#endif  // ARDUINO || FLIPTURN_NATIVE_ARDUINO
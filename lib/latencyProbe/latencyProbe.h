@@ -0,0 +1,92 @@
+/*
+ * *************************************************************
+ * latencyProbe.h - Header file for press-to-HID latency instrumentation
+ *
+ *   Timestamps each stage of a page turn:
+ *     EDGE        foot switch press edge (ISR capture time)
+ *     CLASSIFIED  press type decided in Press_Type::update()
+ *     DISPATCH    gesture about to be queued for the HID pipeline
+ *     HID_DONE    press report of the first key accepted by the BLE stack
+ *   and keeps a fixed-size log-scale histogram of edge -> HID_DONE per press type.
+ *
+ *   Build with -D FLIPTURN_LATENCY_PROBE=0 to compile every LATENCY_* macro to nothing.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef LATENCY_PROBE_H  // begin header guard
+#define LATENCY_PROBE_H
+
+#include <stdint.h>
+
+#ifndef FLIPTURN_LATENCY_PROBE
+#define FLIPTURN_LATENCY_PROBE 1  // cheap enough (a few dozen cycles per press) to leave in production
+#endif
+
+enum latencyGesture_t { LATENCY_SINGLE,
+                        LATENCY_DOUBLE,
+                        LATENCY_HOLD,
+                        LATENCY_CHORD,
+                        LATENCY_GESTURE_COUNT };
+
+enum latencyStage_t { STAGE_EDGE,
+                      STAGE_CLASSIFIED,
+                      STAGE_DISPATCH,
+                      STAGE_HID_DONE,
+                      STAGE_COUNT };
+
+// histogram: 4 buckets per octave of microseconds, 1 usec .. ~16 sec; <= 25% bucket width
+constexpr int LATENCY_BUCKETS = 92;
+
+struct latencyHistogram_t {
+    uint16_t count[LATENCY_BUCKETS];
+    uint32_t samples;
+    uint32_t max_usec;
+    uint32_t stageSum_usec[STAGE_COUNT];  // per stage (time since previous stage), for mean breakdown
+};
+
+class LatencyProbe {
+   public:
+    LatencyProbe();  // constructor prototype
+
+    // method prototypes:
+    void gesture(latencyGesture_t gesture, uint32_t edge_usec, uint32_t classified_usec);
+    void mark(latencyStage_t stage, uint32_t now_usec);
+    void reset();
+
+    uint32_t percentile(latencyGesture_t gesture, uint8_t percent) const;
+    const latencyHistogram_t& histogram(latencyGesture_t gesture) const { return _histogram[gesture]; }
+
+    static int bucketIndex(uint32_t usec);
+    static uint32_t bucketUpperBound(int index);
+
+   private:
+    latencyHistogram_t _histogram[LATENCY_GESTURE_COUNT];
+    latencyGesture_t _inFlight;
+    bool _active;
+    uint32_t _stage_usec[STAGE_COUNT];
+};
+
+extern LatencyProbe latencyProbe;
+
+#if defined(ARDUINO) || defined(FLIPTURN_NATIVE_ARDUINO)  // Arduino core, or its [env:native] stand-in
+class Print;
+void printLatencySummary(Print& out);  // serial command 'l'
+#endif
+
+// instrumentation macros - vanish when FLIPTURN_LATENCY_PROBE is 0
+#if FLIPTURN_LATENCY_PROBE
+#define LATENCY_GESTURE(type, edge_usec, classified_usec) latencyProbe.gesture((type), (edge_usec), (classified_usec))
+#define LATENCY_MARK(stage) latencyProbe.mark((stage), halMicros())
+#else
+#define LATENCY_GESTURE(type, edge_usec, classified_usec) \
+    do {                                                   \
+    } while (0)
+#define LATENCY_MARK(stage) \
+    do {                    \
+    } while (0)
+#endif  // FLIPTURN_LATENCY_PROBE
+
+#endif  // end header guard
@@ -0,0 +1,113 @@
+/*
+ * *************************************************************
+ * logger.cpp - implementation file for deferred ring-buffer logger
+ *
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include "logger.h"
+
+#include <stdio.h>
+
+#include "hal.h"  // time + non-blocking serial output
+
+Logger logger;
+
+static const char levelTag[] = {'-', 'E', 'W', 'I', 'D'};
+
+// Logger constructor
+Logger::Logger() : _lineLength(0), _lineSent(0), _reportedDrops(0) {
+}
+
+uint32_t Logger::now_msec() {
+    return halMillis();
+}
+
+int Logger::ringIndex() {
+    return halCoreId() & (LOG_RINGS - 1);
+}
+
+uint32_t Logger::dropped() const {
+    uint32_t drops = 0;
+    for (int i = 0; i < LOG_RINGS; i++) {
+        drops += _ring[i].dropped();
+    }
+    return drops;
+}
+
+uint16_t Logger::pending() const {
+    uint16_t records = 0;
+    for (int i = 0; i < LOG_RINGS; i++) {
+        records += _ring[i].size();
+    }
+    return records;
+}
+
+// formats the next record (or a dropped-records notice) into _line; false if nothing to format
+bool Logger::formatNext() {
+    uint32_t drops = dropped();
+    if (drops != _reportedDrops) {
+        _lineLength = snprintf(_line, sizeof(_line), "[%lu] W logger: %lu records dropped\r\n",
+                               (unsigned long)halMillis(), (unsigned long)(drops - _reportedDrops));
+        _reportedDrops = drops;
+    } else {
+        // oldest record across the per-core rings first
+        logRecord_t record, candidate;
+        int oldest = -1;
+        for (int i = 0; i < LOG_RINGS; i++) {
+            if (_ring[i].peek(candidate) && ((oldest < 0) || ((int32_t)(candidate.time_msec - record.time_msec) < 0))) {
+                record = candidate;
+                oldest = i;
+            }
+        }
+        if (oldest < 0) {
+            return false;
+        }
+        _ring[oldest].pop(record);
+        int prefix = snprintf(_line, sizeof(_line), "[%lu] %c ", (unsigned long)record.time_msec,
+                              levelTag[record.level < sizeof(levelTag) ? record.level : 0]);
+        int body = snprintf(_line + prefix, sizeof(_line) - prefix - 2, record.format,
+                            record.arg[0], record.arg[1], record.arg[2], record.arg[3]);
+        _lineLength = prefix + (body < (int)(sizeof(_line) - prefix - 2) ? body : (int)(sizeof(_line) - prefix - 3));
+        _line[_lineLength++] = '\r';
+        _line[_lineLength++] = '\n';
+    }
+    _lineSent = 0;
+    return true;
+}
+
+/*****************************************************************************
+Description : Writes pending log output to serial without blocking - stops as
+                soon as the UART tx buffer is full.  Call when loop() is idle.
+
+Input Value : -
+Return Value: true if log output is still pending
+********************************************************************************/
+bool Logger::drain() {
+    for (;;) {
+        if (_lineSent >= _lineLength) {
+            if (!formatNext()) {
+                return false;
+            }
+        }
+        int room = halSerialWritable();
+        if (room <= 0) {
+            return true;
+        }
+        int chunk = _lineLength - _lineSent;
+        if (chunk > room) {
+            chunk = room;
+        }
+        halSerialWrite(_line + _lineSent, chunk);
+        _lineSent += chunk;
+    }
+}
+
+// blocking drain; only for paths where latency no longer matters (eg before deep sleep)
+void Logger::flush() {
+    while (drain()) {
+    }
+}
@@ -0,0 +1,150 @@
+/*
+ * *************************************************************
+ * logger.h - Header file for deferred ring-buffer logger
+ *
+ *   LOG_xxx() on the hot path only copies a small binary record (timestamp,
+ *   level, pointer to the format string literal, up to 4 integer args) into
+ *   a lock-free ring buffer.  Formatting and serial output happen later in
+ *   logger.drain(), called when loop() has nothing else to do, and only
+ *   write as much as the UART tx buffer can take without blocking.
+ *
+ *   Compile-time log level per module:
+ *     #define LOG_MODULE_LEVEL LOG_LEVEL_FLIPSTATE   // before #include "logger.h"
+ *   Messages above the module level compile to nothing (no flash, no cycles).
+ *   Override levels with build_flags, eg  -D LOG_LEVEL_FLIPSTATE=LOG_LEVEL_DEBUG
+ *
+ *   Format args are stored as integers: use %d / %u / %ld / %lu / %x / %c, and
+ *   %s only for pointers to string literals (pointer is printed later).
+ *   No floats - log millivolts etc instead.
+ *
+ *   One ring per CPU core, so each ring has a single producer: at most one
+ *   logging task per core, and never log from an ISR.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef LOGGER_H  // begin header guard
+#define LOGGER_H
+
+#include <stdint.h>
+
+#include "spscQueue.h"
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// per module default levels
+#ifndef LOG_LEVEL_MAIN
+#define LOG_LEVEL_MAIN LOG_LEVEL_INFO
+#endif
+#ifndef LOG_LEVEL_FLIPSTATE
+#define LOG_LEVEL_FLIPSTATE LOG_LEVEL_INFO
+#endif
+#ifndef LOG_LEVEL_PRESS_TYPE
+#define LOG_LEVEL_PRESS_TYPE LOG_LEVEL_INFO
+#endif
+#ifndef LOG_LEVEL_BATTERY
+#define LOG_LEVEL_BATTERY LOG_LEVEL_INFO
+#endif
+
+constexpr uint16_t LOG_RING_SIZE = 64;  // records per core (power of 2); ~28 bytes each on ESP32
+constexpr int LOG_RINGS = 2;            // one per ESP32 core
+constexpr int LOG_MAX_ARGS = 4;
+constexpr int LOG_LINE_LENGTH = 128;
+
+struct logRecord_t {
+    uint32_t time_msec;
+    const char* format;  // string literal; never copied
+    intptr_t arg[LOG_MAX_ARGS];
+    uint8_t level;
+};
+
+class Logger {
+   public:
+    Logger();  // constructor prototype
+
+    template <typename... Args>
+    void log(uint8_t level, const char* format, Args... args) {
+        static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "logger: at most 4 format arguments");
+        logRecord_t record;
+        record.time_msec = now_msec();
+        record.format = format;
+        record.level = level;
+        intptr_t values[LOG_MAX_ARGS + 1] = {(intptr_t)args...};  // +1 keeps the array non-empty for zero args
+        for (int i = 0; i < LOG_MAX_ARGS; i++) {
+            record.arg[i] = values[i];
+        }
+        _ring[ringIndex()].push(record);  // full ring: record dropped and counted, never blocks
+    }
+
+    // method prototypes:
+    bool drain();
+    void flush();
+    uint32_t dropped() const;
+    uint16_t pending() const;
+
+   private:
+    static uint32_t now_msec();
+    static int ringIndex();
+    bool formatNext();
+
+    SpscQueue<logRecord_t, LOG_RING_SIZE> _ring[LOG_RINGS];
+    char _line[LOG_LINE_LENGTH];
+    int _lineLength;
+    int _lineSent;
+    uint32_t _reportedDrops;
+};
+
+extern Logger logger;
+
+#endif  // end header guard
+
+/******************************************************
+// Per module macros - deliberately outside the header guard so each
+//   translation unit gets them for its own LOG_MODULE_LEVEL
+******************************************************/
+#ifndef LOG_MODULE_LEVEL
+#define LOG_MODULE_LEVEL LOG_LEVEL_INFO
+#endif
+
+#undef LOG_ERROR
+#undef LOG_WARN
+#undef LOG_INFO
+#undef LOG_DEBUG
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) logger.log(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) \
+    do {               \
+    } while (0)
+#endif
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) logger.log(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) \
+    do {              \
+    } while (0)
+#endif
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) logger.log(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) \
+    do {              \
+    } while (0)
+#endif
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) logger.log(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) \
+    do {               \
+    } while (0)
+#endif
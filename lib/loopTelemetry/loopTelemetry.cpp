@@ -0,0 +1,128 @@
+/*
+ * *************************************************************
+ * loopTelemetry.cpp - implementation file for task loop telemetry
+ *
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include "loopTelemetry.h"
+
+// LoopTelemetry constructor; stageNames must outlive the object (string literals)
+LoopTelemetry::LoopTelemetry(const char* const* stageNames,
+                             int stageCount) : _stageNames(stageNames),
+                                               _stageCount(stageCount < TELEMETRY_MAX_STAGES ? stageCount : TELEMETRY_MAX_STAGES),
+                                               _resetRequested(false) {
+    clear();
+}
+
+void LoopTelemetry::clear() {
+    _running = false;
+    _begin_usec = 0;
+    _mark_cycles = 0;
+    _cycles = 0;
+    _maxPeriod_usec = 0;
+    _busy_usec = 0;
+    _elapsed_usec = 0;
+    for (int b = 0; b < TELEMETRY_PERIOD_BUCKETS; b++) {
+        _periodCount[b] = 0;
+    }
+    for (int s = 0; s < TELEMETRY_MAX_STAGES; s++) {
+        _stage[s].count = 0;
+        _stage[s].max_cycles = 0;
+        _stage[s].total_cycles = 0;
+    }
+}
+
+static int periodBucket(uint32_t period_usec) {
+    int octave = (period_usec == 0) ? 0 : 32 - __builtin_clz(period_usec);  // bits needed
+    int bucket = octave - TELEMETRY_PERIOD_FIRST_OCTAVE;
+    if (bucket < 0) {
+        return 0;
+    }
+    return bucket < TELEMETRY_PERIOD_BUCKETS ? bucket : TELEMETRY_PERIOD_BUCKETS - 1;
+}
+
+/*****************************************************************************
+Description : Start of a pass - records the period since the previous pass and
+                takes the first stage mark
+
+Input Value : now_usec, now_cycles - halMicros(), halCycleCount()
+Return Value: -
+********************************************************************************/
+void LoopTelemetry::beginCycle(uint32_t now_usec, uint32_t now_cycles) {
+    if (_resetRequested) {
+        clear();
+        _resetRequested = false;
+    }
+    if (_running) {
+        uint32_t period_usec = now_usec - _begin_usec;
+        _elapsed_usec += period_usec;
+        if (period_usec > _maxPeriod_usec) {
+            _maxPeriod_usec = period_usec;
+        }
+        _periodCount[periodBucket(period_usec)]++;
+    }
+    _running = true;
+    _begin_usec = now_usec;
+    _mark_cycles = now_cycles;
+}
+
+void LoopTelemetry::stage(int index, uint32_t now_cycles) {
+    uint32_t spent = now_cycles - _mark_cycles;  // 32 bit counter: wraps every ~18 s at 240 MHz, fine per stage
+    _mark_cycles = now_cycles;
+    if ((index < 0) || (index >= _stageCount)) {
+        return;
+    }
+    telemetryStage_t& s = _stage[index];
+    s.count++;
+    s.total_cycles += spent;
+    if (spent > s.max_cycles) {
+        s.max_cycles = spent;
+    }
+}
+
+void LoopTelemetry::endCycle(uint32_t now_usec) {
+    if (_running) {
+        _busy_usec += now_usec - _begin_usec;
+        _cycles++;
+    }
+}
+
+/*****************************************************************************
+Description : Loop period percentile from the histogram
+
+Input Value : percent - 1 to 100
+Return Value: upper bound (usec) of the bucket holding that percentile; the max
+                period for the last bucket; 0 before two passes
+********************************************************************************/
+uint32_t LoopTelemetry::periodPercentile_usec(int percent) const {
+    uint32_t total = 0;
+    for (int b = 0; b < TELEMETRY_PERIOD_BUCKETS; b++) {
+        total += _periodCount[b];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    uint32_t rank = (uint32_t)(((uint64_t)total * percent + 99) / 100);
+    uint32_t seen = 0;
+    for (int b = 0; b < TELEMETRY_PERIOD_BUCKETS - 1; b++) {
+        seen += _periodCount[b];
+        if (seen >= rank) {
+            uint32_t bound_usec = (uint32_t)1 << (b + TELEMETRY_PERIOD_FIRST_OCTAVE);
+            return bound_usec < _maxPeriod_usec ? bound_usec : _maxPeriod_usec;
+        }
+    }
+    return _maxPeriod_usec;
+}
+
+// share of measured time spent outside beginCycle() .. endCycle(), in tenths of a percent
+uint16_t LoopTelemetry::idlePermille() const {
+    if (_elapsed_usec == 0) {
+        return 1000;
+    }
+    uint64_t busy = _busy_usec < _elapsed_usec ? _busy_usec : _elapsed_usec;
+    return (uint16_t)(1000 - (busy * 1000) / _elapsed_usec);
+}
@@ -0,0 +1,93 @@
+/*
+ * *************************************************************
+ * loopTelemetry.h - Header file for task loop telemetry
+ *
+ *   One LoopTelemetry per task loop.  Each pass records:
+ *     stage cost     CPU cycle counter between stage marks (count, total, max)
+ *     loop period    time between passes - max and a log2 histogram (percentiles)
+ *     idle estimate  share of wall time the task spent waiting, not working
+ *   A pass costs two halMicros() and one cycle count read per stage, so it is
+ *   left on in production.  Written by the task it measures only; read from
+ *   anywhere (values may be a pass out of date, never corrupt the writer).
+ *
+ *   Build with -D FLIPTURN_LOOP_TELEMETRY=0 to compile every TELEMETRY_* macro to nothing.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef LOOP_TELEMETRY_H  // begin header guard
+#define LOOP_TELEMETRY_H
+
+#include <stdint.h>
+
+#ifndef FLIPTURN_LOOP_TELEMETRY
+#define FLIPTURN_LOOP_TELEMETRY 1
+#endif
+
+constexpr int TELEMETRY_MAX_STAGES = 8;
+constexpr int TELEMETRY_PERIOD_BUCKETS = 16;       // one per octave of microseconds
+constexpr int TELEMETRY_PERIOD_FIRST_OCTAVE = 7;   // bucket 0 = under 128 usec, bucket 15 = 2 sec and over
+
+struct telemetryStage_t {
+    uint32_t count;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+};
+
+class LoopTelemetry {
+   public:
+    LoopTelemetry(const char* const* stageNames, int stageCount);  // constructor prototype
+
+    // method prototypes (task being measured):
+    void beginCycle(uint32_t now_usec, uint32_t now_cycles);  // after the task's wait
+    void stage(int index, uint32_t now_cycles);                // stage done: cycles since last mark
+    void endCycle(uint32_t now_usec);                          // before the task's next wait
+
+    // queries + reset (any task)
+    void reset() { _resetRequested = true; }  // applied by the measured task at its next pass
+    uint32_t cycles() const { return _cycles; }
+    uint32_t maxPeriod_usec() const { return _maxPeriod_usec; }
+    uint32_t periodPercentile_usec(int percent) const;  // bucket upper bound; 0 = no data
+    uint16_t idlePermille() const;
+    int stageCount() const { return _stageCount; }
+    const char* stageName(int index) const { return _stageNames[index]; }
+    const telemetryStage_t& stageStats(int index) const { return _stage[index]; }
+
+   private:
+    void clear();
+
+    const char* const* _stageNames;
+    int _stageCount;
+    volatile bool _resetRequested;
+    bool _running;  // a previous pass exists (period is measurable)
+
+    uint32_t _begin_usec;
+    uint32_t _mark_cycles;
+    uint32_t _cycles;
+    uint32_t _maxPeriod_usec;
+    uint32_t _periodCount[TELEMETRY_PERIOD_BUCKETS];
+    uint64_t _busy_usec;
+    uint64_t _elapsed_usec;
+    telemetryStage_t _stage[TELEMETRY_MAX_STAGES];
+};
+
+// instrumentation macros - vanish when FLIPTURN_LOOP_TELEMETRY is 0 (caller includes hal.h)
+#if FLIPTURN_LOOP_TELEMETRY
+#define TELEMETRY_CYCLE_BEGIN(telemetry) (telemetry).beginCycle(halMicros(), halCycleCount())
+#define TELEMETRY_STAGE(telemetry, index) (telemetry).stage((index), halCycleCount())
+#define TELEMETRY_CYCLE_END(telemetry) (telemetry).endCycle(halMicros())
+#else
+#define TELEMETRY_CYCLE_BEGIN(telemetry) \
+    do {                                 \
+    } while (0)
+#define TELEMETRY_STAGE(telemetry, index) \
+    do {                                  \
+    } while (0)
+#define TELEMETRY_CYCLE_END(telemetry) \
+    do {                               \
+    } while (0)
+#endif  // FLIPTURN_LOOP_TELEMETRY
+
+#endif  // end header guard
@@ -17,74 +17,24 @@
 #include <pins_arduino.h>
 #endif  // end if-block
 
-/*
- * ******************************************************
- *   Pin-out Summaries
- *     See github flipTurn wiki for schematic and hardware details
- * *******************************************************/
+#include "batterySaver.h"  // saverProfile_t for the battery saver levels
+#include "boardProfile.h"  // Board: pins, LED polarity, battery ADC
+#include "hal.h"           // halKey_t for the pedal key map
 
 /*
- *  DFR0478 (Firebeetle ESP32 Ver1) microcontroller pinout:
- *   Pin        Function    Comment
- *   -------    --------    -----------------------------------------------
- *   GND         GND        Split line ground between switch and RGB LED
- *   A0 (IO36)   BATT_PIN   Read battery voltage (must bridge Rx and Ry zero ohm resistor pads on Firebeetle voltage divider)
- *   D6 (IO10)   SWITCH_PIN Microswitch; enable built-in pullup resistor, eg pinMode(D6, INPUT_PULLUP);
- *   19 (IOxx)   R-LED      Red anode RGB LED (80 ohm current limiting resistor)
- *   23 (IOxx)   G-LED      Green anode RGB LED (12 ohm current limiting resistor)
- *   18 (IOxx )  B-LED      Blue anode RGB LED (12 ohm current limiting resistor)
- *  *******************************************************
- *    Note:  See Firebeetle pin mapping table for full board pin-out; pin number 35 is same as GPIO35 / IO35
- *
- *
- *   Initial prototype (this pin configuration not used in final device):
- *   -------    --------    -----------------------------------------------
- *   D2 (IO25)   R-LED      Red anode RGB LED (82 ohm current limiting resistor)
- *   D3 (IO26)   G-LED      Green anode RGB LED (12 ohm current limiting resistor)
- *   D4 (IO26 )  B-LED      Blue anode RGB LED (12 ohm current limiting resistor)
+ *   Pins, RGB LED polarity and battery ADC are per board: see boardProfile.h
  */
 
-//!  A0 Battery divider (GPIO36)
-//!  ----------------------------------------------
-//!   Another caveat is the usage of pin 36 A0 may conflict with wifi (note: not confirmed)
-//!   To avoid that, the battery must be measured before the wifi is activated.
-
-/*
- *  ************************************************************************************
- *   5mm RGB LED - Common Cathode   Source: AliExpress
- * 
- *    Pin    Function     Comment                       Current limiting resistor 
- *    ----   --------     ------------------------      -------------------------
- *    1      Red anode    Typ Vf (@ If=20mA) = 2.0V      82 ohm
- *    2      GND          Common Cathode
- *    3      Green anode  Typ Vf (@ If=20mA) = 3.2V      12 ohm
- *    4      Blue anode   Typ Vf (@ If=20mA) = 3.1V      12 ohm
- * ************************************************************************************/
-
 //******************************************************
 //? Constants
 //*******************************************************/
 
 // ---------------------------------------------------------
-// Pin set-up listed below are for nodeMCU ESP8266
 //? Note to self:  constexp better than const for variable values that should be known at compile
 //?    time -> more memory efficient.  Also better than simple #define
 //! cannot use "extern constexp", must use "const" instead, as with constexp "...it must be immediately constructed or assigned a value"
 // ---------------------------------------------------------
-constexpr int BATT_PIN = A0;    // Read battery voltage (must bridge Rx and Ry zero ohm resistor pads on Firebeetle voltage divider)
-constexpr int SWITCH_PIN = D6;  // microswitch (wired NO; need to enable internal pullup)
-
-// RGB pwm pin assignments
-constexpr int RED_LED_PIN = 19;    // GPIO15
-constexpr int GREEN_LED_PIN = 23;  // GPIO35
-constexpr int BLUE_LED_PIN = 18;   // GPIO34
 
-// ---------------------------------------------------------
-// Baudrate:  Recommend 74480 baud rate for ESP8266 devices to match ESP8266 fixed bootloader initialisation speed
-//  (otherwise you will get startup gibberish characters on serial monitor before serial speed syncs)
-//  https://forum.arduino.cc/t/serial-monitor-only-shows-strange-symbols-arduino-mega-with-esp8266/640490/5
-//  note: may have to manually reset board after flashing for code to work correctly
-// #define SERIAL_MONITOR_SPEED 74880  // change to constexpr
 constexpr int SERIAL_MONITOR_SPEED = 115200;
 
 //   battery operating ranges
@@ -92,11 +42,145 @@ constexpr float HIGH_BATTERY_VOLTAGE = 3.70;  // 4.2 - 3.7V battery "fully" char
 constexpr float CHARGE_NOW_VOLTAGE = 3.20;    // trigger voltage to warn that device requires charging
 constexpr float LOW_BATTERY_VOLTAGE = 3.00;   // lower bound battery operating range (DW01 battery protection circuit triggers at 2.4V )
 
+// battery monitor sampling; pack voltage changes over minutes so one reading per second is plenty
+constexpr uint32_t BATTERY_SAMPLE_INTERVAL_MSEC = 1000;
+constexpr int BATTERY_PRIME_ROUNDS = 11;      // readings averaged at boot to prime the filter
+constexpr uint8_t SOC_HYSTERESIS_PERCENT = 2;  // battery % sent to central only when estimate moves this much
+constexpr uint32_t TRACE_BATTERY_STEP_MV = 4;  // battery voltage written to the trace when it moves this much
+
+// foot switch gesture timing (see press_type / gestureClassifier)
+constexpr uint32_t SWITCH_DEBOUNCE_MSEC = 10;     // edges closer than this to the last accepted edge are contact bounce
+constexpr uint32_t DOUBLE_TAP_WINDOW_MSEC = 250;  // second press must start within this time of first release
+constexpr uint32_t HOLD_DURATION_MSEC = 600;      // press held this long = long press
+
+// low latency taps: send page down on first release rather than waiting out DOUBLE_TAP_WINDOW_MSEC;
+//   a double press then sends a compensating up arrow before the page up (net result unchanged)
+//   enable at build time with build_flags = -D FLIPTURN_LOW_LATENCY_TAPS=1, or at run time with
+//   button.setLowLatencyMode()
+#ifndef FLIPTURN_LOW_LATENCY_TAPS
+#define FLIPTURN_LOW_LATENCY_TAPS 0
+#endif
+constexpr bool LOW_LATENCY_TAPS = FLIPTURN_LOW_LATENCY_TAPS;
+
+// pedals (see press_type / pedalBank): one row per foot switch, wired NO to GND with internal pullup.
+//   All pedals are read from the GPIO input register in one scan.  Light sleep and auto-off
+//   wake only on the first pedal, so keep the main page turn pedal in row 0.
+//   holdRepeat: holding the pedal repeats tapKey (hold-to-scroll, HID_REPEAT_INTERVAL_MSEC)
+//   until release, instead of sending holdKey.
+struct pedalConfig_t {
+    int pin;
+    halKey_t tapKey, doubleKey, holdKey;
+    bool holdRepeat;
+};
+constexpr pedalConfig_t PEDALS[] = {
+    {Board::SWITCH_PIN, HAL_KEY_DOWN_ARROW, HAL_KEY_UP_ARROW, HAL_KEY_MEDIA_EJECT, false},
+    // eg a second "page back" pedal that scrolls back while held:  {25, HAL_KEY_UP_ARROW, HAL_KEY_DOWN_ARROW, HAL_KEY_MEDIA_EJECT, true},
+};
+constexpr int PEDAL_COUNT = sizeof(PEDALS) / sizeof(PEDALS[0]);
+
+// chords: pedals (bit p = PEDALS[p]) pressed within CHORD_WINDOW_MSEC of each other send one key
+//   instead of their own gestures.  Mask 0 = unused row (needs two or more pedals).
+struct chordConfig_t {
+    uint8_t pedalMask;
+    halKey_t key;
+};
+constexpr chordConfig_t CHORDS[] = {
+    {0, HAL_KEY_MEDIA_EJECT},  // eg {0b011, HAL_KEY_MEDIA_EJECT} with two pedals
+};
+constexpr int CHORD_COUNT = sizeof(CHORDS) / sizeof(CHORDS[0]);
+constexpr uint32_t CHORD_WINDOW_MSEC = 80;  // "together" for a foot; well under a deliberate double tap
+
+constexpr bool chordsFitPedals(int i = 0) {
+    return (i >= CHORD_COUNT) || (((CHORDS[i].pedalMask >> PEDAL_COUNT) == 0) && chordsFitPedals(i + 1));
+}
+static_assert((PEDAL_COUNT >= 1) && (PEDAL_COUNT <= 8), "1 to 8 pedals (see MAX_PEDALS)");
+static_assert(chordsFitPedals(), "CHORDS pedalMask refers to a pedal not in PEDALS");
+
+// BLE connection parameters: drop to the long (low power) interval after this much foot switch inactivity
+constexpr uint32_t CONN_IDLE_AFTER_MSEC = 20000;   // 20 seconds
+constexpr uint32_t CONN_UPDATE_RETRY_MSEC = 5000;  // wait before re-requesting parameters the central rejected
+
+// BLE advertising schedule (see advSchedule) while disconnected
+constexpr uint32_t ADV_DIRECTED_MSEC = 1280;  // high duty directed to last bonded central; BLE spec maximum (0 = skip)
+constexpr uint32_t ADV_FAST_MSEC = 30000;     // 20 ms undirected, then ~1 s interval until connected
+
+// FreeRTOS task split: input capture / gesture / HID on one core, battery / LED / logging on the other
+constexpr int INPUT_TASK_CORE = 1;         // APP_CPU; Bluedroid host runs on PRO_CPU (core 0)
+constexpr int INPUT_TASK_PRIORITY = 5;     // above Arduino loopTask (1)
+constexpr int BACKGROUND_TASK_CORE = 0;
+constexpr int BACKGROUND_TASK_PRIORITY = 1;
+constexpr uint32_t TASK_STACK_BYTES = 4096;
+constexpr uint32_t INPUT_IDLE_POLL_MSEC = 50;         // input task wake-up when no edge / timer pending
+constexpr uint32_t BACKGROUND_TASK_PERIOD_MSEC = 10;  // battery, LED, BLE params, serial + log drain
+constexpr int EVENT_DISPATCH_MAX_PER_PASS = 8;         // event bus: events handled per task pass, rest wait
+
+// stall watchdog (see stallWatchdog): longest pass per task, and how late a task may start its next pass
+constexpr uint32_t STALL_INPUT_BUDGET_USEC = 2000;         // gestures + HID report + power mode
+constexpr uint32_t STALL_INPUT_SLACK_USEC = 3000;
+constexpr uint32_t STALL_BACKGROUND_BUDGET_USEC = 10000;   // one BACKGROUND_TASK_PERIOD_MSEC
+constexpr uint32_t STALL_BACKGROUND_SLACK_USEC = 20000;
+
+// HID event queue (see hidQueue): presses made during a BLE dropout are replayed on reconnect
+constexpr uint32_t HID_EVENT_MAX_AGE_MSEC = 5000;     // older presses are stale - discarded rather than replayed
+constexpr uint32_t HID_MAX_LATENCY_MSEC = 1000;       // connected: keys queued longer (slow link) are dropped, not sent late
+constexpr uint32_t HID_SEND_GAP_MSEC = 0;             // minimum spacing between keys; 0 = paced by flow control only
+constexpr uint32_t HID_RECONNECT_SETTLE_MSEC = 1000;  // let central subscribe to HID reports before replaying
+
+// HID report pipeline (see hidPipeline): reports go out as fast as the BLE stack completes them
+constexpr uint8_t HID_MAX_OUTSTANDING = 4;              // notifications awaiting completion (2 per key)
+constexpr uint32_t HID_COMPLETION_TIMEOUT_MSEC = 1000;  // give up on a completion event after this long
+constexpr uint32_t HID_REPEAT_INTERVAL_MSEC = 125;      // hold-to-scroll rate: at most 8 keys a second
+static_assert(HID_MAX_OUTSTANDING >= 2, "a key is a press + release notification");
+
+// auto-off: deep sleep after long foot switch inactivity; pressing the switch wakes it (ext0)
+//   PEDALS[0] pin must be an RTC GPIO (0, 2, 4, 12-15, 25-27, 32-39) for wake; otherwise auto-off is disabled
+constexpr uint32_t AUTO_OFF_CONNECTED_MSEC = 30UL * 60 * 1000;    // 30 minutes without a page turn
+constexpr uint32_t AUTO_OFF_DISCONNECTED_MSEC = 5UL * 60 * 1000;  // 5 minutes with no central connected
+
+// power manager (see powerPolicy): full clock just after a press, then 80 MHz, then automatic light sleep
+constexpr int CPU_BOOST_MHZ = 240;
+constexpr int CPU_ECO_MHZ = 80;                        // lowest clock BLE (Bluedroid) supports
+constexpr uint32_t POWER_BOOST_MSEC = 2000;            // full clock for this long after the last activity
+constexpr uint32_t POWER_SLEEP_AFTER_MSEC = 10000;     // light sleep allowed after this much inactivity
+constexpr uint32_t POWER_SLEEP_POLL_MSEC = 500;        // input task wake-up while light sleep allowed
+constexpr uint32_t BACKGROUND_SLEEP_PERIOD_MSEC = 100;  // background task period while light sleep allowed
+
+// battery saver (see batterySaver): graded power saving as the reported charge falls.
+//   A press still boosts the clock and requests the short connection interval at every level.
+constexpr uint8_t SAVER_REDUCED_BELOW_PERCENT = 20;  // ~3.73V, ahead of the charge warning at 3.7V
+constexpr uint8_t SAVER_CRITICAL_BELOW_PERCENT = 5;  // ~3.61V
+constexpr uint8_t SAVER_HYSTERESIS_PERCENT = 5;      // climb back a level only this far above its threshold (charging)
+constexpr saverProfile_t SAVER_PROFILES[] = {
+    // level         name        boost MHz      boost             sleep after             BLE idle after        saver interval  battery sample                 LED %  LED time %
+    {SAVER_NORMAL,   "normal",   CPU_BOOST_MHZ, POWER_BOOST_MSEC, POWER_SLEEP_AFTER_MSEC, CONN_IDLE_AFTER_MSEC, false,          BATTERY_SAMPLE_INTERVAL_MSEC,  100,   100},
+    {SAVER_REDUCED,  "reduced",  160,           1000,             5000,                   10000,                false,          5000,                          50,    50},
+    {SAVER_CRITICAL, "critical", CPU_ECO_MHZ,   500,              2000,                   5000,                 true,           5000,                          25,    34},
+};
+
+constexpr bool saverProfilesValid(int i = 0) {
+    return (i >= SAVER_LEVEL_COUNT) ||
+           ((SAVER_PROFILES[i].level == i) && (SAVER_PROFILES[i].boostMhz >= CPU_ECO_MHZ) &&
+            (SAVER_PROFILES[i].boost_msec < SAVER_PROFILES[i].sleepAfter_msec) &&
+            (SAVER_PROFILES[i].ledBrightness_percent > 0) && (SAVER_PROFILES[i].ledBrightness_percent <= 100) &&
+            saverProfilesValid(i + 1));
+}
+static_assert(sizeof(SAVER_PROFILES) / sizeof(SAVER_PROFILES[0]) == SAVER_LEVEL_COUNT, "SAVER_PROFILES needs a row per saverLevel_t");
+static_assert(saverProfilesValid(), "SAVER_PROFILES rows in saverLevel_t order; boost clock >= BLE minimum; brightness 1 - 100%");
+static_assert(SAVER_CRITICAL_BELOW_PERCENT < SAVER_REDUCED_BELOW_PERCENT, "saver thresholds");
+
 // led status light duration
-constexpr float LED_DURATION_MSEC = 3000;  // 3 seconds
+constexpr uint32_t LED_DURATION_MSEC = 3000;  // 3 seconds
+
+// auto shut-down: red warning blink for this long before deep sleep (non-blocking; switch stays live)
+constexpr uint32_t SHUTDOWN_WARNING_MSEC = 10000;  // 10 seconds
 
-// startup delay
-constexpr float STARTUP_DELAY_MSEC = 4000;  // 4 seconds
+// boot LED self-test: cycle status colours before the battery status display
+//   enable with build_flags = -D FLIPTURN_LED_SELF_TEST=1
+#ifndef FLIPTURN_LED_SELF_TEST
+#define FLIPTURN_LED_SELF_TEST 0
+#endif
+constexpr bool LED_SELF_TEST = FLIPTURN_LED_SELF_TEST;
+constexpr uint32_t SELF_TEST_STEP_MSEC = 1000;  // time on each colour
 
 // *******************************************************
 //   Other constants
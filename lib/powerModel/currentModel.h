@@ -0,0 +1,186 @@
+/*
+ * *************************************************************
+ * currentModel.h - host builds: per-component current model
+ *
+ *   Rough ESP32 / LED figures turning what the simulated firmware is doing
+ *   (power mode, CPU clock, task wake-ups, BLE connection / advertising
+ *   events, LED duty per channel, ADC samples) into charge drawn, split by
+ *   subsystem.  Every figure can be overridden from a "name value" text file
+ *   (# comments), so a measured board replaces the guesses:
+ *       cpu_base_ma 15
+ *       led_blue_ma 12.5
+ *   Header only - shared by the gig benchmark (powerModel.cpp) and
+ *   tools/saverSim, which build against the native HAL.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef CURRENT_MODEL_H  // begin header guard
+#define CURRENT_MODEL_H
+
+#include <stdio.h>
+#include <string.h>
+
+#include "boardProfile.h"
+#include "controlRGB.h"    // LED_PWM_MAX_DUTY
+#include "hal.h"           // simLedValue()
+#include "powerPolicy.h"   // powerMode_t
+#include "socEstimator.h"  // LIPO_DISCHARGE_CURVE
+
+struct currentModel_t {
+    double capacity_mAh;
+    double cpuBase_mA;      // awake, clock independent (RF / digital idle)
+    double cpuPerMhz_mA;    // awake, per MHz of CPU clock
+    double lightSleep_mA;
+    double wake_mAs;        // one task wake-up out of light sleep
+    double bleEvent_mAs;    // one BLE connection event
+    double advEvent_mAs;    // one advertising event (3 channels)
+    double adcSample_mAs;   // one battery ADC reading
+    double ledRed_mA;       // LED channel at full duty
+    double ledGreen_mA;
+    double ledBlue_mA;
+};
+
+constexpr currentModel_t DEFAULT_CURRENT_MODEL = {
+    1000.0,  // capacity_mAh
+    15.0,    // cpuBase_mA
+    0.11,    // cpuPerMhz_mA: 240 MHz ~41 mA, 80 MHz ~24 mA
+    0.8,     // lightSleep_mA
+    0.002,   // wake_mAs: ~0.1 ms at ~20 mA
+    0.15,    // bleEvent_mAs: ~1.5 ms at ~100 mA
+    0.3,     // advEvent_mAs
+    0.002,   // adcSample_mAs
+    16.0,    // ledRed_mA: (3.3 - 2.0) V / 82 ohm
+    8.0,     // ledGreen_mA: (3.3 - 3.2) V / 12 ohm
+    17.0,    // ledBlue_mA: (3.3 - 3.1) V / 12 ohm
+};
+
+// subsystems charge is booked to
+enum chargeSink_t { SINK_CPU,
+                    SINK_WAKE,
+                    SINK_RADIO,
+                    SINK_LED_RED,
+                    SINK_LED_GREEN,
+                    SINK_LED_BLUE,
+                    SINK_ADC,
+                    SINK_COUNT };
+
+static const char* const sinkName[SINK_COUNT] = {"cpu", "wake-ups", "radio", "led red", "led green", "led blue", "adc"};
+
+// what the firmware is doing over one simulation step
+struct powerSample_t {
+    powerMode_t mode;
+    int boostMhz;               // clock in POWER_BOOST
+    int ecoMhz;                 // clock in POWER_ECO
+    double wakesPerSecond;      // task wake-ups (only cost extra in light sleep)
+    double radioEventsPerSecond;
+    double radioEvent_mAs;      // bleEvent_mAs or advEvent_mAs
+    double ledOn[3];            // red, green, blue duty 0 - 1 (sampleLeds)
+};
+
+/*****************************************************************************
+Description : Reads "name value" overrides into model; names as the struct
+                fields in snake case (eg cpu_base_ma, led_blue_ma)
+
+Input Value : path, model - defaults in, overrides out
+Return Value: false if the file is missing or has an unknown name
+********************************************************************************/
+inline bool loadCurrentModel(const char* path, currentModel_t& model) {
+    struct field_t {
+        const char* name;
+        double* value;
+    } fields[] = {
+        {"capacity_mah", &model.capacity_mAh}, {"cpu_base_ma", &model.cpuBase_mA}, {"cpu_per_mhz_ma", &model.cpuPerMhz_mA},
+        {"light_sleep_ma", &model.lightSleep_mA}, {"wake_mas", &model.wake_mAs}, {"ble_event_mas", &model.bleEvent_mAs},
+        {"adv_event_mas", &model.advEvent_mAs}, {"adc_sample_mas", &model.adcSample_mAs}, {"led_red_ma", &model.ledRed_mA},
+        {"led_green_ma", &model.ledGreen_mA}, {"led_blue_ma", &model.ledBlue_mA},
+    };
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        fprintf(stderr, "%s: cannot open current model\n", path);
+        return false;
+    }
+    char line[128], name[64];
+    double value;
+    bool ok = true;
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        if ((line[0] == '#') || (sscanf(line, "%63s %lf", name, &value) != 2)) {
+            continue;
+        }
+        bool known = false;
+        for (field_t& f : fields) {
+            if (strcmp(f.name, name) == 0) {
+                *f.value = value;
+                known = true;
+            }
+        }
+        if (!known) {
+            fprintf(stderr, "%s: unknown current model entry '%s'\n", path, name);
+            ok = false;
+        }
+    }
+    fclose(file);
+    return ok;
+}
+
+// pack open circuit voltage for a state of charge (inverse of LIPO_DISCHARGE_CURVE); below 0% keeps falling
+inline uint32_t packOcv_mV(double permille) {
+    if (permille <= LIPO_DISCHARGE_CURVE[0].permille) {
+        return LIPO_DISCHARGE_CURVE[0].millivolts - 10;
+    }
+    for (int i = 1; i < LIPO_CURVE_POINTS; i++) {
+        const socPoint_t& hi = LIPO_DISCHARGE_CURVE[i];
+        if (permille <= hi.permille) {
+            const socPoint_t& lo = LIPO_DISCHARGE_CURVE[i - 1];
+            return (uint32_t)(lo.millivolts + (permille - lo.permille) * (hi.millivolts - lo.millivolts) / (hi.permille - lo.permille));
+        }
+    }
+    return LIPO_DISCHARGE_CURVE[LIPO_CURVE_POINTS - 1].millivolts;
+}
+
+// LED channel duty as driven (0 = dark) for either polarity
+inline double ledOnFraction(int pin) {
+    int duty = simLedValue(pin);
+    return (double)((Board::LED_POLARITY == LED_COMMON_ANODE) ? LED_PWM_MAX_DUTY - duty : duty) / LED_PWM_MAX_DUTY;
+}
+
+// LED duty now, from the native HAL's LEDC channels
+inline void sampleLeds(powerSample_t& sample) {
+    sample.ledOn[0] = ledOnFraction(Board::RED_LED_PIN);
+    sample.ledOn[1] = ledOnFraction(Board::GREEN_LED_PIN);
+    sample.ledOn[2] = ledOnFraction(Board::BLUE_LED_PIN);
+}
+
+/*****************************************************************************
+Description : Books the charge drawn over one step to each subsystem
+
+Input Value : model, sample - firmware activity, seconds - step length
+              charge_mAs - per subsystem totals, added to
+Return Value: charge drawn this step (mAs)
+********************************************************************************/
+inline double accumulateCharge(const currentModel_t& model, const powerSample_t& sample, double seconds,
+                               double charge_mAs[SINK_COUNT]) {
+    double step[SINK_COUNT] = {};
+    if (sample.mode == POWER_SLEEP) {
+        step[SINK_CPU] = model.lightSleep_mA * seconds;
+        step[SINK_WAKE] = sample.wakesPerSecond * model.wake_mAs * seconds;
+    } else {
+        int mhz = (sample.mode == POWER_BOOST) ? sample.boostMhz : sample.ecoMhz;
+        step[SINK_CPU] = (model.cpuBase_mA + model.cpuPerMhz_mA * mhz) * seconds;
+    }
+    step[SINK_RADIO] = sample.radioEventsPerSecond * sample.radioEvent_mAs * seconds;
+    step[SINK_LED_RED] = sample.ledOn[0] * model.ledRed_mA * seconds;
+    step[SINK_LED_GREEN] = sample.ledOn[1] * model.ledGreen_mA * seconds;
+    step[SINK_LED_BLUE] = sample.ledOn[2] * model.ledBlue_mA * seconds;
+
+    double total = 0;
+    for (int s = 0; s < SINK_COUNT; s++) {
+        charge_mAs[s] += step[s];
+        total += step[s];
+    }
+    return total;
+}
+
+#endif  // end header guard
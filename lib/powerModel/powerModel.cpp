@@ -0,0 +1,328 @@
+/*
+ * *************************************************************
+ * powerModel.cpp - implementation file for the [env:native] gig battery life benchmark
+ *
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef ARDUINO
+
+#include "powerModel.h"
+
+#include <Arduino.h>  // host scheduler: hostStartArduino(), hostRunUntil()
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "batteryMonitor.h"  // fakeAdcSet_mV(), fakeAdcReads()
+#include "hal.h"
+#include "myConstants.h"
+
+// the gig: parts in order; page turns only while playing
+struct gigPart_t {
+    const char* name;
+    uint32_t minutes;
+    bool playing;
+};
+constexpr gigPart_t GIG[] = {
+    {"soundcheck", 10, true}, {"set 1", 55, true}, {"break", 20, false},
+    {"set 2", 55, true}, {"break", 15, false}, {"set 3", 25, true},
+};
+constexpr int GIG_PARTS = sizeof(GIG) / sizeof(GIG[0]);
+
+constexpr uint32_t CONNECT_AT_MSEC = 3000;  // bonded iPad reconnects during directed advertising
+constexpr uint32_t TURN_MIN_MSEC = 20000;   // page turn spacing while playing
+constexpr uint32_t TURN_MAX_MSEC = 45000;
+constexpr int DOUBLE_TAP_ONE_IN = 12;       // page back
+constexpr uint32_t TAP_MSEC = 90;
+constexpr uint32_t DOUBLE_GAP_MSEC = 150;
+constexpr uint32_t HOLD_MSEC = 900;         // battery check at the start of each part played
+constexpr uint32_t DROPOUT_PART = 3;        // set 2
+constexpr uint32_t DROPOUT_AT_MSEC = 20UL * 60 * 1000;
+constexpr uint32_t DROPOUT_MSEC = 40000;
+
+enum scriptAction_t { PEDAL_DOWN,
+                      PEDAL_UP,
+                      LINK_DOWN,
+                      LINK_UP };
+
+struct scriptStep_t {
+    uint32_t time_msec;
+    scriptAction_t action;
+};
+
+static uint32_t lcg = 1;
+static uint32_t random(uint32_t range) {
+    lcg = lcg * 1664525u + 1013904223u;
+    return (lcg >> 8) % range;
+}
+
+// press with contact bounce on the way down
+static void addPress(std::vector<scriptStep_t>& script, uint32_t at_msec, uint32_t hold_msec) {
+    script.push_back({at_msec, PEDAL_DOWN});
+    script.push_back({at_msec + 1, PEDAL_UP});
+    script.push_back({at_msec + 2, PEDAL_DOWN});
+    script.push_back({at_msec + hold_msec, PEDAL_UP});
+}
+
+static uint32_t buildGig(std::vector<scriptStep_t>& script, gigWorkload_t& work) {
+    uint32_t start_msec = 0;
+    script.push_back({CONNECT_AT_MSEC, LINK_UP});
+    for (int part = 0; part < GIG_PARTS; part++) {
+        uint32_t end_msec = start_msec + GIG[part].minutes * 60000UL;
+        if (GIG[part].playing) {
+            addPress(script, start_msec + 5000, HOLD_MSEC);
+            work.holds++;
+            for (uint32_t t = start_msec + 5000 + TURN_MIN_MSEC; t < end_msec; t += TURN_MIN_MSEC + random(TURN_MAX_MSEC - TURN_MIN_MSEC)) {
+                addPress(script, t, TAP_MSEC);
+                if (random(DOUBLE_TAP_ONE_IN) == 0) {
+                    addPress(script, t + TAP_MSEC + DOUBLE_GAP_MSEC, TAP_MSEC);
+                    work.doubles++;
+                } else {
+                    work.turns++;
+                }
+            }
+        }
+        if (part == DROPOUT_PART) {
+            script.push_back({start_msec + DROPOUT_AT_MSEC, LINK_DOWN});
+            script.push_back({start_msec + DROPOUT_AT_MSEC + DROPOUT_MSEC, LINK_UP});
+        }
+        start_msec = end_msec;
+    }
+    std::stable_sort(script.begin(), script.end(),
+                     [](const scriptStep_t& a, const scriptStep_t& b) { return a.time_msec < b.time_msec; });
+    return start_msec;
+}
+
+// charge meter: what the firmware has been doing since last_usec, booked when it may change
+static const currentModel_t* meterModel;
+static gigResult_t* meterResult;
+static powerSample_t meterSample;
+static uint64_t meterLast_usec;
+static uint64_t meterLastWake_usec;
+static uint32_t meterAdcReads;
+static double meterCharge_mAs;
+
+static powerSample_t sampleFirmware(const currentModel_t& model) {
+    powerSample_t sample = {};
+    sample.mode = simPowerLightSleep() ? POWER_SLEEP : (simPowerFullSpeed() ? POWER_BOOST : POWER_ECO);
+    sample.boostMhz = simPowerMaxMhz();
+    sample.ecoMhz = simPowerMinMhz();
+    sample.wakesPerSecond = 0;  // booked per wake-up instead (onTaskStep)
+    if (halKeyboardIsConnected()) {
+        // slave latency skips events only while there is nothing to send
+        double latency = (simLinkQueued() > 0) ? 0 : simLinkLatency();
+        sample.radioEventsPerSecond = 1000000.0 / (simLinkInterval_usec() * (latency + 1));
+        sample.radioEvent_mAs = model.bleEvent_mAs;
+    } else if (simAdvertisingInterval() != 0) {
+        sample.radioEventsPerSecond = 1000.0 / (simAdvertisingInterval() * 0.625);
+        sample.radioEvent_mAs = model.advEvent_mAs;
+    }
+    sampleLeds(sample);
+    return sample;
+}
+
+// books the time since the last update at the last sample, then samples the firmware again
+static void meterUpdate() {
+    uint64_t now_usec = simNow_usec();
+    double seconds = (now_usec - meterLast_usec) / 1000000.0;
+    meterCharge_mAs -= accumulateCharge(*meterModel, meterSample, seconds, meterResult->sink_mAs);
+    meterResult->mode_msec[meterSample.mode] += seconds * 1000.0;
+    meterLast_usec = now_usec;
+
+    uint32_t reads = fakeAdcReads();
+    double adc_mAs = (reads - meterAdcReads) * meterModel->adcSample_mAs;
+    meterResult->sink_mAs[SINK_ADC] += adc_mAs;
+    meterCharge_mAs -= adc_mAs;
+    meterAdcReads = reads;
+
+    meterSample = sampleFirmware(*meterModel);
+    fakeAdcSet_mV(packOcv_mV(meterCharge_mAs / (meterModel->capacity_mAh * 3.6)) / Board::BATTERY_DIVIDER_RATIO);
+}
+
+// host scheduler step hook: a task ran at this time, waking the chip if it was in light sleep
+static void onTaskStep() {
+    uint64_t now_usec = simNow_usec();
+    if ((meterSample.mode == POWER_SLEEP) && (now_usec != meterLastWake_usec)) {
+        meterResult->sink_mAs[SINK_WAKE] += meterModel->wake_mAs;
+        meterCharge_mAs -= meterModel->wake_mAs;
+    }
+    meterLastWake_usec = now_usec;
+    meterUpdate();
+}
+
+/*****************************************************************************
+Description : Boots the firmware on the host scheduler with a full pack and a
+                bonded host, plays the gig into it and meters the charge it
+                draws.  The firmware's globals and tasks can't be reset, so
+                only once per process.
+
+Input Value : model - current figures, seed - page turn timing
+              result - filled in
+Return Value: false if the firmware stopped before the end of the gig
+********************************************************************************/
+bool runGig(const currentModel_t& model, uint32_t seed, gigResult_t& result) {
+    memset(&result, 0, sizeof(result));
+    std::vector<scriptStep_t> script;
+    lcg = seed;
+    result.gig_msec = buildGig(script, result.work);
+
+    meterModel = &model;
+    meterResult = &result;
+    meterCharge_mAs = model.capacity_mAh * 3600.0;
+    meterLast_usec = 0;
+    meterLastWake_usec = 0;
+
+    simReset();
+    simSetBondedHost(true);
+    fakeAdcSet_mV(packOcv_mV(1000) / Board::BATTERY_DIVIDER_RATIO);
+    meterAdcReads = fakeAdcReads();
+    meterSample = sampleFirmware(model);
+    hostSerialMute(true);
+    hostSetStepHook(onTaskStep);
+    hostStartArduino();
+
+    bool running = true;
+    for (size_t i = 0; running && (i < script.size()); i++) {
+        running = hostRunUntil((uint64_t)script[i].time_msec * 1000);
+        meterUpdate();
+        if (!running) {
+            break;
+        }
+        switch (script[i].action) {
+            case PEDAL_DOWN:
+            case PEDAL_UP:
+                simSetPin(PEDALS[0].pin, script[i].action == PEDAL_UP);  // pressed = LOW
+                break;
+            case LINK_DOWN:
+            case LINK_UP:
+                simSetConnected(script[i].action == LINK_UP);
+                break;
+        }
+        meterUpdate();
+    }
+    running = running && hostRunUntil((uint64_t)result.gig_msec * 1000);
+    meterUpdate();
+    hostSetStepHook(nullptr);
+    hostSerialMute(false);
+
+    double total_mAs = 0;
+    for (int s = 0; s < SINK_COUNT; s++) {
+        total_mAs += result.sink_mAs[s];
+    }
+    result.keys = simHidReportCount();
+    result.endPercent = simBatteryLevel();
+    result.completed = running && !simInDeepSleep();
+    result.life_min = model.capacity_mAh / (total_mAs / (result.gig_msec / 1000.0)) * 60.0;
+    return result.completed;
+}
+
+void printGigReport(const currentModel_t& model, const gigResult_t& r) {
+    double gig_sec = r.gig_msec / 1000.0, total_mAs = 0;
+    for (int s = 0; s < SINK_COUNT; s++) {
+        total_mAs += r.sink_mAs[s];
+    }
+    printf("board %s, %.0f mAh pack, %lu min gig%s\n", Board::name(), model.capacity_mAh, (unsigned long)(r.gig_msec / 60000),
+           r.completed ? "" : " - FIRMWARE STOPPED EARLY");
+    printf("workload: %d page turns, %d double taps, %d battery checks; %d keys sent\n", r.work.turns, r.work.doubles,
+           r.work.holds, r.keys);
+    printf("power modes: boost %.1f%%, eco %.1f%%, sleep %.1f%%\n", 100.0 * r.mode_msec[POWER_BOOST] / r.gig_msec,
+           100.0 * r.mode_msec[POWER_ECO] / r.gig_msec, 100.0 * r.mode_msec[POWER_SLEEP] / r.gig_msec);
+    printf("%-10s %9s %7s %8s\n", "subsystem", "mAh", "share", "avg mA");
+    for (int s = 0; s < SINK_COUNT; s++) {
+        printf("%-10s %9.3f %6.1f%% %8.3f\n", sinkName[s], r.sink_mAs[s] / 3600.0, 100.0 * r.sink_mAs[s] / total_mAs,
+               r.sink_mAs[s] / gig_sec);
+    }
+    printf("%-10s %9.3f %6.1f%% %8.3f\n", "total", total_mAs / 3600.0, 100.0, total_mAs / gig_sec);
+    printf("battery at end of gig %u%%; projected battery life %.1f min (%.2f gigs)\n", r.endPercent, r.life_min,
+           r.life_min * 60000.0 / r.gig_msec);
+}
+
+// "name value" baseline entries; subsystem names with spaces -> underscores
+static void sinkKey(int sink, char* key, size_t size) {
+    snprintf(key, size, "mah_%s", sinkName[sink]);
+    for (char* c = key; *c != 0; c++) {
+        if ((*c == ' ') || (*c == '-')) {
+            *c = '_';
+        }
+    }
+}
+
+static bool readBaseline(const char* path, double& life_min, double& tolerance_percent, double sink_mAh[SINK_COUNT]) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        return false;
+    }
+    char line[128], name[64], key[64];
+    double value;
+    life_min = -1;
+    tolerance_percent = POWER_DEFAULT_TOLERANCE_PERCENT;
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        if ((line[0] == '#') || (sscanf(line, "%63s %lf", name, &value) != 2)) {
+            continue;
+        }
+        if (strcmp(name, "battery_life_min") == 0) {
+            life_min = value;
+        } else if (strcmp(name, "tolerance_percent") == 0) {
+            tolerance_percent = value;
+        }
+        for (int s = 0; s < SINK_COUNT; s++) {
+            sinkKey(s, key, sizeof(key));
+            if (strcmp(name, key) == 0) {
+                sink_mAh[s] = value;
+            }
+        }
+    }
+    fclose(file);
+    return life_min > 0;
+}
+
+bool writePowerBaseline(const char* path, const gigResult_t& result) {
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) {
+        return false;
+    }
+    char key[64];
+    fprintf(file, "# powerModel baseline: projected battery life over the scripted gig (regenerate with program -p -w)\n");
+    fprintf(file, "battery_life_min %.1f\n", result.life_min);
+    fprintf(file, "tolerance_percent %.1f\n", POWER_DEFAULT_TOLERANCE_PERCENT);
+    for (int s = 0; s < SINK_COUNT; s++) {
+        sinkKey(s, key, sizeof(key));
+        fprintf(file, "%s %.3f\n", key, result.sink_mAs[s] / 3600.0);
+    }
+    fclose(file);
+    return true;
+}
+
+/*****************************************************************************
+Description : Prints each subsystem's change against a saved baseline and
+                whether battery life dropped by more than its tolerance
+
+Input Value : path - baseline file (writePowerBaseline), result
+Return Value: 0 = within tolerance, 1 = regression, 2 = no baseline
+********************************************************************************/
+int comparePowerBaseline(const char* path, const gigResult_t& result) {
+    double baseLife_min, tolerance_percent, base_mAh[SINK_COUNT] = {};
+    if (!readBaseline(path, baseLife_min, tolerance_percent, base_mAh)) {
+        fprintf(stderr, "%s: no battery_life_min in baseline\n", path);
+        return 2;
+    }
+    for (int s = 0; s < SINK_COUNT; s++) {
+        printf("  %-10s %+9.3f mAh vs baseline\n", sinkName[s], result.sink_mAs[s] / 3600.0 - base_mAh[s]);
+    }
+    double change_percent = 100.0 * (result.life_min - baseLife_min) / baseLife_min;
+    printf("battery life %.1f min vs baseline %.1f min (%+.2f%%, tolerance %.1f%%)\n", result.life_min, baseLife_min,
+           change_percent, tolerance_percent);
+    if (change_percent < -tolerance_percent) {
+        printf("REGRESSION: battery life dropped by more than %.1f%%\n", tolerance_percent);
+        return 1;
+    }
+    return 0;
+}
+
+#endif  // ARDUINO
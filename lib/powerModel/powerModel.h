@@ -0,0 +1,63 @@
+/*
+ * *************************************************************
+ * powerModel.h - Header file for the [env:native] gig battery life benchmark
+ *
+ *   Plays a scripted three-hour gig (soundcheck, three sets, two breaks,
+ *   page turns every 20 - 45 s with some double taps, a battery check long
+ *   press per set and one 40 s BLE dropout) into the real firmware - setup()
+ *   and its FreeRTOS tasks on the host scheduler, pedal edges with contact
+ *   bounce through the pin ISR.  After every task step the charge drawn
+ *   since the last one is booked per subsystem from what the native HAL
+ *   says the firmware is doing (power mode and clock, BLE connection or
+ *   advertising interval, LED duty, ADC readings, wake-ups from light
+ *   sleep), with the current model in currentModel.h, and the pack voltage
+ *   the firmware reads follows the charge left.
+ *
+ *   Everything tunable (LED_DURATION_MSEC, blink rates, connection and
+ *   power timing, battery sampling, board profile) is compiled in, so each
+ *   build measures one firmware configuration.  Run it with
+ *   .pio/build/native/program -p (see flipTurn-native.cpp); test_powerModel
+ *   fails under pio test -e native when battery life drops below its
+ *   baseline.txt.  Host only.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef POWER_MODEL_H  // begin header guard
+#define POWER_MODEL_H
+
+#ifndef ARDUINO
+
+#include <stdint.h>
+
+#include "currentModel.h"
+
+constexpr double POWER_DEFAULT_TOLERANCE_PERCENT = 2.0;
+
+// what the gig script asks of the pedal
+struct gigWorkload_t {
+    int turns, doubles, holds;
+};
+
+struct gigResult_t {
+    double sink_mAs[SINK_COUNT];
+    double mode_msec[POWER_MODE_COUNT];
+    uint32_t gig_msec;
+    gigWorkload_t work;
+    int keys;            // key presses the firmware sent (HID reports)
+    uint8_t endPercent;  // battery level the firmware reports at the end
+    bool completed;      // ran to the end of the gig (no deep sleep, no stuck task)
+    double life_min;     // projected battery life at the gig's average current
+};
+
+// method prototypes:
+bool runGig(const currentModel_t& model, uint32_t seed, gigResult_t& result);  // starts the firmware: once per process
+void printGigReport(const currentModel_t& model, const gigResult_t& result);
+bool writePowerBaseline(const char* path, const gigResult_t& result);
+int comparePowerBaseline(const char* path, const gigResult_t& result);  // 0 = ok, 1 = regression, 2 = no baseline
+
+#endif  // ARDUINO
+
+#endif  // end header guard
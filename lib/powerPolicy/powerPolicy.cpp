@@ -0,0 +1,62 @@
+/*
+ * *************************************************************
+ * powerPolicy.cpp - implementation file for CPU frequency / light sleep policy
+ *
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include "powerPolicy.h"
+
+// PowerPolicy constructor; starts in BOOST (boot is busy)
+PowerPolicy::PowerPolicy(uint32_t boost_msec,
+                         uint32_t sleepAfter_msec) : _boost_msec(boost_msec),
+                                                     _sleepAfter_msec(sleepAfter_msec),
+                                                     _mode(POWER_BOOST),
+                                                     _lastActivity_msec(0),
+                                                     _lastUpdate_msec(0) {
+    resetStats(0);
+}
+
+void PowerPolicy::resetStats(unsigned long now_msec) {
+    for (int m = 0; m < POWER_MODE_COUNT; m++) {
+        _residency_msec[m] = 0;
+        _entries[m] = 0;
+    }
+    _lastUpdate_msec = now_msec;
+}
+
+void PowerPolicy::setTiming(uint32_t boost_msec, uint32_t sleepAfter_msec) {
+    _boost_msec = boost_msec;
+    _sleepAfter_msec = sleepAfter_msec;
+}
+
+/*****************************************************************************
+Description : Picks the power mode and accumulates residency.
+                busy (edge / gesture timer / keys to send) or within boost_msec -> BOOST
+                quiet for less than sleepAfter_msec -> ECO
+                otherwise -> SLEEP
+
+Input Value : now_msec, busy - input activity in progress
+Return Value: true if the mode changed (caller applies mode())
+********************************************************************************/
+bool PowerPolicy::update(unsigned long now_msec, bool busy) {
+    _residency_msec[_mode] += now_msec - _lastUpdate_msec;
+    _lastUpdate_msec = now_msec;
+
+    if (busy) {
+        _lastActivity_msec = now_msec;
+    }
+    unsigned long quiet_msec = now_msec - _lastActivity_msec;
+    powerMode_t wanted = (quiet_msec < _boost_msec)        ? POWER_BOOST
+                         : (quiet_msec < _sleepAfter_msec) ? POWER_ECO
+                                                           : POWER_SLEEP;
+    if (wanted == _mode) {
+        return false;
+    }
+    _mode = wanted;
+    _entries[wanted]++;
+    return true;
+}
@@ -0,0 +1,51 @@
+/*
+ * *************************************************************
+ * powerPolicy.h - Header file for CPU frequency / light sleep policy
+ *
+ *   Three power modes, chosen from foot switch and HID activity:
+ *     BOOST  full CPU clock, no light sleep - press in progress or just made
+ *     ECO    minimum CPU clock (BLE needs 80 MHz), no light sleep
+ *     SLEEP  minimum clock + automatic light sleep between BLE connection
+ *            events; foot switch GPIO wakes the CPU
+ *   Records time spent (residency) and entries per mode.  Pure policy - the
+ *   caller applies each mode through the HAL, so it also runs on a host.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef POWER_POLICY_H  // begin header guard
+#define POWER_POLICY_H
+
+#include <stdint.h>
+
+enum powerMode_t { POWER_BOOST,
+                   POWER_ECO,
+                   POWER_SLEEP,
+                   POWER_MODE_COUNT };
+
+class PowerPolicy {
+   public:
+    PowerPolicy(uint32_t boost_msec, uint32_t sleepAfter_msec);  // constructor prototype
+
+    // method prototypes:
+    bool update(unsigned long now_msec, bool busy);
+    void resetStats(unsigned long now_msec);
+    void setTiming(uint32_t boost_msec, uint32_t sleepAfter_msec);  // battery saver; from the next update()
+
+    powerMode_t mode() const { return _mode; }
+    uint32_t residency_msec(powerMode_t mode) const { return _residency_msec[mode]; }
+    uint32_t entries(powerMode_t mode) const { return _entries[mode]; }
+
+   private:
+    uint32_t _boost_msec;
+    uint32_t _sleepAfter_msec;
+    powerMode_t _mode;
+    unsigned long _lastActivity_msec;
+    unsigned long _lastUpdate_msec;
+    uint32_t _residency_msec[POWER_MODE_COUNT];
+    uint32_t _entries[POWER_MODE_COUNT];
+};
+
+#endif  // end header guard
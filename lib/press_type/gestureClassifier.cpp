@@ -0,0 +1,140 @@
+/* *************************************************************
+ * gestureClassifier.cpp - timestamp-based foot switch gesture classifier
+ *   press_types:  short press, long press and double press
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ *  All time arithmetic is unsigned difference, so micros() wrap (~71 min) is harmless.
+ *
+ * ************************************************************ */
+
+#include "gestureClassifier.h"
+
+// GestureClassifier constructor; all durations in microseconds
+GestureClassifier::GestureClassifier(uint32_t debounce_usec,
+                                     uint32_t doubleTap_usec,
+                                     uint32_t hold_usec) : _debounce_usec(debounce_usec),
+                                                           _doubleTap_usec(doubleTap_usec),
+                                                           _hold_usec(hold_usec),
+                                                           _lowLatency(false),
+                                                           _state(IDLE),
+                                                           _pressed(false),
+                                                           _secondTap(false),
+                                                           _lastEdge_usec(0),
+                                                           _stateStart_usec(0),
+                                                           _gestureStart_usec(0) {
+}
+
+void GestureClassifier::setTiming(uint32_t debounce_usec, uint32_t doubleTap_usec, uint32_t hold_usec) {
+    _debounce_usec = debounce_usec;
+    _doubleTap_usec = doubleTap_usec;
+    _hold_usec = hold_usec;
+}
+
+void GestureClassifier::reset(bool pressed_now) {
+    _state = IDLE;
+    _pressed = pressed_now;
+    _secondTap = false;
+}
+
+/*****************************************************************************
+Purpose     : Feed one captured edge.  Edges inside the debounce window of the
+                last accepted edge are contact bounce and ignored; onTick()
+                reconciles the level once the window has passed.
+
+Input Value : edge - timestamped switch edge from the ISR queue
+Return Value: gesture completed by this edge (or by a timeout that expired
+                before it), otherwise NO_PRESS
+********************************************************************************/
+pressType_T GestureClassifier::onEdge(const switchEdge_t& edge) {
+    pressType_T gesture = checkTimeouts(edge.time_usec);
+    if (gesture != NO_PRESS) {
+        // only one gesture per call; the edge is still applied so it is not lost
+        acceptEdge(edge.time_usec, edge.pressed);
+        return gesture;
+    }
+    return acceptEdge(edge.time_usec, edge.pressed);
+}
+
+/*****************************************************************************
+Purpose     : Periodic call (every loop pass) to expire the hold and double tap
+                timers, and to recover a release/press swallowed by debounce
+
+Input Value : now_usec - current time (micros())
+              pressed_now - current raw switch level
+Return Value: gesture completed by a timeout, otherwise NO_PRESS
+********************************************************************************/
+pressType_T GestureClassifier::onTick(uint32_t now_usec, bool pressed_now) {
+    pressType_T gesture = checkTimeouts(now_usec);
+    if (gesture != NO_PRESS) {
+        return gesture;
+    }
+    if (pressed_now != _pressed) {
+        return acceptEdge(now_usec, pressed_now);
+    }
+    return NO_PRESS;
+}
+
+pressType_T GestureClassifier::checkTimeouts(uint32_t now_usec) {
+    switch (_state) {
+        case PRESSED:
+            if ((now_usec - _stateStart_usec) >= _hold_usec) {
+                _state = HOLDING;
+                return LONG_PRESS;
+            }
+            break;
+
+        case WAIT_2ND_TAP:
+            if ((now_usec - _stateStart_usec) >= _doubleTap_usec) {
+                _state = IDLE;
+                return _lowLatency ? NO_PRESS : SHORT_PRESS;  // low latency: already reported on release
+            }
+            break;
+
+        default:
+            break;
+    }
+    return NO_PRESS;
+}
+
+pressType_T GestureClassifier::acceptEdge(uint32_t time_usec, bool pressed) {
+    if (pressed == _pressed) {
+        return NO_PRESS;  // no level change (eg bounce that settled back)
+    }
+    if ((time_usec - _lastEdge_usec) < _debounce_usec) {
+        return NO_PRESS;  // contact bounce
+    }
+    _pressed = pressed;
+    _lastEdge_usec = time_usec;
+
+    if (pressed) {
+        _secondTap = (_state == WAIT_2ND_TAP);
+        _state = PRESSED;
+        _stateStart_usec = time_usec;
+        if (!_secondTap) {
+            _gestureStart_usec = time_usec;
+        }
+        return NO_PRESS;
+    }
+
+    // released
+    switch (_state) {
+        case PRESSED:
+            if (_secondTap) {
+                _state = IDLE;
+                return _lowLatency ? DOUBLE_PRESS_AFTER_SHORT : DOUBLE_PRESS;
+            }
+            _state = WAIT_2ND_TAP;
+            _stateStart_usec = time_usec;
+            if (_lowLatency) {
+                return SHORT_PRESS;  // speculative; saves the whole double tap window
+            }
+            break;
+
+        default:  // HOLDING - hold already reported on timeout
+            _state = IDLE;
+            break;
+    }
+    return NO_PRESS;
+}
@@ -0,0 +1,73 @@
+/*
+ * *************************************************************
+ * gestureClassifier.h - Header for timestamp-based foot switch gesture classifier
+ *   press_types:  short press, long press and double press
+ *
+ *   Debounces and classifies switch edges from their capture timestamps
+ *   (recorded in the GPIO interrupt), so press timing does not depend on
+ *   how often loop() gets round to polling.  No Arduino dependency.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef GESTURE_CLASSIFIER_H  // header guard
+#define GESTURE_CLASSIFIER_H
+
+#include <stdint.h>
+
+enum pressType_T { NO_PRESS,
+                   SHORT_PRESS,
+                   DOUBLE_PRESS,
+                   LONG_PRESS,
+                   DOUBLE_PRESS_AFTER_SHORT,  // low latency mode: double press whose first tap was already sent as SHORT_PRESS
+                   CHORD_PRESS};              // two (or more) pedals pressed together - see pedalBank.h
+
+// one captured switch edge; written by the ISR into the edge queue
+struct switchEdge_t {
+    uint32_t time_usec;  // micros() at the edge
+    bool pressed;        // switch level after the edge (switch wired NO to GND, so LOW = pressed)
+};
+
+class GestureClassifier {
+   public:
+    GestureClassifier(uint32_t debounce_usec,
+                      uint32_t doubleTap_usec,
+                      uint32_t hold_usec);  // constructor prototype
+    GestureClassifier() : GestureClassifier(0, 0, 0) {}  // for arrays; set durations with setTiming()
+
+    // method prototypes:
+    void setTiming(uint32_t debounce_usec, uint32_t doubleTap_usec, uint32_t hold_usec);
+    void reset(bool pressed_now);  // abandon any gesture in progress (eg pedal taken by a chord)
+    pressType_T onEdge(const switchEdge_t& edge);
+    pressType_T onTick(uint32_t now_usec, bool pressed_now);
+    bool isPressed() const { return _pressed; }
+    bool hasPendingTimeout() const { return (_state == PRESSED) || (_state == WAIT_2ND_TAP); }  // needs onTick() soon
+    uint32_t gestureStart_usec() const { return _gestureStart_usec; }  // first press edge of latest gesture
+
+    // low latency (speculative) mode: report SHORT_PRESS on first release instead of after the
+    //   double tap window; a following second tap is then reported as DOUBLE_PRESS_AFTER_SHORT
+    void setLowLatency(bool lowLatency) { _lowLatency = lowLatency; }
+    bool isLowLatency() const { return _lowLatency; }
+
+   private:
+    enum classifierState_t { IDLE,
+                             PRESSED,        // switch down, may become a hold
+                             WAIT_2ND_TAP,   // released after first tap; double tap window open
+                             HOLDING };      // hold already reported; wait for release
+
+    pressType_T checkTimeouts(uint32_t now_usec);
+    pressType_T acceptEdge(uint32_t time_usec, bool pressed);
+
+    uint32_t _debounce_usec, _doubleTap_usec, _hold_usec;
+    bool _lowLatency;
+    classifierState_t _state;
+    bool _pressed;                // debounced switch level
+    bool _secondTap;              // current press is the second tap of a double
+    uint32_t _lastEdge_usec;      // last accepted (debounced) edge
+    uint32_t _stateStart_usec;    // press time (PRESSED) or release time (WAIT_2ND_TAP)
+    uint32_t _gestureStart_usec;  // press time of first tap; latency reference
+};
+
+#endif  // end header guard
@@ -0,0 +1,214 @@
+/* *************************************************************
+ * pedalBank.cpp - multi-pedal scanner + chord detection
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ *  Bit loops visit set bits only (count trailing zeros, clear lowest bit).
+ *
+ * ************************************************************ */
+
+#include "pedalBank.h"
+
+// PedalBank constructor; all durations in microseconds
+PedalBank::PedalBank(uint32_t debounce_usec,
+                     uint32_t doubleTap_usec,
+                     uint32_t hold_usec,
+                     uint32_t chordWindow_usec) : _debounce_usec(debounce_usec),
+                                                  _chordWindow_usec(chordWindow_usec),
+                                                  _count(0),
+                                                  _pinMask(0),
+                                                  _rawPins(0),
+                                                  _raw(0),
+                                                  _pressed(0),
+                                                  _timing(0),
+                                                  _chordLatched(0),
+                                                  _chordCount(0),
+                                                  _gestureHead(0),
+                                                  _gestureCount(0),
+                                                  _droppedGestures(0) {
+    for (int pin = 0; pin < MAX_SCAN_PINS; pin++) {
+        _pedalOfPin[pin] = -1;
+    }
+    for (int p = 0; p < MAX_PEDALS; p++) {
+        _lastEdge_usec[p] = 0;
+        _pressStart_usec[p] = 0;
+        _classifier[p].setTiming(0, doubleTap_usec, hold_usec);  // debounce done here, per pedal
+    }
+}
+
+int PedalBank::addPedal(int pin) {
+    if ((_count >= MAX_PEDALS) || (pin < 0) || (pin >= MAX_SCAN_PINS) || (_pedalOfPin[pin] >= 0)) {
+        return -1;
+    }
+    _pedalOfPin[pin] = (int8_t)_count;
+    _pinMask |= (uint64_t)1 << pin;
+    return _count++;
+}
+
+int PedalBank::addChord(uint8_t pedalMask) {
+    bool twoOrMore = (pedalMask & (pedalMask - 1)) != 0;
+    if ((_chordCount >= MAX_CHORDS) || !twoOrMore || (pedalMask >> _count)) {
+        return -1;  // a chord needs at least two configured pedals
+    }
+    _chordMask[_chordCount] = pedalMask;
+    return _chordCount++;
+}
+
+void PedalBank::setLowLatency(bool lowLatency) {
+    for (int p = 0; p < MAX_PEDALS; p++) {
+        _classifier[p].setLowLatency(lowLatency);
+    }
+}
+
+/*****************************************************************************
+Purpose     : Feed one register snapshot captured by the pedal ISR
+
+Input Value : scan - time + GPIO input levels
+Return Value: -  (completed gestures via takeGesture())
+********************************************************************************/
+void PedalBank::onScan(const pedalScan_t& scan) {
+    applyLevels(scan.levels, scan.time_usec);
+}
+
+/*****************************************************************************
+Purpose     : Periodic call to apply the current levels, recover edges swallowed
+                by debounce, and expire hold / double tap timers.  Only pedals
+                with a timer running are visited.
+
+Input Value : now_usec, levels - GPIO input register read now
+Return Value: -
+********************************************************************************/
+void PedalBank::onTick(uint32_t now_usec, uint64_t levels) {
+    applyLevels(levels, now_usec);
+
+    for (uint8_t settle = _raw ^ _pressed; settle; settle &= settle - 1) {
+        int p = __builtin_ctz(settle);
+        acceptEdge(p, (_raw >> p) & 1, now_usec);
+    }
+
+    for (uint8_t timing = _timing; timing; timing &= timing - 1) {
+        int p = __builtin_ctz(timing);
+        pressType_T gesture = _classifier[p].onTick(now_usec, (_pressed >> p) & 1);
+        if (gesture != NO_PRESS) {
+            emit(gesture, p, 0, _classifier[p].gestureStart_usec());
+        }
+        track(p);
+    }
+}
+
+bool PedalBank::takeGesture(pedalGesture_t& gesture) {
+    if (_gestureCount == 0) {
+        return false;
+    }
+    gesture = _gesture[_gestureHead];
+    _gestureHead = (_gestureHead + 1) % PEDAL_GESTURE_QUEUE;
+    _gestureCount--;
+    return true;
+}
+
+// masks out the pedal pins and visits only those that changed since the last scan
+void PedalBank::applyLevels(uint64_t levels, uint32_t time_usec) {
+    uint64_t rawPins = ~levels & _pinMask;  // pressed = LOW
+    uint64_t changed = rawPins ^ _rawPins;
+    _rawPins = rawPins;
+
+    while (changed) {
+        int pin = __builtin_ctzll(changed);
+        changed &= changed - 1;
+        int p = _pedalOfPin[pin];
+        bool pressed = (rawPins >> pin) & 1;
+        _raw = pressed ? (_raw | (1 << p)) : (_raw & ~(1 << p));
+        acceptEdge(p, pressed, time_usec);
+    }
+}
+
+void PedalBank::acceptEdge(int p, bool pressed, uint32_t time_usec) {
+    uint8_t bit = 1 << p;
+    if (pressed == ((_pressed & bit) != 0)) {
+        return;  // no level change (eg bounce that settled back)
+    }
+    if ((time_usec - _lastEdge_usec[p]) < _debounce_usec) {
+        return;  // contact bounce; onTick() applies the settled level later
+    }
+    _lastEdge_usec[p] = time_usec;
+    _pressed ^= bit;
+    if (pressed) {
+        _pressStart_usec[p] = time_usec;
+    }
+
+    if (_chordLatched & bit) {  // pedal belongs to a reported chord: swallow until released
+        if (!pressed) {
+            _chordLatched &= ~bit;
+            _classifier[p].reset(false);
+        }
+        return;
+    }
+    if (pressed && detectChord(p, time_usec)) {
+        return;
+    }
+
+    switchEdge_t edge;
+    edge.time_usec = time_usec;
+    edge.pressed = pressed;
+    pressType_T gesture = _classifier[p].onEdge(edge);
+    if (gesture != NO_PRESS) {
+        emit(gesture, p, 0, _classifier[p].gestureStart_usec());
+    }
+    track(p);
+}
+
+// pedal p just went down: completes a chord if its partners went down within the chord window
+bool PedalBank::detectChord(int p, uint32_t time_usec) {
+    uint8_t bit = 1 << p;
+    for (int c = 0; c < _chordCount; c++) {
+        uint8_t mask = _chordMask[c];
+        if (!(mask & bit) || ((_pressed & mask) != mask) || (_chordLatched & mask)) {
+            continue;
+        }
+        bool together = true;
+        uint32_t start_usec = time_usec;
+        for (uint8_t others = mask & ~bit; others; others &= others - 1) {
+            int q = __builtin_ctz(others);
+            if ((time_usec - _pressStart_usec[q]) > _chordWindow_usec) {
+                together = false;
+            } else if ((int32_t)(_pressStart_usec[q] - start_usec) < 0) {
+                start_usec = _pressStart_usec[q];
+            }
+        }
+        if (!together) {
+            continue;
+        }
+        // partners' own gestures (press in progress) are abandoned in favour of the chord
+        _chordLatched |= mask;
+        _timing &= ~mask;
+        for (uint8_t pedals = mask; pedals; pedals &= pedals - 1) {
+            _classifier[__builtin_ctz(pedals)].reset(true);
+        }
+        emit(CHORD_PRESS, __builtin_ctz(mask), c, start_usec);
+        return true;
+    }
+    return false;
+}
+
+void PedalBank::emit(pressType_T type, int pedal, int chord, uint32_t start_usec) {
+    if (_gestureCount >= PEDAL_GESTURE_QUEUE) {
+        _droppedGestures++;
+        return;
+    }
+    pedalGesture_t& gesture = _gesture[(_gestureHead + _gestureCount) % PEDAL_GESTURE_QUEUE];
+    gesture.type = type;
+    gesture.pedal = (uint8_t)pedal;
+    gesture.chord = (uint8_t)chord;
+    gesture.start_usec = start_usec;
+    _gestureCount++;
+}
+
+// keep the "needs onTick" bit in step with the pedal's classifier
+void PedalBank::track(int p) {
+    if (_classifier[p].hasPendingTimeout()) {
+        _timing |= 1 << p;
+    } else {
+        _timing &= ~(1 << p);
+    }
+}
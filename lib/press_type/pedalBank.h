@@ -0,0 +1,97 @@
+/*
+ * *************************************************************
+ * pedalBank.h - Header for multi-pedal scanner + chord detection
+ *
+ *   Works on whole GPIO input register snapshots (bit n = GPIO n), taken
+ *   once per scan.  The pedal pins are masked out in one operation, so a
+ *   scan with no level change costs the same for 1 or 8 pedals; only pins
+ *   that changed are visited.  Per-pedal debounce state is kept as
+ *   struct-of-arrays plus bitmasks (bit p = pedal p); debounced edges feed
+ *   one GestureClassifier per pedal.  Pedals pressed together (within the
+ *   chord window) and listed as a chord give CHORD_PRESS instead.
+ *   No Arduino dependency.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef PEDAL_BANK_H  // header guard
+#define PEDAL_BANK_H
+
+#include <stdint.h>
+
+#include "gestureClassifier.h"
+
+constexpr int MAX_PEDALS = 8;        // pedal bitmasks are uint8_t
+constexpr int MAX_CHORDS = 4;
+constexpr int MAX_SCAN_PINS = 64;    // GPIO input register bits
+constexpr int PEDAL_GESTURE_QUEUE = 8;
+
+// raw GPIO input register snapshot, taken in the pedal ISR or by polling
+struct pedalScan_t {
+    uint32_t time_usec;
+    uint64_t levels;  // bit n = GPIO n level; pedals wired NO to GND, so 0 = pressed
+};
+
+struct pedalGesture_t {
+    pressType_T type;
+    uint8_t pedal;         // pedal index (lowest pedal of a chord)
+    uint8_t chord;         // chord index, CHORD_PRESS only
+    uint32_t start_usec;   // first press edge of the gesture (latency reference)
+};
+
+class PedalBank {
+   public:
+    PedalBank(uint32_t debounce_usec, uint32_t doubleTap_usec,
+              uint32_t hold_usec, uint32_t chordWindow_usec);  // constructor prototype
+
+    // method prototypes:
+    int addPedal(int pin);              // pedal index, or -1 if table full / bad pin
+    int addChord(uint8_t pedalMask);    // chord index, or -1
+    void onScan(const pedalScan_t& scan);
+    void onTick(uint32_t now_usec, uint64_t levels);
+    bool takeGesture(pedalGesture_t& gesture);
+
+    void setLowLatency(bool lowLatency);
+    bool isLowLatency() const { return _classifier[0].isLowLatency(); }
+    bool isIdle() const { return (_gestureCount == 0) && (_timing == 0) && (_raw == _pressed); }
+    int count() const { return _count; }
+    uint64_t pinMask() const { return _pinMask; }
+    uint8_t pressedMask() const { return _pressed; }
+    uint8_t rawMask() const { return _raw; }  // before debounce
+    int chordCount() const { return _chordCount; }
+    uint8_t chordMask(int chord) const { return _chordMask[chord]; }
+    uint32_t droppedGestures() const { return _droppedGestures; }
+
+   private:
+    void applyLevels(uint64_t levels, uint32_t time_usec);
+    void acceptEdge(int pedal, bool pressed, uint32_t time_usec);
+    bool detectChord(int pedal, uint32_t time_usec);
+    void emit(pressType_T type, int pedal, int chord, uint32_t start_usec);
+    void track(int pedal);
+
+    uint32_t _debounce_usec, _chordWindow_usec;
+    int _count;
+    uint64_t _pinMask;    // all pedal pins
+    uint64_t _rawPins;    // last raw pressed pins (pin space)
+    int8_t _pedalOfPin[MAX_SCAN_PINS];
+
+    // per-pedal state: struct-of-arrays + bitmasks (bit p = pedal p)
+    uint8_t _raw;          // raw level
+    uint8_t _pressed;      // debounced level
+    uint8_t _timing;       // classifier needs onTick (hold / double tap timer)
+    uint8_t _chordLatched; // taken by a chord; ignored until released
+    uint32_t _lastEdge_usec[MAX_PEDALS];
+    uint32_t _pressStart_usec[MAX_PEDALS];
+    GestureClassifier _classifier[MAX_PEDALS];
+
+    uint8_t _chordMask[MAX_CHORDS];
+    int _chordCount;
+
+    pedalGesture_t _gesture[PEDAL_GESTURE_QUEUE];
+    int _gestureHead, _gestureCount;
+    uint32_t _droppedGestures;
+};
+
+#endif  // end header guard
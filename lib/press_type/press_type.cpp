@@ -1,103 +1,162 @@
 /* *************************************************************
- * press_type.cpp - Wrapper Library to determine button press type
+ * press_type.cpp - Library to determine button press type
  *   press_types:  short press, long press and double press
  *
  *  C W Greenstreet, Ver1, 7Sep21
  *    MIT Licence - Released into the public domain
  *
- * Library encapsulates and integrates selected features from
- *    1) Yabl (Yet another button library for Arduino)
- *           https://github.com/yergin/Yabl
- *    2) Bounce2 (debouncng library)
- *           https://github.com/thomasfredericks/Bounce2
+ *  Ver2, 17Oct26: interrupt-driven edge capture + timestamp classifier
+ *    (replaces Yabl / Bounce2 polling); multiple pedals + chords via PedalBank;
+ *    templated on the board profile
  *
  * ************************************************************ */
 
-// set up debug scaffold; comment out following line if you want to "turn off" debugging to serial monitor
-#define DEBUG 1
+// module log level (see logger.h); raise with build_flags -D LOG_LEVEL_PRESS_TYPE=LOG_LEVEL_DEBUG
+#define LOG_MODULE_LEVEL LOG_LEVEL_PRESS_TYPE
 
 #include "press_type.h"
 
 #include <Arduino.h>
-#include <Yabl.h>
 
+#include "hal.h"           // micros / digitalRead / interrupt attach
+#include "latencyProbe.h"  // press -> HID latency instrumentation
+#include "logger.h"        // deferred serial logging
 #include "myConstants.h"  // all constants in one file
+#include "traceRecorder.h"  // raw pedal edges + gestures for field traces
+
+Press_Type button;  // instantiate button object
+
+// Press_Type constructor; pedals attached in begin()
+template <typename BOARD>
+Press_TypeT<BOARD>::Press_TypeT() : _tracedRaw(0),
+                                    _edgeNotify(nullptr),
+                                    _bank(SWITCH_DEBOUNCE_MSEC * 1000UL,
+                                          DOUBLE_TAP_WINDOW_MSEC * 1000UL,
+                                          HOLD_DURATION_MSEC * 1000UL,
+                                          CHORD_WINDOW_MSEC * 1000UL) {
+    _last.type = NO_PRESS;
+    _last.pedal = 0;
+    _last.chord = 0;
+    _last.start_usec = 0;
+    for (int c = 0; c < MAX_CHORDS; c++) {
+        _chordRow[c] = 0;
+    }
+    _bank.setLowLatency(LOW_LATENCY_TAPS);
+}
 
-const long BAUD_RATE = 115200;  // match native ESP8266 bootup baud rate to view bootup info, otherwise gibberish
-
-Press_Type button(SWITCH_PIN);  // instantiate button object from press_type (YABL child) library
+// pedal ISR (any pedal): snapshot the input register and queue it; classification happens later in update()
+static void IRAM_ATTR onSwitchEdge() {
+    button.captureScan();
+}
 
-// Press_Type constructor attaching button switch
-Press_Type::Press_Type(const int switchPin) {
-    _pin = switchPin;
+template <typename BOARD>
+void IRAM_ATTR Press_TypeT<BOARD>::captureScan() {
+    pedalScan_t scan;
+    scan.time_usec = halMicros();
+    scan.levels = halReadInputs();  // every pedal in one read; NO switch with pull-up: LOW = pressed
+    _scanQueue.push(scan);          // drop counted if full; onTick() recovers the levels
+    if (_edgeNotify != nullptr) {
+        _edgeNotify();
+    }
 }
 
-// pressType_T is an enum type defined in press_type.h header file (as extern); pressEventCode is global
-pressType_T pressEventCode;
-
-// -------------------------
-//   onButtonEvent() function purpose: perform switch-case, triggered by Yabl library callback actions
-//      depending on button press type
-// --------------------------
-void onButtonEvent(const EventInfo& info) {
-    switch (info.event) {
-        case SINGLE_TAP:
-            pressEventCode = SHORT_PRESS;  // pressEventCode == 1
-#if DEBUG
-            Serial.println();
-            Serial.print(F("Short Press!  pressEventCode = "));
-            Serial.println(pressEventCode);
-#endif  // end DEBUG
-            break;
-
-        case DOUBLE_TAP:
-            pressEventCode = DOUBLE_PRESS;  // pressEventCode == 2
-#if DEBUG
-            Serial.println();
-            Serial.print(F("Double Tap Press!  pressEventCode = "));
-            Serial.println(pressEventCode);
-#endif  // end DEBUG
-            break;
-
-        case HOLD:
-            pressEventCode = LONG_PRESS;  // pressEventCode == 3
-#if DEBUG
-            Serial.println();
-            Serial.print(F("Long Press!  pressEventCode = "));
-            Serial.println(pressEventCode);
-#endif  // end DEBUG
-            break;
-
-        default:
-            pressEventCode = NO_PRESS;  // pressEventCode == 0
+template <typename BOARD>
+void Press_TypeT<BOARD>::begin() {
+    for (int p = 0; p < PEDAL_COUNT; p++) {
+        if (BOARD::SWITCH_INTERNAL_PULLUP) {
+            halPinModeInputPullup(PEDALS[p].pin);  // pin configured to pull-up mode
+        } else {
+            halPinModeInput(PEDALS[p].pin);  // board fits external pull-ups
+        }
+        if (_bank.addPedal(PEDALS[p].pin) < 0) {
+            LOG_WARN("Pedal %d: pin %d not usable", p, PEDALS[p].pin);
+            continue;
+        }
+        halAttachChangeInterrupt(PEDALS[p].pin, onSwitchEdge);
     }
+    for (int c = 0; c < CHORD_COUNT; c++) {
+        if (CHORDS[c].pedalMask == 0) {
+            continue;
+        }
+        int index = _bank.addChord(CHORDS[c].pedalMask);
+        if (index < 0) {
+            LOG_WARN("Chord %d: needs two or more pedals", c);
+            continue;
+        }
+        _chordRow[index] = (uint8_t)c;
+    }
+
+    LOG_INFO("%d pedal(s) (interrupt capture) ready; first on pin %d", _bank.count(), PEDALS[0].pin);
 }
 
-void Press_Type::begin(int _pin) {
-    button.attach(_pin, INPUT_PULLUP);  // pin configured to pull-up mode
-    button.callback(onButtonEvent);
+/*****************************************************************************
+Purpose     : Drains captured input register scans through the pedal bank, then
+                expires hold / double tap timers.  Call every loop pass.
+
+Input Value : -
+Return Value: true when a press event (gesture) is ready; query with triggered(),
+                pedal() and chord()
+********************************************************************************/
+template <typename BOARD>
+bool Press_TypeT<BOARD>::update() {
+    pedalScan_t scan;
+    pedalGesture_t event;
+    bool ready = _bank.takeGesture(event);
+
+    while (!ready && _scanQueue.pop(scan)) {
+        _bank.onScan(scan);
+        trace(scan.time_usec);
+        ready = _bank.takeGesture(event);
+    }
+    if (!ready) {
+        uint32_t now_usec = halMicros();
+        _bank.onTick(now_usec, halReadInputs());
+        trace(now_usec);
+        ready = _bank.takeGesture(event);
+    }
 
-    Serial.begin(BAUD_RATE);
+    if (!ready) {
+        _last.type = NO_PRESS;
+        return false;
+    }
+    _last = event;
+    TRACE_RECORD(TRACE_GESTURE, halMicros(), event.type | (event.pedal << 4) | (event.chord << 8));
+
+    LATENCY_GESTURE(event.type == SHORT_PRESS   ? LATENCY_SINGLE
+                    : event.type == LONG_PRESS  ? LATENCY_HOLD
+                    : event.type == CHORD_PRESS ? LATENCY_CHORD
+                                                : LATENCY_DOUBLE,
+                    event.start_usec, halMicros());
+
+    // 1 = short, 2 = double, 3 = long, 4 = double after speculative short, 5 = chord
+    LOG_DEBUG("Press event!  type = %d, pedal %d", event.type, event.pedal);
+
+    return true;
+}
 
-#if DEBUG
-    Serial.println("   ");  // blank line for visual space
-    Serial.println("     Yabl Test follows");
-    Serial.println("==============================");
-    Serial.println();
-#endif  // DEBUG
+// raw pedal levels into the trace whenever they change (includes contact bounce)
+template <typename BOARD>
+void Press_TypeT<BOARD>::trace(uint32_t time_usec) {
+    if (_bank.rawMask() != _tracedRaw) {
+        _tracedRaw = _bank.rawMask();
+        TRACE_RECORD(TRACE_PEDALS, time_usec, _tracedRaw);
+    }
 }
 
-void Press_Type::functionTest() {
-    if (pressEventCode == 1) {
-        Serial.print("*** Short Press! pressEventCode = ");
-        Serial.println(pressEventCode);
+template <typename BOARD>
+void Press_TypeT<BOARD>::functionTest() {
+    if (_last.type == 1) {
+        Serial.print("*** Short Press! type = ");
+        Serial.println(_last.type);
     }
-    if (pressEventCode == 2) {
-        Serial.print("*** Double Press! pressEventCode = ");
-        Serial.println(pressEventCode);
+    if (_last.type == 2) {
+        Serial.print("*** Double Press! type = ");
+        Serial.println(_last.type);
     }
-    if (pressEventCode == 3) {
-        Serial.print("*** Long Press! pressEventCode = ");
-        Serial.println(pressEventCode);
+    if (_last.type == 3) {
+        Serial.print("*** Long Press! type = ");
+        Serial.println(_last.type);
     }
-}
\ No newline at end of file
+}
+
+template class Press_TypeT<Board>;  // only the profile being built is compiled
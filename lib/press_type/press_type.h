@@ -1,15 +1,18 @@
 /* *************************************************************
- * press_type.h - Header for Wrapper Library to determine button press type
+ * press_type.h - Header for Library to determine button press type
  *   press_types:  short press, long press and double press
  *
  *  C W Greenstreet, Ver1, 7Sep21
  *    MIT Licence - Released into the public domain
  *
- * This wrapper library encapsulates and integrates selected features from
- *    1) Yabl (Yet another button library for Arduino)
- *           https://github.com/yergin/Yabl
- *    2) Bounce2 (debouncng library)
- *           https://github.com/thomasfredericks/Bounce2
+ *  Ver2, 17Oct26: Yabl polling replaced by interrupt-driven edge capture.
+ *    The switch ISR timestamps every edge (micros()) into a lock-free queue;
+ *    debounce and gesture classification run on those timestamps (see
+ *    gestureClassifier.h), so press timing no longer depends on loop() speed.
+ *    Multiple pedals (see PEDALS in myConstants.h): the ISR snapshots the whole
+ *    GPIO input register; pedalBank.h debounces every pedal and detects chords.
+ *    Templated on the board profile (Press_TypeT<BOARD>) for the pull-up choice.
+ *    The last gesture is read through triggered() / type() (no global pressEventCode).
  *
  * ************************************************************ */
 
@@ -24,38 +27,48 @@
 #include <pins_arduino.h>
 #endif  // end if-block
 
-#include <Yabl.h>
+#include "boardProfile.h"      // Board
+#include "gestureClassifier.h"  // pressType_T
+#include "pedalBank.h"         // pedalScan_t, pedalGesture_t
+#include "spscQueue.h"
 
-enum pressType_T { NO_PRESS,
-                   SHORT_PRESS,
-                   DOUBLE_PRESS,
-                   LONG_PRESS};
+constexpr uint16_t SWITCH_EDGE_QUEUE_SIZE = 32;  // power of 2; ~16 presses of headroom for a stalled loop()
 
-// pressEventCode_T defined in implementation file, press_type.cpp, hence extern keyword
-extern pressType_T pressEventCode;
-
-// Press_Type class - wrapper class to determine press type; inherited from Yabl::Button class
-class Press_Type : public Button {
+// Press_Type class - captures pedal edges by interrupt and classifies press type
+template <typename BOARD>
+class Press_TypeT {
    public:
-    Press_Type(const int switchPin);  // constructor - will initialise switchPin
+    Press_TypeT();  // constructor - pedals come from the PEDALS table in begin()
 
     // prototype functions - see *.cpp for method code
-    void begin(const int _pin);
+    void begin();
+    bool update();
+    bool triggered(pressType_T pressType) const { return _last.type == pressType; }
+    pressType_T type() const { return _last.type; }  // type of the last gesture, NO_PRESS if none
+    int pedal() const { return _last.pedal; }  // PEDALS index of the last gesture
+    int chord() const { return _chordRow[_last.chord]; }  // CHORDS index, CHORD_PRESS only
+    uint32_t droppedEdges() const { return _scanQueue.dropped(); }
+    bool isIdle() const { return _scanQueue.isEmpty() && _bank.isIdle(); }
+    void onEdgeCaptured(void (*notify)()) { _edgeNotify = notify; }  // ISR context callback, eg wake input task
+    void setLowLatencyMode(bool lowLatency) { _bank.setLowLatency(lowLatency); }
+    bool isLowLatencyMode() const { return _bank.isLowLatency(); }
     void functionTest();
-    // void checkPress();  unecessary code
+    const PedalBank& bank() const { return _bank; }  // configuration for trace headers
+
+    void captureScan();  // called from pedal ISR only
 
    private:
-    int _pin;
+    void trace(uint32_t time_usec);
+
+    pedalGesture_t _last;
+    uint8_t _chordRow[MAX_CHORDS];  // bank chord index -> CHORDS row
+    uint8_t _tracedRaw;             // raw pedal mask last written to the trace
+    void (*_edgeNotify)();
+    PedalBank _bank;
+    SpscQueue<pedalScan_t, SWITCH_EDGE_QUEUE_SIZE> _scanQueue;  // ISR -> update()
 };
 
+typedef Press_TypeT<Board> Press_Type;
 extern Press_Type button;  // ensure button object is visible everywhere
 
-/*****************************************************************
- *  Note: unsuccessful at declaring onButtonEvent function prototype below within Press_Type class
- *     above as a member function without compiler giving "invalid use of non-static member function" error
- *
- *  see discussion: https://arduino.stackexchange.com/questions/33795/error-invalid-use-of-non-static-member-function-while-calling-a-function-from
- *****************************************************************/
-void onButtonEvent(const EventInfo& info);
-
-#endif  // end header guard
\ No newline at end of file
+#endif  // end header guard
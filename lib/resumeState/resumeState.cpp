@@ -0,0 +1,44 @@
+/*
+ * *************************************************************
+ * resumeState.cpp - implementation file for state retained through auto-off deep sleep
+ *
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include "resumeState.h"
+
+#include <stddef.h>  // offsetof
+#include <string.h>
+
+constexpr uint32_t RESUME_STATE_MAGIC = 0x666C6970;  // "flip"
+constexpr uint16_t RESUME_STATE_VERSION = 1;         // bump when resumeState_t changes
+
+// FNV-1a over everything before the checksum field
+static uint32_t resumeChecksum(const resumeState_t& state) {
+    const uint8_t* bytes = (const uint8_t*)&state;
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < offsetof(resumeState_t, checksum); i++) {
+        hash = (hash ^ bytes[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+void resumeStateSave(resumeState_t& state) {
+    state.magic = RESUME_STATE_MAGIC;
+    state.version = RESUME_STATE_VERSION;
+    state.checksum = resumeChecksum(state);
+    memcpy(halRetainedMemory(), &state, sizeof(state));
+}
+
+bool resumeStateLoad(resumeState_t& state) {
+    memcpy(&state, halRetainedMemory(), sizeof(state));
+    return (state.magic == RESUME_STATE_MAGIC) && (state.version == RESUME_STATE_VERSION) &&
+           (state.checksum == resumeChecksum(state));
+}
+
+void resumeStateClear() {
+    memset(halRetainedMemory(), 0, sizeof(resumeState_t));
+}
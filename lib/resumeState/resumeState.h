@@ -0,0 +1,43 @@
+/*
+ * *************************************************************
+ * resumeState.h - Header file for state retained through auto-off deep sleep
+ *
+ *   Saved to RTC slow memory (halRetainedMemory) just before auto-off; on a
+ *   foot switch wake it lets setup() skip the cold-boot path: battery filter
+ *   seeded instead of primed, battery status display skipped, gesture
+ *   settings restored.  (Bonded host is retained by the HAL itself.)
+ *   Checked by magic, version and checksum - RTC memory is garbage after
+ *   power-on.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef RESUME_STATE_H  // begin header guard
+#define RESUME_STATE_H
+
+#include <stdint.h>
+
+#include "hal.h"  // halRetainedMemory()
+
+struct resumeState_t {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t battery_mV;     // filtered pack voltage at auto-off
+    uint8_t batteryPercent;  // last percentage reported to the central
+    bool lowLatencyTaps;     // gesture config (may have been changed at run time)
+    uint32_t sleepCount;     // auto-off cycles since power-on
+    uint32_t checksum;       // over all fields above
+};
+
+static_assert(sizeof(resumeState_t) <= HAL_RETAINED_BYTES, "resumeState_t must fit in retained RTC memory");
+
+/******************************************************
+// Function prototypes:
+******************************************************/
+void resumeStateSave(resumeState_t& state);  // fills magic / version / checksum
+bool resumeStateLoad(resumeState_t& state);  // false if nothing valid retained
+void resumeStateClear();
+
+#endif  // end header guard
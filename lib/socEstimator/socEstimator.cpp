@@ -0,0 +1,67 @@
+/*
+ * *************************************************************
+ * socEstimator.cpp - implementation file for LiPo state-of-charge estimator
+ *
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include "socEstimator.h"
+
+// SocEstimator constructor
+SocEstimator::SocEstimator(uint8_t hysteresis_percent) : _hysteresis_percent(hysteresis_percent),
+                                                         _reported_percent(100),
+                                                         _primed(false),
+                                                         _notifyCount(0) {
+}
+
+/*****************************************************************************
+Description : Discharge curve lookup with linear interpolation, all integer math
+
+Input Value : millivolts - battery (pack) voltage
+Return Value: state of charge in tenths of a percent (0 - 1000)
+********************************************************************************/
+uint16_t SocEstimator::permilleFromMillivolts(uint32_t millivolts) {
+    if (millivolts <= LIPO_DISCHARGE_CURVE[0].millivolts) {
+        return LIPO_DISCHARGE_CURVE[0].permille;
+    }
+    for (int i = 1; i < LIPO_CURVE_POINTS; i++) {
+        const socPoint_t& hi = LIPO_DISCHARGE_CURVE[i];
+        if (millivolts <= hi.millivolts) {
+            const socPoint_t& lo = LIPO_DISCHARGE_CURVE[i - 1];
+            return lo.permille + (uint16_t)(((millivolts - lo.millivolts) * (uint32_t)(hi.permille - lo.permille)) /
+                                            (uint32_t)(hi.millivolts - lo.millivolts));
+        }
+    }
+    return LIPO_DISCHARGE_CURVE[LIPO_CURVE_POINTS - 1].permille;
+}
+
+/*****************************************************************************
+Description : Feeds a new (filtered) battery voltage.  The reported percentage
+                only moves once the estimate differs from it by at least the
+                hysteresis, so noise and load recovery do not flap the value.
+
+Input Value : millivolts - battery (pack) voltage
+Return Value: true if the reported percentage changed (central should be notified)
+********************************************************************************/
+bool SocEstimator::update(uint32_t millivolts) {
+    uint8_t estimate = (uint8_t)((permilleFromMillivolts(millivolts) + 5) / 10);  // rounded to whole percent
+
+    if (_primed) {
+        uint8_t delta = (estimate > _reported_percent) ? estimate - _reported_percent : _reported_percent - estimate;
+        if ((delta == 0) || (delta < _hysteresis_percent)) {
+            return false;
+        }
+    }
+    _primed = true;
+    _reported_percent = estimate;
+    _notifyCount++;
+    return true;
+}
+
+void SocEstimator::resume(uint8_t percent) {
+    _reported_percent = percent;
+    _primed = true;
+}
@@ -0,0 +1,65 @@
+/*
+ * *************************************************************
+ * socEstimator.h - Header file for LiPo state-of-charge (SoC) estimator
+ *
+ *   Maps filtered battery voltage to charge percentage through a compile-time
+ *   1S LiPo discharge curve (integer millivolts / tenths of a percent, linear
+ *   interpolation between points), with hysteresis so the percentage reported
+ *   to the BLE central only changes when the estimate really moves.
+ *   No Arduino dependency - can be run against recorded voltage traces on a host.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef SOC_ESTIMATOR_H  // begin header guard
+#define SOC_ESTIMATOR_H
+
+#include <stdint.h>
+
+struct socPoint_t {
+    uint16_t millivolts;
+    uint16_t permille;  // state of charge in tenths of a percent
+};
+
+// typical 1S LiPo open-circuit discharge curve, light load; ascending voltage.
+//   0% pinned at 3.0V where flipTurn auto-shuts down (see LOW_BATTERY_VOLTAGE)
+constexpr socPoint_t LIPO_DISCHARGE_CURVE[] = {
+    {3000, 0}, {3400, 20}, {3610, 50}, {3690, 100}, {3710, 150}, {3730, 200},
+    {3750, 250}, {3770, 300}, {3790, 350}, {3800, 400}, {3820, 450}, {3840, 500},
+    {3850, 550}, {3870, 600}, {3910, 650}, {3950, 700}, {3980, 750}, {4020, 800},
+    {4080, 850}, {4110, 900}, {4150, 950}, {4200, 1000}};
+
+constexpr int LIPO_CURVE_POINTS = sizeof(LIPO_DISCHARGE_CURVE) / sizeof(LIPO_DISCHARGE_CURVE[0]);
+
+// compile-time check that the curve is strictly increasing in both columns (interpolation relies on it)
+constexpr bool socCurveIsAscending(int i = 1) {
+    return (i >= LIPO_CURVE_POINTS) ||
+           ((LIPO_DISCHARGE_CURVE[i].millivolts > LIPO_DISCHARGE_CURVE[i - 1].millivolts) &&
+            (LIPO_DISCHARGE_CURVE[i].permille > LIPO_DISCHARGE_CURVE[i - 1].permille) &&
+            socCurveIsAscending(i + 1));
+}
+static_assert(socCurveIsAscending(), "LIPO_DISCHARGE_CURVE must be strictly ascending");
+
+class SocEstimator {
+   public:
+    SocEstimator(uint8_t hysteresis_percent);  // constructor prototype
+
+    // method prototypes:
+    static uint16_t permilleFromMillivolts(uint32_t millivolts);
+    bool update(uint32_t millivolts);
+    void resume(uint8_t percent);  // percentage reported before auto-off; hysteresis applies from there
+    uint8_t percent() const { return _reported_percent; }
+    uint32_t notifyCount() const { return _notifyCount; }
+
+   private:
+    uint8_t _hysteresis_percent;
+    uint8_t _reported_percent;
+    bool _primed;
+    uint32_t _notifyCount;
+};
+
+extern SocEstimator socEstimator;  // instantiated in flipState.cpp
+
+#endif  // end header guard
@@ -0,0 +1,75 @@
+/*
+ * *************************************************************
+ * spscQueue.h - lock-free single-producer / single-consumer ring buffer
+ *
+ *   Fixed capacity (power of 2), no heap.  Producer may be an ISR or a
+ *   task on one core, consumer a task on the other; only the producer
+ *   writes _head and only the consumer writes _tail.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef SPSC_QUEUE_H  // begin header guard
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+
+#include <atomic>
+
+template <typename T, uint16_t CAPACITY>
+class SpscQueue {
+    static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "SpscQueue CAPACITY must be a power of 2");
+
+   public:
+    SpscQueue() : _head(0), _tail(0), _dropped(0) {}
+
+    // producer side; returns false (and counts a drop) if full - never blocks, ISR safe
+    bool push(const T& item) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        if ((head - _tail.load(std::memory_order_acquire)) >= CAPACITY) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _items[head & (CAPACITY - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side; returns false if empty
+    bool pop(T& item) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = _items[tail & (CAPACITY - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side; look at the oldest item without removing it
+    bool peek(T& item) const {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = _items[tail & (CAPACITY - 1)];
+        return true;
+    }
+
+    uint16_t size() const {
+        return (uint16_t)(_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire));
+    }
+    bool isEmpty() const { return size() == 0; }
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+    static constexpr uint16_t capacity() { return CAPACITY; }
+
+   private:
+    T _items[CAPACITY];
+    std::atomic<uint32_t> _head;  // next slot to write (producer); 32 bit so loads/stores are native on Xtensa
+    std::atomic<uint32_t> _tail;  // next slot to read (consumer)
+    std::atomic<uint32_t> _dropped;
+};
+
+#endif  // end header guard
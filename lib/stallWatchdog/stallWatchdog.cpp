@@ -0,0 +1,257 @@
+/*
+ * *************************************************************
+ * stallWatchdog.cpp - implementation file for task stall watchdog
+ *
+ *   Concurrency: a subsystem is only written by its own task and by the tick
+ *   hook of the core that task is pinned to, which cannot run at the same
+ *   time; the task parks the subsystem (STATE_NONE) while it updates it.  The
+ *   record is shared by both cores, so writers take a try-lock and skip if it
+ *   is held - the next tick catches up.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include "stallWatchdog.h"
+
+#include <stddef.h>  // offsetof
+#include <string.h>
+
+StallWatchdog stallWatchdog;
+
+constexpr uint32_t STALL_RECORD_MAGIC = 0x73746C31;  // "stl1"; change when stallRecord_t changes
+
+enum subsystemState_t { STATE_NONE,  // not started, or being updated by its task
+                        STATE_IN_PASS,
+                        STATE_WAITING };
+
+// FNV-1a over everything before the checksum field (IRAM: also run from the tick hook)
+static uint32_t IRAM_ATTR recordChecksum(const stallRecord_t& record) {
+    const uint8_t* bytes = (const uint8_t*)&record;
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < offsetof(stallRecord_t, checksum); i++) {
+        hash = (hash ^ bytes[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+// StallWatchdog constructor
+StallWatchdog::StallWatchdog() : _count(0), _store(nullptr), _recordBusy(0) {
+    memset(_sub, 0, sizeof(_sub));
+    memset(&_record, 0, sizeof(_record));
+}
+
+int StallWatchdog::addSubsystem(const char* name, const char* const* stageNames, int stageCount, int core,
+                                uint32_t budget_usec, uint32_t heartbeatSlack_usec) {
+    if (_count >= STALL_MAX_SUBSYSTEMS) {
+        return -1;
+    }
+    subsystem_t& s = _sub[_count];
+    s.name = name;
+    s.stageNames = stageNames;
+    s.stageCount = stageCount;
+    s.core = core;
+    s.budget_usec = budget_usec;
+    s.heartbeatSlack_usec = heartbeatSlack_usec;
+    s.state = STATE_NONE;
+    return _count++;
+}
+
+/*****************************************************************************
+Description : Picks up a stall record left in no-init RTC memory by an earlier
+                boot (counting this boot against it), else starts a clean one
+
+Input Value : -
+Return Value: true if a record survived the last reset
+********************************************************************************/
+bool StallWatchdog::begin() {
+    _store = halNoInitMemory();
+    memcpy(&_record, _store, sizeof(_record));
+    bool survived = (_record.magic == STALL_RECORD_MAGIC) && (_record.checksum == recordChecksum(_record)) &&
+                    (_record.stalls > 0);
+    if (survived) {
+        if (_record.boots < 0xff) {
+            _record.boots++;
+        }
+    } else {
+        memset(&_record, 0, sizeof(_record));
+        _record.magic = STALL_RECORD_MAGIC;
+    }
+    writeRecord();
+    return survived;
+}
+
+/*****************************************************************************
+Description : Start of a pass, after the task's wait.  Closes a missed
+                heartbeat stall (its final lateness) if the wait overran.
+
+Input Value : id - from addSubsystem(), now_usec - halMicros()
+Return Value: -
+********************************************************************************/
+void StallWatchdog::beginPass(int id, uint32_t now_usec) {
+    subsystem_t& s = _sub[id];
+    uint8_t previous = s.state;
+    s.state = STATE_NONE;
+    if (previous == STATE_WAITING) {
+        uint32_t late_usec = now_usec - s.since_usec - s.wait_usec;
+        if ((int32_t)late_usec > (int32_t)s.heartbeatSlack_usec) {
+            note(id, late_usec, STALL_STAGE_WAITING, false);
+        }
+    }
+    s.since_usec = now_usec;
+    s.stage = 0;
+    s.overBudget = false;
+    s.stalled = false;
+    s.recordOwner = false;
+    s.state = STATE_IN_PASS;
+}
+
+// stage index done; remembers the stage the budget ran out in, for overruns the tick hook did not see
+void StallWatchdog::stage(int id, int index, uint32_t now_usec) {
+    subsystem_t& s = _sub[id];
+    if (!s.overBudget && ((now_usec - s.since_usec) > s.budget_usec)) {
+        s.overBudget = true;
+        s.overStage = (uint8_t)index;
+    }
+    s.stage = (uint8_t)(index + 1);  // the next stage is now running
+}
+
+/*****************************************************************************
+Description : End of a pass, before the task's wait.  An overrun is noted with
+                its final length; the heartbeat is then due within wait_usec
+                plus the subsystem's slack.
+
+Input Value : id, now_usec - halMicros()
+              wait_usec - longest the task will wait before its next pass
+Return Value: -
+********************************************************************************/
+void StallWatchdog::endPass(int id, uint32_t now_usec, uint32_t wait_usec) {
+    subsystem_t& s = _sub[id];
+    if (s.state != STATE_IN_PASS) {
+        return;
+    }
+    s.state = STATE_NONE;
+    uint32_t pass_usec = now_usec - s.since_usec;
+    if (pass_usec > s.budget_usec) {
+        note(id, pass_usec, s.overBudget ? s.overStage : s.stage, false);
+    }
+    s.since_usec = now_usec;
+    s.wait_usec = wait_usec;
+    s.stalled = false;
+    s.recordOwner = false;
+    s.state = STATE_WAITING;
+}
+
+/*****************************************************************************
+Description : Tick hook: notes a stall still in progress on this core - a pass
+                over budget, or a wait past its heartbeat - so the code running
+                right now can be backtraced
+
+Input Value : core - the tick's core, now_usec - halMicros()
+Return Value: -
+********************************************************************************/
+void IRAM_ATTR StallWatchdog::poll(int core, uint32_t now_usec) {
+    for (int id = 0; id < _count; id++) {
+        subsystem_t& s = _sub[id];
+        if (s.core != core) {
+            continue;
+        }
+        uint32_t elapsed_usec = now_usec - s.since_usec;
+        if ((s.state == STATE_IN_PASS) && (elapsed_usec > s.budget_usec)) {
+            note(id, elapsed_usec, s.stage, true);
+        } else if ((s.state == STATE_WAITING) && (elapsed_usec > s.wait_usec + s.heartbeatSlack_usec)) {
+            note(id, elapsed_usec - s.wait_usec, STALL_STAGE_WAITING, true);
+        }
+    }
+}
+
+/*****************************************************************************
+Description : Counts a stall once and, if it is (or already holds) the worst
+                recorded, writes it through to no-init memory.  A stall caught
+                in progress (live) snapshots the interrupted backtrace once.
+
+Input Value : id, duration_usec - so far / final
+              stage - running when the budget ran out, live - from the tick hook
+Return Value: -
+********************************************************************************/
+void IRAM_ATTR StallWatchdog::note(int id, uint32_t duration_usec, uint8_t stage, bool live) {
+    subsystem_t& s = _sub[id];
+    bool first = !s.stalled;
+    if (first) {
+        s.stalled = true;
+        s.stalledStage = stage;
+        s.stalls++;
+    }
+    if (duration_usec > s.worst_usec) {
+        s.worst_usec = duration_usec;
+    }
+
+    uint32_t unlocked = 0;
+    if (!__atomic_compare_exchange_n(&_recordBusy, &unlocked, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return;  // other core is writing; this stall is seen again next tick (or counted short)
+    }
+    if (first && (_record.stalls < 0xffff)) {
+        _record.stalls++;
+    }
+    if (!s.recordOwner && (duration_usec > _record.duration_usec)) {
+        for (int other = 0; other < _count; other++) {
+            _sub[other].recordOwner = false;
+        }
+        s.recordOwner = true;
+        _record.subsystem = (uint8_t)id;
+        _record.stage = s.stalledStage;
+        _record.uptime_msec = halMillis() - duration_usec / 1000;  // when it started
+        _record.depth = 0;
+        _record.boots = 0;
+        _record.task[0] = 0;
+    }
+    if (s.recordOwner) {
+        if (duration_usec > _record.duration_usec) {
+            _record.duration_usec = duration_usec;
+        }
+        if (live && (_record.depth == 0)) {
+            _record.depth = (uint8_t)halInterruptedBacktrace(_record.backtrace, STALL_BACKTRACE_DEPTH,
+                                                            _record.task, STALL_TASK_NAME_BYTES);
+        }
+    }
+    writeRecord();
+    __atomic_store_n(&_recordBusy, 0, __ATOMIC_RELEASE);
+}
+
+void IRAM_ATTR StallWatchdog::writeRecord() {
+    if (_store == nullptr) {
+        return;  // before begin()
+    }
+    _record.checksum = recordChecksum(_record);
+    memcpy(_store, &_record, sizeof(_record));
+}
+
+bool StallWatchdog::record(stallRecord_t& record) const {
+    memcpy(&record, &_record, sizeof(record));
+    return record.stalls > 0;
+}
+
+// forgets the worst stall and counters (eg after reading them); called from the task that reads them
+void StallWatchdog::clear() {
+    uint32_t unlocked = 0;
+    while (!__atomic_compare_exchange_n(&_recordBusy, &unlocked, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        unlocked = 0;
+    }
+    for (int id = 0; id < _count; id++) {
+        _sub[id].stalls = 0;
+        _sub[id].worst_usec = 0;
+        _sub[id].recordOwner = false;
+    }
+    memset(&_record, 0, sizeof(_record));
+    _record.magic = STALL_RECORD_MAGIC;
+    writeRecord();
+    __atomic_store_n(&_recordBusy, 0, __ATOMIC_RELEASE);
+}
+
+const char* StallWatchdog::stageName(int id, uint8_t stage) const {
+    if (stage == STALL_STAGE_WAITING) {
+        return "(between passes)";
+    }
+    return (stage < _sub[id].stageCount) ? _sub[id].stageNames[stage] : "(end of pass)";
+}
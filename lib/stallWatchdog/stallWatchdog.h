@@ -0,0 +1,136 @@
+/*
+ * *************************************************************
+ * stallWatchdog.h - Header file for task stall watchdog
+ *
+ *   Each watched subsystem (task loop) beats at the start of a pass, marks
+ *   its stages and, at the end, says how long it expects to wait before the
+ *   next pass.  A stall is
+ *     overrun   a pass longer than the subsystem's latency budget
+ *     missed    no new pass by the expected wake-up + heartbeat slack (task
+ *               starved, eg by the BLE stack or a flash write)
+ *   poll() runs from the FreeRTOS tick hook on each core, so a stall is
+ *   caught while it is still happening: the backtrace of the code the tick
+ *   interrupted (the stalled task itself, or whatever is starving it) is
+ *   snapshot then.  The worst stall - duration, subsystem, stage, task
+ *   running, backtrace - is kept in RTC memory that survives any reset
+ *   but power-on, so one that ends in a watchdog reset can still be read.
+ *
+ *   Build with -D FLIPTURN_STALL_WATCHDOG=0 to compile every STALL_* macro to nothing.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef STALL_WATCHDOG_H  // begin header guard
+#define STALL_WATCHDOG_H
+
+#include <stdint.h>
+
+#include "hal.h"  // IRAM_ATTR, halNoInitMemory(), halInterruptedBacktrace()
+
+#ifndef FLIPTURN_STALL_WATCHDOG
+#define FLIPTURN_STALL_WATCHDOG 1
+#endif
+
+constexpr int STALL_MAX_SUBSYSTEMS = 4;
+constexpr int STALL_BACKTRACE_DEPTH = 6;
+constexpr int STALL_TASK_NAME_BYTES = 8;
+constexpr uint8_t STALL_STAGE_WAITING = 0xff;  // missed heartbeat: stalled between passes
+
+// worst stall, kept in RTC no-init memory (survives resets, not power-on)
+struct stallRecord_t {
+    uint32_t magic;
+    uint32_t duration_usec;  // so far, if the stall ended in a reset
+    uint32_t uptime_msec;    // when it started
+    uint32_t backtrace[STALL_BACKTRACE_DEPTH];  // program counters, innermost first
+    uint8_t subsystem;
+    uint8_t stage;           // stage running, or STALL_STAGE_WAITING
+    uint8_t depth;           // backtrace entries (0 = not caught in progress)
+    uint8_t boots;           // boots (resets, auto-off wakes) since it was recorded
+    char task[STALL_TASK_NAME_BYTES];  // task the tick interrupted (may not be the stalled one)
+    uint16_t stalls;         // stalls over budget since the record was cleared
+    uint16_t spare;
+    uint32_t checksum;       // over all fields above
+};
+
+static_assert(sizeof(stallRecord_t) <= HAL_NOINIT_BYTES, "stallRecord_t must fit in no-init RTC memory");
+
+class StallWatchdog {
+   public:
+    StallWatchdog();  // constructor prototype
+
+    // method prototypes (set-up, before the tasks and the tick hook start):
+    int addSubsystem(const char* name, const char* const* stageNames, int stageCount, int core,
+                     uint32_t budget_usec, uint32_t heartbeatSlack_usec);  // id, -1 if full
+    bool begin();  // true if a stall record survived the last reset
+
+    // subsystem's own task
+    void beginPass(int id, uint32_t now_usec);
+    void stage(int id, int index, uint32_t now_usec);  // stage index done
+    void endPass(int id, uint32_t now_usec, uint32_t wait_usec);  // wait_usec - longest wait before the next pass
+
+    // tick hook (ISR, each core)
+    void IRAM_ATTR poll(int core, uint32_t now_usec);
+
+    // queries + reset (any task)
+    bool record(stallRecord_t& record) const;  // false if no stall recorded
+    void clear();
+    int subsystemCount() const { return _count; }
+    const char* subsystemName(int id) const { return _sub[id].name; }
+    const char* stageName(int id, uint8_t stage) const;
+    uint32_t budget_usec(int id) const { return _sub[id].budget_usec; }
+    uint32_t stalls(int id) const { return _sub[id].stalls; }
+    uint32_t worst_usec(int id) const { return _sub[id].worst_usec; }  // since boot
+
+   private:
+    struct subsystem_t {
+        const char* name;
+        const char* const* stageNames;
+        int stageCount;
+        int core;
+        uint32_t budget_usec;
+        uint32_t heartbeatSlack_usec;
+        volatile uint8_t state;        // subsystemState_t
+        volatile uint8_t stage;        // running (stage after the last mark)
+        volatile uint32_t since_usec;  // pass start, or end of the last pass while waiting
+        volatile uint32_t wait_usec;   // waiting: longest wait the task asked for
+        bool overBudget;               // pass: budget ran out in overStage
+        uint8_t overStage;
+        volatile bool stalled;         // current pass / wait already counted, in stalledStage
+        volatile uint8_t stalledStage;
+        volatile bool recordOwner;     // current stall is the one in the record
+        uint32_t stalls;
+        uint32_t worst_usec;
+    };
+
+    void IRAM_ATTR note(int id, uint32_t duration_usec, uint8_t stage, bool live);
+    void IRAM_ATTR writeRecord();
+
+    subsystem_t _sub[STALL_MAX_SUBSYSTEMS];
+    int _count;
+    uint8_t* _store;          // halNoInitMemory(), from begin()
+    stallRecord_t _record;    // working copy; written through to _store
+    uint32_t _recordBusy;     // one writer at a time across cores (try-lock, skip if taken)
+};
+
+extern StallWatchdog stallWatchdog;  // instantiated in stallWatchdog.cpp
+
+// instrumentation macros - vanish when FLIPTURN_STALL_WATCHDOG is 0
+#if FLIPTURN_STALL_WATCHDOG
+#define STALL_PASS_BEGIN(id) stallWatchdog.beginPass((id), halMicros())
+#define STALL_STAGE(id, index) stallWatchdog.stage((id), (index), halMicros())
+#define STALL_PASS_END(id, wait_usec) stallWatchdog.endPass((id), halMicros(), (wait_usec))
+#else
+#define STALL_PASS_BEGIN(id) \
+    do {                     \
+    } while (0)
+#define STALL_STAGE(id, index) \
+    do {                       \
+    } while (0)
+#define STALL_PASS_END(id, wait_usec) \
+    do {                              \
+    } while (0)
+#endif  // FLIPTURN_STALL_WATCHDOG
+
+#endif  // end header guard
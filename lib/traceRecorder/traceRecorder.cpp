@@ -0,0 +1,160 @@
+/*
+ * *************************************************************
+ * traceRecorder.cpp - implementation file for always-on binary trace recorder
+ *
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include "traceRecorder.h"
+
+#include <string.h>
+
+#include <atomic>
+
+#include "hal.h"  // core id
+
+TraceRecorder traceRecorder;
+
+// TraceRecorder constructor; all blocks empty (seq 0)
+TraceRecorder::TraceRecorder() {
+    memset(_ring, 0, sizeof(_ring));
+}
+
+static int putVarint(uint8_t* out, uint32_t value) {
+    int n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+static bool getVarint(const uint8_t* data, int length, int& offset, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; (shift < 35) && (offset < length); shift += 7) {
+        uint8_t byte = data[offset++];
+        value |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int encode(uint8_t* out, traceType_t type, int32_t delta_usec, uint32_t value) {
+    int n = 0;
+    out[n++] = (uint8_t)type;
+    n += putVarint(out + n, ((uint32_t)delta_usec << 1) ^ (uint32_t)(delta_usec >> 31));  // zigzag: small +/- deltas stay short
+    n += putVarint(out + n, value);
+    return n;
+}
+
+/*****************************************************************************
+Description : Appends one record to the calling core's ring.  Never blocks;
+                starting a new block overwrites the oldest one.
+
+Input Value : type, time_usec - halMicros() (or capture time), value
+Return Value: -
+********************************************************************************/
+void TraceRecorder::record(traceType_t type, uint32_t time_usec, uint32_t value) {
+    ring_t& ring = _ring[halCoreId() & (TRACE_RINGS - 1)];
+    uint8_t bytes[TRACE_MAX_RECORD_BYTES];
+    traceBlock_t* block = &ring.block[ring.current];
+    int length = 0;
+
+    if (block->seq != 0) {
+        length = encode(bytes, type, (int32_t)(time_usec - ring.last_usec), value);
+    }
+    if ((block->seq == 0) || (block->used + length > (int)sizeof(block->data))) {
+        if (block->seq != 0) {
+            ring.current = (ring.current + 1) % TRACE_BLOCKS;
+            block = &ring.block[ring.current];
+        }
+        block->used = 0;  // invalidate before the header changes (snapshot may run on the other core)
+        std::atomic_thread_fence(std::memory_order_release);
+        block->base_usec = time_usec;
+        if (++ring.seq == 0) {
+            ring.seq = 1;  // 0 = never written
+        }
+        block->seq = ring.seq;
+        length = encode(bytes, type, 0, value);
+    }
+
+    memcpy(block->data + block->used, bytes, length);
+    std::atomic_thread_fence(std::memory_order_release);
+    block->used = block->used + length;
+    ring.last_usec = time_usec;
+    ring.records++;
+}
+
+uint32_t TraceRecorder::records() const {
+    uint32_t total = 0;
+    for (int r = 0; r < TRACE_RINGS; r++) {
+        total += _ring[r].records;
+    }
+    return total;
+}
+
+/*****************************************************************************
+Description : Serialises header + both rings (oldest block first) for a dump or
+                a save to flash.  Safe while recording continues: each block is
+                copied up to its published length.
+
+Input Value : header - caller's configuration (magic / layout fields filled here),
+              out, capacity - at least TRACE_SNAPSHOT_BYTES
+Return Value: bytes written, 0 if capacity too small
+********************************************************************************/
+int TraceRecorder::snapshot(const traceHeader_t& header, uint8_t* out, int capacity) const {
+    if (capacity < TRACE_SNAPSHOT_BYTES) {
+        return 0;
+    }
+    traceHeader_t h = header;
+    h.magic = TRACE_MAGIC;
+    h.version = TRACE_VERSION;
+    h.rings = TRACE_RINGS;
+    h.blocks = TRACE_BLOCKS;
+    h.blockBytes = TRACE_BLOCK_BYTES;
+    memcpy(out, &h, sizeof(h));
+    int length = sizeof(h);
+
+    for (int r = 0; r < TRACE_RINGS; r++) {
+        const ring_t& ring = _ring[r];
+        for (int i = 1; i <= TRACE_BLOCKS; i++) {
+            const traceBlock_t& block = ring.block[(ring.current + i) % TRACE_BLOCKS];
+            traceBlock_t copy;
+            copy.used = block.used;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            copy.base_usec = block.base_usec;
+            copy.seq = block.seq;
+            memcpy(copy.data, block.data, copy.used);
+            memset(copy.data + copy.used, 0, sizeof(copy.data) - copy.used);
+            memcpy(out + length, &copy, sizeof(copy));
+            length += sizeof(copy);
+        }
+    }
+    return length;
+}
+
+bool traceDecode(const traceBlock_t& block, int& offset, traceRecord_t& record) {
+    int used = block.used;
+    if ((block.seq == 0) || (used > (int)sizeof(block.data)) || (offset >= used)) {
+        return false;
+    }
+    if (offset == 0) {
+        record.time_usec = block.base_usec;
+    }
+    uint8_t type = block.data[offset++];
+    uint32_t zigzag, value;
+    if ((type == TRACE_NONE) || (type >= TRACE_TYPE_COUNT) ||
+        !getVarint(block.data, used, offset, zigzag) || !getVarint(block.data, used, offset, value)) {
+        return false;  // torn or corrupt block: stop here
+    }
+    record.time_usec += (uint32_t)((zigzag >> 1) ^ (0u - (zigzag & 1)));
+    record.type = (traceType_t)type;
+    record.value = value;
+    return true;
+}
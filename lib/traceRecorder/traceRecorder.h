@@ -0,0 +1,118 @@
+/*
+ * *************************************************************
+ * traceRecorder.h - Header file for always-on binary trace recorder
+ *
+ *   Records pedal edges (raw, before debounce), classified gestures, HID
+ *   reports, BLE link changes, battery voltage and flipState transitions
+ *   into fixed RAM rings - one per CPU core, so each ring has a single
+ *   producer (as logger.h).  A ring is a circle of blocks; each block starts
+ *   from an absolute timestamp and holds records of
+ *       type (1 byte), zigzag varint time delta (usec), varint value
+ *   so a typical record is 3 - 5 bytes.  When full the oldest block is
+ *   reused.  snapshot() serialises both rings behind a traceHeader_t for a
+ *   serial dump or a save to flash; tools/traceReplay decodes it on a host
+ *   and replays it through the gesture and state logic.
+ *
+ *   Build with -D FLIPTURN_TRACE=0 to compile every TRACE_RECORD to nothing.
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#ifndef TRACE_RECORDER_H  // begin header guard
+#define TRACE_RECORDER_H
+
+#include <stdint.h>
+
+#ifndef FLIPTURN_TRACE
+#define FLIPTURN_TRACE 1  // a few dozen cycles per record; always on so field reports come with a trace
+#endif
+
+constexpr int TRACE_RINGS = 2;           // one per ESP32 core
+constexpr int TRACE_BLOCKS = 16;         // per ring
+constexpr int TRACE_BLOCK_BYTES = 256;   // including the block header
+constexpr int TRACE_MAX_RECORD_BYTES = 11;
+constexpr uint32_t TRACE_MAGIC = 0x52545446;  // "FTTR" little endian
+constexpr uint8_t TRACE_VERSION = 1;
+constexpr int TRACE_MAX_CHORDS = 4;
+
+enum traceType_t { TRACE_NONE,
+                   TRACE_PEDALS,   // raw pedal mask (bit p = pedal p pressed), every captured change
+                   TRACE_GESTURE,  // type | pedal << 4 | chord << 8 (PedalBank indices)
+                   TRACE_HID,      // halKey_t sent
+                   TRACE_LINK,     // BLE connected 1 / 0
+                   TRACE_BATTERY,  // filtered battery millivolts
+                   TRACE_STATE,    // flipState entered
+                   TRACE_TYPE_COUNT };
+
+// front of every snapshot: enough configuration to replay the gestures on a host
+struct traceHeader_t {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t rings;
+    uint8_t blocks;      // per ring
+    uint8_t pedalCount;
+    uint16_t blockBytes;
+    uint8_t lowLatency;  // gesture mode when the snapshot was taken
+    uint8_t chordCount;
+    uint32_t debounce_usec;
+    uint32_t doubleTap_usec;
+    uint32_t hold_usec;
+    uint32_t chordWindow_usec;
+    uint8_t chordMask[TRACE_MAX_CHORDS];
+    uint32_t snapshot_usec;  // halMicros() at snapshot; record times are relative to it
+};
+static_assert(sizeof(traceHeader_t) == 36, "traceHeader_t layout is the dump format");
+
+struct traceBlock_t {
+    uint32_t base_usec;  // time the first record's delta is taken from
+    uint16_t seq;        // block sequence per ring, 0 = never written
+    volatile uint16_t used;  // data bytes; published after the record bytes
+    uint8_t data[TRACE_BLOCK_BYTES - 8];
+};
+static_assert(sizeof(traceBlock_t) == TRACE_BLOCK_BYTES, "traceBlock_t layout is the dump format");
+
+constexpr int TRACE_SNAPSHOT_BYTES = sizeof(traceHeader_t) + TRACE_RINGS * TRACE_BLOCKS * TRACE_BLOCK_BYTES;
+
+struct traceRecord_t {
+    uint32_t time_usec;
+    traceType_t type;
+    uint32_t value;
+};
+
+class TraceRecorder {
+   public:
+    TraceRecorder();  // constructor prototype
+
+    // method prototypes:
+    void record(traceType_t type, uint32_t time_usec, uint32_t value);  // into the calling core's ring
+    int snapshot(const traceHeader_t& header, uint8_t* out, int capacity) const;
+    uint32_t records() const;
+
+   private:
+    struct ring_t {
+        traceBlock_t block[TRACE_BLOCKS];
+        int current;
+        uint16_t seq;
+        uint32_t last_usec;
+        uint32_t records;
+    };
+    ring_t _ring[TRACE_RINGS];
+};
+
+// decoder (host tool + tests): next record of a block; offset starts at 0, time at block.base_usec
+bool traceDecode(const traceBlock_t& block, int& offset, traceRecord_t& record);
+
+extern TraceRecorder traceRecorder;
+
+// instrumentation macro - vanishes when FLIPTURN_TRACE is 0
+#if FLIPTURN_TRACE
+#define TRACE_RECORD(type, time_usec, value) traceRecorder.record((type), (time_usec), (uint32_t)(value))
+#else
+#define TRACE_RECORD(type, time_usec, value) \
+    do {                                     \
+    } while (0)
+#endif  // FLIPTURN_TRACE
+
+#endif  // end header guard
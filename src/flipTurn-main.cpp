@@ -31,7 +31,7 @@
  * *     1) Short Press - Page Down
  * *     2) Double Press - Page Up
  * *     3) Press Hold (long Press):  trigger onscreen virtual keyboard in IOS, and
- * *         show battery charge status colour (green = fully charged, magenta = low charge, red = critically low charge)
+ * *         show battery charge status colour (green = fully charged, orange = low charge, red = critically low charge)
  *
  *?   Pin-out Summary: Refer to myConstants.h for pin-out table plus also see github flipTurn wiki
  *
@@ -67,93 +67,926 @@
  *
  *?    Revisions:
  *       2023.11.27   Ver1 - code under development
+ *       2026.10.17   Ver2 - input (core 1) and background (core 0) FreeRTOS tasks
  *
  ** *************************************************************************************/
 
+//? ************** Selective Debug Scaffolding *********************
+// Log level for this module (see logger.h); other modules have their own LOG_LEVEL_xxx
+//   raise with build_flags, eg  -D LOG_LEVEL_MAIN=LOG_LEVEL_DEBUG
+//   Note: must be defined before #include "logger.h"
+//? *****************************************************************
+#define LOG_MODULE_LEVEL LOG_LEVEL_MAIN
+//? ************ end Selective Debug Scaffolding ********************
+
 // external libraries:
 #include <Arduino.h>  // IDE requires Arduino framework to be explicitly included
-#include <BleKeyboard.h>
-#include <Bounce2.h>
 
 // internal (user) libraries:
-#include "flipState.h"    //  library to manage flipTurn state machine
-#include "myConstants.h"  // all constants in one file + pinout table
-#include "press_type.h"   // wrapper library further abstracting Yabl / Bounce2 switch routines
+#include "advSchedule.h"     // directed / fast / slow BLE advertising while disconnected
+#include "batteryMonitor.h"  // background battery voltage sampling
+#include "batterySaver.h"    // graded power saving on a low battery
+#include "connParams.h"      // adaptive BLE connection interval policy
+#include "controlRGB.h"      // status LED (LEDC engine)
+#include "eventBus.h"        // typed events between tasks and modules (gestures, battery, BLE link, timers)
+#include "flipState.h"       //  library to manage flipTurn state machine
+#include "hal.h"             // hardware abstraction layer (time, BLE keyboard, pwm)
+#include "hidPipeline.h"     // flow-controlled press / release reports, hold-to-scroll
+#include "hidQueue.h"        // coalescing HID event queue, replayed across BLE dropouts
+#include "latencyProbe.h"    // press -> HID latency histograms
+#include "logger.h"          // deferred serial logging
+#include "loopTelemetry.h"   // per task stage cycles, loop period, idle estimate
+#include "myConstants.h"     // all constants in one file + pinout table
+#include "powerPolicy.h"     // CPU frequency / light sleep policy
+#include "press_type.h"      // interrupt-captured foot switch + press type classification
+#include "resumeState.h"     // state retained through auto-off deep sleep
+#include "socEstimator.h"    // battery % reported to central
+#include "stallWatchdog.h"   // task stall detection, worst stall kept through resets
+#include "traceRecorder.h"   // always-on binary trace (serial dump / flash)
 
-//? ************** Selective Debug Scaffolding *********************
-// Selective debug scaffold: comment out  lines below to disable debugging tests at pre-processor stage
-//   Note: #ifdef preprocessor simply tests if the symbol's been defined; therefore #ifdef 0 will not work!
-//   Ref: https://stackoverflow.com/questions/16245633/ifdef-debug-versus-if-debug
-//? *****************************************************************
-// #define DEBUG 1  // uncomment to debug
-//? ************ end Selective Debug Scaffolding ********************
+// short BLE connection interval while playing, long interval + slave latency when idle
+ConnectionPolicy connPolicy(CONN_IDLE_AFTER_MSEC, CONN_UPDATE_RETRY_MSEC);
 
-extern const byte BLE_DELAY;       // Delay (milliseconds) to prevent BT congestion
-extern int current_battery_level;  // initially set to fully charged, 100%
+// directed advertising to the cached bonded central, then fast, then slow advertising
+AdvertisingSchedule advSchedule(ADV_DIRECTED_MSEC, ADV_FAST_MSEC);
+unsigned long disconnected_msec = 0;  // start of current advertising run; 0 = since reset
 
-// timer - global
-unsigned long ledTimer_msec = 0;
+// boot timeline (msec after reset); each phase logged once, serial command 'b' prints it
+enum bootPhase_t { BOOT_SETUP,
+                   BOOT_ADVERTISING,
+                   BOOT_HARDWARE_READY,
+                   BOOT_TASKS_RUNNING,
+                   BOOT_SELF_TEST_DONE,
+                   BOOT_CONNECTED,
+                   BOOT_FIRST_KEYSTROKE,
+                   BOOT_PHASE_COUNT };
+static const char* const bootPhaseName[BOOT_PHASE_COUNT] = {"setup entered", "advertising", "hardware ready",
+                                                            "tasks running", "LED self-test done",
+                                                            "BLE connected", "first keystroke"};
+static unsigned long bootPhase_msec[BOOT_PHASE_COUNT];
+static bool bootPhaseDone[BOOT_PHASE_COUNT];
 
-// run-once flags
-bool hasRun = 0;           // run flag to control single execution within loop
-bool flipStateHasRun = 0;  // run flag to run flipState config once
+// CPU clock + light sleep from input activity; owned by input task, mode changes published to the background
+PowerPolicy powerPolicy(POWER_BOOST_MSEC, POWER_SLEEP_AFTER_MSEC);
+static powerMode_t backgroundPowerMode = POWER_BOOST;  // background task's copy, from EVENT_POWER_MODE
 
-void setup() {
-    Serial.begin(115200);
-    delay(STARTUP_DELAY_MSEC);  // give serial monitor time to initialise to display early status messages
+// battery saver level from the reported charge; owned by background task, CPU side published to the input task
+BatterySaver batterySaver(SAVER_REDUCED_BELOW_PERCENT, SAVER_CRITICAL_BELOW_PERCENT, SAVER_HYSTERESIS_PERCENT);
 
-    // flipState = battery_status;  // show battery status at power-up
+// auto-off: deep sleep after long inactivity, foot switch wakes (needs RTC GPIO)
+bool autoOffAvailable = false;
+unsigned long lastActivity_msec = 0;  // last classified press; owned by background task (gesture events)
+uint32_t autoOffCount = 0;            // auto-off cycles since power-on (retained)
 
-#ifdef DEBUG
-    Serial.println("Preparing flipTurn for BLE connection");
-#endif
+// gesture -> BLE keyboard; owned by input task
+HidEventQueue hidQueue(HID_EVENT_MAX_AGE_MSEC, HID_MAX_LATENCY_MSEC, HID_SEND_GAP_MSEC, HID_RECONNECT_SETTLE_MSEC);
+HidPipeline hidPipeline(hidQueue, HID_MAX_OUTSTANDING, HID_COMPLETION_TIMEOUT_MSEC, HID_REPEAT_INTERVAL_MSEC);
+static int repeatPedal = -1;  // pedal held for hold-to-scroll; -1 = none
 
-    bleKeyboard.begin();
+// FreeRTOS tasks (see inputTask / backgroundTask)
+static TaskHandle_t inputTaskHandle = nullptr;
+static TaskHandle_t backgroundTaskHandle = nullptr;
 
-    // initialise button (eg foot switch); see press_type set-up code
-    button.begin(SWITCH_PIN);
+// event bus timers (EventBus::startTimer ids); expiry is an EVENT_TIMER dispatched on the background task
+enum eventTimerId_t { TIMER_AUTO_OFF };
 
-}  // end setup
+// task loop telemetry; serial command 't' reports, 'T' clears
+enum inputStage_t { INPUT_STAGE_GESTURES,
+                    INPUT_STAGE_HID,
+                    INPUT_STAGE_POWER,
+                    INPUT_STAGE_COUNT };
+static const char* const inputStageName[INPUT_STAGE_COUNT] = {"gestures", "hid send", "power mode"};
+LoopTelemetry inputTelemetry(inputStageName, INPUT_STAGE_COUNT);
 
-void loop() {
-    yield();  // let ESP32 background functions play through to avoid potential WDT reset
-
-    // automatically show battery status on LED at device start-up
-    if (!flipStateHasRun) {  // flag ensures this runs once only
-        ledTimer_msec = millis();  // get timer mark for flipState
-        flipState = battery_status;
-#ifdef DEBUG
-        Serial.println("--------------------------");
-        Serial.print("flipStateHasRun; flipState = ");
-        Serial.println(flipState);
-        Serial.println("--------------------------");
+enum backgroundStage_t { BACKGROUND_STAGE_EVENTS,
+                         BACKGROUND_STAGE_BATTERY,
+                         BACKGROUND_STAGE_STATE,
+                         BACKGROUND_STAGE_BLE,
+                         BACKGROUND_STAGE_SERIAL,
+                         BACKGROUND_STAGE_LOG,
+                         BACKGROUND_STAGE_COUNT };
+static const char* const backgroundStageName[BACKGROUND_STAGE_COUNT] = {"events", "battery", "LED state",
+                                                                        "BLE + auto-off", "serial", "log drain"};
+LoopTelemetry backgroundTelemetry(backgroundStageName, BACKGROUND_STAGE_COUNT);
+
+// stall watchdog subsystems (same stages as the telemetry); serial command 'w' reports, 'W' clears
+static int inputWatch = -1;
+static int backgroundWatch = -1;
+
+// trace snapshot for serial dump ('r', 'f') and flash save ('R'); owned by background task
+static const char TRACE_BLOB_KEY[] = "trace";
+static uint8_t traceSnapshot[TRACE_SNAPSHOT_BYTES];
+static int traceDumpLength = 0;  // 0 = no dump in progress
+static int traceDumpOffset = 0;  // -1 = begin line next
+
+/*****************************************************************************
+Description : Timestamps a boot phase the first time it is reached
+
+Input Value : phase
+Return Value: -
+********************************************************************************/
+void markBootPhase(bootPhase_t phase) {
+    if (bootPhaseDone[phase]) {
+        return;
+    }
+    bootPhase_msec[phase] = halMillis();
+    bootPhaseDone[phase] = true;
+    LOG_INFO("Boot: %s at %lu ms", bootPhaseName[phase], bootPhase_msec[phase]);
+}
+
+/*****************************************************************************
+Description : Queues one task's loop telemetry as log records; logger.drain()
+                prints them as the UART has room
+
+Input Value : name - task, telemetry, task - FreeRTOS handle (stack high-water mark)
+Return Value: -
+********************************************************************************/
+void reportTelemetry(const char* name, const LoopTelemetry& telemetry, TaskHandle_t task) {
+    logger.log(LOG_LEVEL_INFO, "%s: %lu passes, idle %u.%u%%", name, (unsigned long)telemetry.cycles(),
+               telemetry.idlePermille() / 10, telemetry.idlePermille() % 10);
+    logger.log(LOG_LEVEL_INFO, "  period p50 <= %lu us, p99 <= %lu us, max %lu us",
+               (unsigned long)telemetry.periodPercentile_usec(50), (unsigned long)telemetry.periodPercentile_usec(99),
+               (unsigned long)telemetry.maxPeriod_usec());
+    for (int i = 0; i < telemetry.stageCount(); i++) {
+        const telemetryStage_t& stage = telemetry.stageStats(i);
+        unsigned long mean = stage.count ? (unsigned long)(stage.total_cycles / stage.count) : 0;
+        logger.log(LOG_LEVEL_INFO, "  %-14s mean %7lu  max %8lu cycles", telemetry.stageName(i), mean,
+                   (unsigned long)stage.max_cycles);
+    }
+    if (task != nullptr) {
+        logger.log(LOG_LEVEL_INFO, "  stack unused %u bytes", (unsigned)uxTaskGetStackHighWaterMark(task));
+    }
+}
+
+/*****************************************************************************
+Description : Snapshot of the trace rings behind a header describing the
+                gesture configuration (read by tools/traceReplay)
+
+Input Value : -
+Return Value: snapshot length in traceSnapshot
+********************************************************************************/
+int takeTraceSnapshot() {
+    const PedalBank& bank = button.bank();
+    traceHeader_t header = {};
+    header.pedalCount = bank.count();
+    header.lowLatency = button.isLowLatencyMode();
+    header.chordCount = bank.chordCount() < TRACE_MAX_CHORDS ? bank.chordCount() : TRACE_MAX_CHORDS;
+    header.debounce_usec = SWITCH_DEBOUNCE_MSEC * 1000UL;
+    header.doubleTap_usec = DOUBLE_TAP_WINDOW_MSEC * 1000UL;
+    header.hold_usec = HOLD_DURATION_MSEC * 1000UL;
+    header.chordWindow_usec = CHORD_WINDOW_MSEC * 1000UL;
+    for (int c = 0; c < header.chordCount; c++) {
+        header.chordMask[c] = bank.chordMask(c);
+    }
+    header.snapshot_usec = halMicros();
+    return traceRecorder.snapshot(header, traceSnapshot, sizeof(traceSnapshot));
+}
+
+/*****************************************************************************
+Description : Writes the trace dump as hex lines, as far as the UART tx buffer
+                allows without blocking.  Log output waits until it is done.
+
+Input Value : -
+Return Value: true while the dump is still in progress
+********************************************************************************/
+bool traceDumpStep() {
+    static const char hex[] = "0123456789abcdef";
+    constexpr int BYTES_PER_LINE = 32;
+    char line[20 + 2 * BYTES_PER_LINE];
+
+    while (traceDumpLength > 0) {
+        int length;
+        if (traceDumpOffset < 0) {
+            length = snprintf(line, sizeof(line), "TRACE BEGIN %d\r\n", traceDumpLength);
+        } else if (traceDumpOffset >= traceDumpLength) {
+            length = snprintf(line, sizeof(line), "TRACE END\r\n");
+        } else {
+            length = snprintf(line, sizeof(line), "TRACE %04x ", traceDumpOffset);
+            for (int i = traceDumpOffset; (i < traceDumpLength) && (i < traceDumpOffset + BYTES_PER_LINE); i++) {
+                line[length++] = hex[traceSnapshot[i] >> 4];
+                line[length++] = hex[traceSnapshot[i] & 0x0f];
+            }
+            line[length++] = '\r';
+            line[length++] = '\n';
+        }
+        if (halSerialWritable() < length) {
+            return true;
+        }
+        halSerialWrite(line, length);
+        if (traceDumpOffset >= traceDumpLength) {
+            traceDumpLength = 0;
+        } else {
+            traceDumpOffset += (traceDumpOffset < 0) ? 1 : BYTES_PER_LINE;
+        }
+    }
+    return false;
+}
+
+void startTraceDump(int length) {
+    traceDumpLength = length;
+    traceDumpOffset = -1;
+}
+
+/*****************************************************************************
+Description : Prints stall counters per task and the worst stall recorded, which
+                may be from before the last reset.  The backtrace line is in the
+                ESP-IDF panic format, so the esp32_exception_decoder monitor filter
+                (or addr2line) turns it into source lines.
+
+Input Value : -
+Return Value: -
+********************************************************************************/
+void reportStalls() {
+    for (int id = 0; id < stallWatchdog.subsystemCount(); id++) {
+        Serial.printf("stall %-16s budget %6lu us  %5lu stalls  worst %8lu us since boot\r\n",
+                      stallWatchdog.subsystemName(id), (unsigned long)stallWatchdog.budget_usec(id),
+                      (unsigned long)stallWatchdog.stalls(id), (unsigned long)stallWatchdog.worst_usec(id));
+    }
+    stallRecord_t worst;
+    if (!stallWatchdog.record(worst) || (worst.subsystem >= stallWatchdog.subsystemCount())) {
+        Serial.println(F("no stall recorded"));
+        return;
+    }
+    Serial.printf("worst stall %lu us: %s / %s, %lu ms after boot (%u boots ago), %u stalls recorded\r\n",
+                  (unsigned long)worst.duration_usec, stallWatchdog.subsystemName(worst.subsystem),
+                  stallWatchdog.stageName(worst.subsystem, worst.stage), (unsigned long)worst.uptime_msec, worst.boots,
+                  worst.stalls);
+    if (worst.depth == 0) {
+        Serial.println(F("  ended before a tick caught it: no backtrace"));
+        return;
+    }
+    Serial.printf("  running task %.*s\r\nBacktrace:", STALL_TASK_NAME_BYTES, worst.task);
+    for (int i = 0; (i < worst.depth) && (i < STALL_BACKTRACE_DEPTH); i++) {
+        Serial.printf(" 0x%08lx:0x00000000", (unsigned long)worst.backtrace[i]);
+    }
+    Serial.print(F("\r\n"));
+}
+
+/*****************************************************************************
+Description : Non-blocking single character serial monitor commands
+                 l - print press -> HID latency summary
+                 L - clear latency histograms
+                 q - print HID event queue + report pipeline counters
+                 b - print boot timeline
+                 p - print power mode residency
+                 s - print battery saver level residency
+                 t - print task loop telemetry (via the log, never waits on the UART)
+                 T - clear task loop telemetry
+                 w - print stall watchdog counters and the worst stall (kept through resets)
+                 W - clear the stall watchdog record
+                 e - print event bus counters: dispatch cost, pool + lane occupancy
+                 E - clear event bus counters
+                 r - dump the trace (hex lines for tools/traceReplay)
+                 R - save the trace to flash
+                 f - dump the trace saved in flash
+Input Value : -
+Return Value: -
+********************************************************************************/
+void processSerialCommand() {
+    if (!Serial.available()) {
+        return;
+    }
+    switch (Serial.read()) {
+        case 'b':
+            for (int phase = 0; phase < BOOT_PHASE_COUNT; phase++) {
+                if (bootPhaseDone[phase]) {
+                    Serial.printf("boot %-18s %6lu ms\r\n", bootPhaseName[phase], bootPhase_msec[phase]);
+                } else {
+                    Serial.printf("boot %-18s      - \r\n", bootPhaseName[phase]);
+                }
+            }
+            break;
+        case 'p': {
+            static const char* const modeName[POWER_MODE_COUNT] = {"boost", "eco", "sleep"};
+            for (int mode = 0; mode < POWER_MODE_COUNT; mode++) {
+                Serial.printf("power %-5s %9lu ms  %5lu entries\r\n", modeName[mode],
+                              (unsigned long)powerPolicy.residency_msec((powerMode_t)mode),
+                              (unsigned long)powerPolicy.entries((powerMode_t)mode));
+            }
+            break;
+        }
+        case 's':
+            Serial.printf("battery saver: %s (battery %u%%)\r\n", SAVER_PROFILES[batterySaver.level()].name, socEstimator.percent());
+            for (int level = 0; level < SAVER_LEVEL_COUNT; level++) {
+                Serial.printf("saver %-8s %9lu ms  %5lu entries\r\n", SAVER_PROFILES[level].name,
+                              (unsigned long)batterySaver.residency_msec((saverLevel_t)level),
+                              (unsigned long)batterySaver.entries((saverLevel_t)level));
+            }
+            break;
+        case 'q': {
+            const hidQueueStats_t& q = hidQueue.stats();
+            Serial.printf("HID queue: depth %u (max %u), queued %lu, coalesced %lu, sent %lu\r\n",
+                          hidQueue.depth(), q.maxDepth, (unsigned long)q.queued, (unsigned long)q.coalesced,
+                          (unsigned long)q.sent);
+            Serial.printf("  replayed %lu (last %lu ms, max %lu ms), dropped %lu, expired %lu, stale %lu\r\n",
+                          (unsigned long)q.replayed, (unsigned long)q.lastReplay_msec, (unsigned long)q.maxReplay_msec,
+                          (unsigned long)q.dropped, (unsigned long)q.expired, (unsigned long)q.stale);
+            const hidPipelineStats_t& h = hidPipeline.stats();
+            Serial.printf("HID reports: %lu sent (max %u in flight), %lu completed in mean %lu us (max %lu us)\r\n",
+                          (unsigned long)h.reports, h.maxInFlight, (unsigned long)h.completed,
+                          h.completed ? (unsigned long)(h.totalComplete_usec / h.completed) : 0UL,
+                          (unsigned long)h.maxComplete_usec);
+            Serial.printf("  backpressure %lu, refused %lu, lost %lu, repeats %lu (%lu skipped)\r\n",
+                          (unsigned long)h.backpressure, (unsigned long)h.refused, (unsigned long)h.lost,
+                          (unsigned long)h.repeats, (unsigned long)h.repeatsSkipped);
+            break;
+        }
+        case 't':
+            reportTelemetry("input task", inputTelemetry, inputTaskHandle);
+            reportTelemetry("background task", backgroundTelemetry, backgroundTaskHandle);
+            logger.log(LOG_LEVEL_INFO, "heap free %lu bytes, low-water %lu bytes", (unsigned long)halHeapFree(),
+                       (unsigned long)halHeapMinFree());
+            break;
+        case 'T':
+            inputTelemetry.reset();
+            backgroundTelemetry.reset();
+            Serial.println(F("loop telemetry cleared"));
+            break;
+        case 'w':
+            reportStalls();
+            break;
+        case 'W':
+            stallWatchdog.clear();
+            Serial.println(F("stall watchdog cleared"));
+            break;
+        case 'e': {
+            const eventBusStats_t& e = eventBus.stats();
+            Serial.printf("event bus: pool %u of %d in use (max %u), lanes input %u (max %u) background %u (max %u)"
+                          " to input %u (max %u)\r\n",
+                          eventBus.poolInUse(), EVENT_POOL_SIZE, e.poolHighWater, eventBus.laneDepth(EVENT_LANE_INPUT),
+                          e.laneHighWater[EVENT_LANE_INPUT], eventBus.laneDepth(EVENT_LANE_BACKGROUND),
+                          e.laneHighWater[EVENT_LANE_BACKGROUND], eventBus.laneDepth(EVENT_LANE_TO_INPUT),
+                          e.laneHighWater[EVENT_LANE_TO_INPUT]);
+            Serial.printf("  up to %u events per pass (limit %d), %lu passes left events for the next\r\n", e.maxBatch,
+                          EVENT_DISPATCH_MAX_PER_PASS, (unsigned long)e.deferred);
+            for (int type = 0; type < EVENT_TYPE_COUNT; type++) {
+                const eventTypeStats_t& t = e.type[type];
+                unsigned long mean = t.dispatched ? (unsigned long)(t.total_cycles / t.dispatched) : 0;
+                Serial.printf("  %-10s %7lu published %7lu dispatched %5lu dropped  mean %6lu  max %7lu cycles\r\n",
+                              EventBus::typeName((eventType_t)type), (unsigned long)t.published,
+                              (unsigned long)t.dispatched, (unsigned long)t.dropped, mean, (unsigned long)t.max_cycles);
+            }
+            break;
+        }
+        case 'E':
+            eventBus.resetStats();
+            Serial.println(F("event bus counters cleared"));
+            break;
+        case 'r':
+            if (traceDumpLength == 0) {
+                startTraceDump(takeTraceSnapshot());
+            }
+            break;
+        case 'R':
+            if (traceDumpLength == 0) {
+                int length = takeTraceSnapshot();  // flash write blocks this task for some ms; input task unaffected
+                bool saved = halStoreBlob(TRACE_BLOB_KEY, traceSnapshot, length);
+                LOG_INFO("Trace %s flash (%d bytes, %lu records so far)", saved ? "saved to" : "NOT saved to", length,
+                         (unsigned long)traceRecorder.records());
+            }
+            break;
+        case 'f':
+            if (traceDumpLength == 0) {
+                int length = halLoadBlob(TRACE_BLOB_KEY, traceSnapshot, sizeof(traceSnapshot));
+                if (length > 0) {
+                    startTraceDump(length);
+                } else {
+                    LOG_INFO("No trace saved in flash");
+                }
+            }
+            break;
+#if FLIPTURN_LATENCY_PROBE
+        case 'l':
+            printLatencySummary(Serial);
+            break;
+        case 'L':
+            latencyProbe.reset();
+            Serial.println(F("latency histograms cleared"));
+            break;
 #endif
-        flipStateHasRun = 1;  // toggle flag to run connection notification only once
+        default:
+            break;
+    }
+}
+
+/*****************************************************************************
+Description : Moves the battery saver level with the reported charge and, on a
+                change, logs the exit / entry and applies the new level's profile
+                (SAVER_PROFILES).  The CPU clock and power timing belong to the
+                input task, which gets the level as an EVENT_SAVER_LEVEL.
+
+Input Value : -
+Return Value: -
+********************************************************************************/
+void manageBatterySaver() {
+    if (!batterySaver.update(halMillis(), socEstimator.percent())) {
+        return;
+    }
+    const saverProfile_t& p = SAVER_PROFILES[batterySaver.level()];
+    LOG_INFO("Battery saver: exit %s", SAVER_PROFILES[batterySaver.previous()].name);
+    LOG_INFO("Battery saver: enter %s at %u%% (boost %d MHz, LED %u%%)", p.name, socEstimator.percent(),
+             p.boostMhz, p.ledBrightness_percent);
+
+    applySaverBackground(p, batteryMonitor, connPolicy);
+}
+
+// background side publisher: saver level for the input task (retried next pass if the bus is full)
+void publishSaverLevel() {
+    static saverLevel_t published = SAVER_NORMAL;
+    if (batterySaver.level() != published) {
+        saverEvent_t saver = {(uint8_t)batterySaver.level()};
+        if (eventBus.publish(EVENT_LANE_TO_INPUT, halMillis(), saver)) {
+            published = batterySaver.level();
+        }
+    }
+}
+
+// input task side publisher: power mode for the background task's period (retried next pass if the bus is full)
+void publishPowerMode() {
+    static powerMode_t published = POWER_BOOST;
+    if (powerPolicy.mode() != published) {
+        powerModeEvent_t power = {(uint8_t)powerPolicy.mode()};
+        if (eventBus.publish(EVENT_LANE_INPUT, halMillis(), power)) {
+            published = powerPolicy.mode();
+        }
+    }
+}
+
+/*****************************************************************************
+Description : Applies the connection parameter policy and logs every requested
+                and negotiated parameter change with its timestamp
+
+Input Value : -
+Return Value: -
+********************************************************************************/
+void manageConnectionParams() {
+    connProfile_t profile = connPolicy.update(halMillis(), halKeyboardIsConnected());
+
+    if (profile != CONN_PROFILE_NONE) {
+        const connParams_t& p = ConnectionPolicy::params(profile);
+        bool accepted = halBleUpdateConnParams(p.minInterval, p.maxInterval, p.latency, p.timeout);
+        connPolicy.applied(profile, accepted, halMillis());
+        LOG_INFO("BLE conn params request %s: interval %u-%u x1.25ms, latency %u",
+                 ConnectionPolicy::name(profile), p.minInterval, p.maxInterval, p.latency);
+        if (!accepted) {
+            LOG_WARN("BLE conn params request rejected by stack");
+        }
+    }
+
+    halConnParamsReport_t report;
+    if (halBleTakeConnParamsReport(report)) {
+        LOG_INFO("BLE conn params negotiated at %lu ms: interval %u x1.25ms, latency %u, timeout %u x10ms",
+                 report.time_msec, report.interval, report.latency, report.timeout);
+        if (!report.ok) {
+            LOG_WARN("BLE conn params update failed");
+        }
+    }
+}
+
+/*****************************************************************************
+Description : Steps the advertising schedule while disconnected (time to
+                connect is logged by onConnectionChange())
+
+Input Value : -
+Return Value: -
+********************************************************************************/
+void manageAdvertising() {
+    static const char* const phaseName[] = {"NONE", "DIRECTED", "FAST", "SLOW"};
+
+    advPhase_t phase = advSchedule.update(halMillis(), halKeyboardIsConnected());
+    if (phase != ADV_PHASE_NONE) {
+        const advParams_t& p = AdvertisingSchedule::params(phase);
+        bool accepted = halBleAdvertise(p.directed, p.minInterval, p.maxInterval);
+        LOG_INFO("BLE advertising %s, interval %u x0.625ms", phaseName[phase], p.maxInterval);
+        if (!accepted) {
+            LOG_WARN("BLE advertising request rejected by stack");
+        }
+    }
+}
+
+/*****************************************************************************
+Description : (Re)starts the auto-off timer from the last page turn; shorter
+                when no central is connected.  Called on every gesture and BLE
+                link change.
+
+Input Value : -
+Return Value: -
+********************************************************************************/
+void armAutoOff() {
+    if (!autoOffAvailable) {
+        return;
+    }
+    uint32_t limit_msec = halKeyboardIsConnected() ? AUTO_OFF_CONNECTED_MSEC : AUTO_OFF_DISCONNECTED_MSEC;
+    eventBus.startTimer(TIMER_AUTO_OFF, lastActivity_msec + limit_msec);
+}
+
+/*****************************************************************************
+Description : Enters deep sleep once the auto-off timer expires.  Battery
+                estimate and gesture settings are kept in RTC memory so the
+                wake-up press resumes without the cold-boot path.
+
+Input Value : now_msec - timer expiry
+Return Value: -
+********************************************************************************/
+void enterAutoOff(unsigned long now_msec) {
+    resumeState_t state = {};
+    state.battery_mV = (uint16_t)batteryMonitor.millivolts();
+    state.batteryPercent = socEstimator.percent();
+    state.lowLatencyTaps = button.isLowLatencyMode();
+    state.sleepCount = autoOffCount + 1;
+    resumeStateSave(state);
+
+    LOG_INFO("Auto-off after %lu ms inactivity; press foot switch to wake", now_msec - lastActivity_msec);
+    rgbLed.setRgbColour(rgbLed.led_off);
+    logger.flush();
+    halDeepSleepWakeOnPin(PEDALS[0].pin);
+}
+
+/******************************************************
+// Event handlers: background task, from eventBus.dispatch(); subscribed in setup()
+//   (except onSaverLevel: input task)
+******************************************************/
+
+// gesture: activity for the connection parameter policy and auto-off
+static void onGestureActivity(const busEvent_t& event) {
+    lastActivity_msec = event.time_msec;
+    connPolicy.onActivity(event.time_msec);  // takes effect from the next page turn
+    armAutoOff();
+}
+
+// gesture: a long press shows the battery colour
+static void onGestureShowBattery(const busEvent_t& event) {
+    if (event.gesture.type == LONG_PRESS) {
+        requestState(battery_status);
+    }
+}
+
+// battery sample: % to the central, and into the trace when it has moved by a step
+static void onBatterySample(const busEvent_t& event) {
+    static uint32_t traced_mV = 0;
+    uint32_t battery_mV = event.battery.battery_mV;
+    updateBatteryLevel(battery_mV);
+    if ((battery_mV > traced_mV + TRACE_BATTERY_STEP_MV) || (battery_mV + TRACE_BATTERY_STEP_MV < traced_mV)) {
+        traced_mV = battery_mV;
+        TRACE_RECORD(TRACE_BATTERY, halMicros(), battery_mV);
+    }
+}
+
+// BLE link change: trace, time from reset (or the last disconnect) to connected, auto-off limit
+static void onConnectionChange(const busEvent_t& event) {
+    TRACE_RECORD(TRACE_LINK, halMicros(), event.connection.connected);
+    if (!event.connection.connected) {
+        disconnected_msec = event.time_msec;
+        LOG_INFO("BLE disconnected");
+    } else if (disconnected_msec == 0) {
+        markBootPhase(BOOT_CONNECTED);
+    } else {
+        LOG_INFO("BLE reconnected %lu ms after disconnect", event.time_msec - disconnected_msec);
+    }
+    armAutoOff();
+}
+
+static void onTimer(const busEvent_t& event) {
+    if (event.timer.timer == TIMER_AUTO_OFF) {
+        enterAutoOff(event.time_msec);
+    }
+}
+
+// power mode: background period follows the input task's mode
+static void onPowerMode(const busEvent_t& event) {
+    backgroundPowerMode = (powerMode_t)event.power.mode;
+}
+
+// saver level (input task): boost clock + power mode timing
+static void onSaverLevel(const busEvent_t& event) {
+    applySaverInput(SAVER_PROFILES[event.saver.level], powerPolicy);
+}
+
+// background side publisher: BLE link changes (retried next pass if the bus is full)
+void publishLinkChange() {
+    static bool published = false;
+    bool connected = halKeyboardIsConnected();
+    if (connected != published) {
+        connectionEvent_t link = {connected};
+        if (eventBus.publish(EVENT_LANE_BACKGROUND, halMillis(), link)) {
+            published = connected;
+        }
+    }
+}
+
+/*****************************************************************************
+Description : Queues the HID key(s) for a classified press.  Runs in the input
+                task; anything the background needs to know is published as a
+                gesture event.
+
+Input Value : -
+Return Value: -
+********************************************************************************/
+void dispatchGesture() {
+    LATENCY_MARK(STAGE_DISPATCH);
+    unsigned long now_msec = halMillis();
+    bool connected = halKeyboardIsConnected();
+
+    const pedalConfig_t& pedal = PEDALS[button.pedal()];
+
+    if (button.triggered(SHORT_PRESS)) {
+        hidQueue.push(pedal.tapKey, now_msec, connected);
+        LOG_INFO("Pedal %d Single Tap = key %d", button.pedal(), pedal.tapKey);
+    }
+
+    else if (button.triggered(DOUBLE_PRESS)) {
+        hidQueue.push(pedal.doubleKey, now_msec, connected);
+        LOG_INFO("Pedal %d Double Tap = key %d", button.pedal(), pedal.doubleKey);
+    }
+
+    else if (button.triggered(DOUBLE_PRESS_AFTER_SHORT)) {
+        // low latency mode: first tap already sent, so undo it before the double tap key
+        //   (if that tap is still queued the arrows coalesce, eg down + up + up = a single up)
+        if (pedal.tapKey == HAL_KEY_DOWN_ARROW || pedal.tapKey == HAL_KEY_UP_ARROW) {
+            hidQueue.push(pedal.tapKey == HAL_KEY_DOWN_ARROW ? HAL_KEY_UP_ARROW : HAL_KEY_DOWN_ARROW, now_msec, connected);
+        }
+        hidQueue.push(pedal.doubleKey, now_msec, connected);
+        LOG_INFO("Pedal %d Double Tap (after speculative tap) = undo + key %d", button.pedal(), pedal.doubleKey);
+    }
+
+    else if (button.triggered(LONG_PRESS) && pedal.holdRepeat) {
+        hidPipeline.startRepeat(pedal.tapKey, now_msec);  // until the pedal is released (sendQueuedKeys)
+        repeatPedal = button.pedal();
+        LOG_INFO("Pedal %d Hold = repeat key %d", button.pedal(), pedal.tapKey);
     }
 
-    processState();
+    else if (button.triggered(LONG_PRESS)) {
+        hidQueue.push(pedal.holdKey, now_msec, connected);  // eject toggles visibility of IOS virtual on-screen keyboard
+        LOG_INFO("Pedal %d Long Press = key %d / show Battery Status Colour", button.pedal(), pedal.holdKey);
+    }
+
+    else if (button.triggered(CHORD_PRESS)) {
+        hidQueue.push(CHORDS[button.chord()].key, now_msec, connected);
+        LOG_INFO("Chord %d = key %d", button.chord(), CHORDS[button.chord()].key);
+    }
+
+    if (!connected) {
+        LOG_WARN("BLE not connected; press queued for replay (%u queued)", hidQueue.depth());
+    }
+
+    gestureEvent_t gesture = {button.type(), (uint8_t)button.pedal(), (uint8_t)button.chord()};
+    if (!eventBus.publish(EVENT_LANE_INPUT, now_msec, gesture)) {  // background: battery status colour + BLE activity
+        LOG_WARN("Event bus full; gesture event dropped (%lu so far)",
+                 (unsigned long)eventBus.stats().type[EVENT_GESTURE].dropped);
+    }
+}
+
+/*****************************************************************************
+Description : Sends queued keys as press / release reports for as long as the
+                pipeline has room (completion window and stack buffers), and
+                ends hold-to-scroll once its pedal is released
+
+Input Value : -
+Return Value: -
+********************************************************************************/
+void sendQueuedKeys() {
+    if ((repeatPedal >= 0) && !(button.bank().pressedMask() & (1 << repeatPedal))) {
+        hidPipeline.stopRepeat();
+        repeatPedal = -1;
+    }
+    hidPipeline.completed(halBleTakeCompletions(), halMicros());
 
-    // monitor switch button with response depending on designated pressTypes (Single Press, Double Press, Hold Press)
-    if (button.update()) {
-        // true = when a switch (button press) event triggered
+    // on link drop any unsent release is lost: clear the keyboard's report state, or the key
+    //   would still be down in the first report after reconnect
+    static bool linkUp = false;
+    bool connected = halKeyboardIsConnected();
+    if (linkUp && !connected) {
+        halKeyboardReleaseAll();
+    }
+    linkUp = connected;
 
-        if (button.triggered(SINGLE_TAP)) {
-            bleKeyboard.write(KEY_DOWN_ARROW);
-            Serial.println("Single Tap = Down Arrow");
+    hidReport_t report;
+    while (hidPipeline.next(halMillis(), halMicros(), connected, halBleSendCredits(), report)) {
+        bool accepted = halKeyboardSendReport(report.key, report.pressed);
+        hidPipeline.sent(accepted, halMicros());
+        if (!accepted) {
+            break;  // stack buffers full after all; offered again next pass
+        }
+        if (report.pressed) {
+            TRACE_RECORD(TRACE_HID, halMicros(), report.key);
+            LATENCY_MARK(STAGE_HID_DONE);  // first key after a dispatch closes the latency sample
+            markBootPhase(BOOT_FIRST_KEYSTROKE);
         }
+    }
+}
 
-        else if (button.triggered(DOUBLE_TAP)) {
-            bleKeyboard.write(KEY_UP_ARROW);
-            Serial.println("Double Tap = Up Arrow");
+/*****************************************************************************
+Description : High priority input task (core 1).  Sleeps until the switch ISR
+                notifies it, or a hold / double tap timer needs checking, then
+                classifies presses and sends queued HID reports.  Nothing else runs here, so
+                page turns never queue behind ADC, LED or serial work.
+********************************************************************************/
+void inputTask(void* parameter) {
+    (void)parameter;
+    TickType_t wait = 0;  // first pass straight away
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, wait);
+        TELEMETRY_CYCLE_BEGIN(inputTelemetry);
+        STALL_PASS_BEGIN(inputWatch);
+
+        while (button.update()) {  // true = when a switch (button press) event triggered
+            dispatchGesture();
         }
+        TELEMETRY_STAGE(inputTelemetry, INPUT_STAGE_GESTURES);
+        STALL_STAGE(inputWatch, INPUT_STAGE_GESTURES);
+
+        sendQueuedKeys();
+        TELEMETRY_STAGE(inputTelemetry, INPUT_STAGE_HID);
+        STALL_STAGE(inputWatch, INPUT_STAGE_HID);
 
-        else if (button.triggered(HOLD)) {
-            bleKeyboard.write(KEY_MEDIA_EJECT);  // toggles visibility of IOS virtual on-screen keyboard
-            ledTimer_msec = millis();            //! update times; trying to debug flipState
-            flipState = battery_status;
+        // tick rate polling only while a gesture timer is pending, queued keys can go out or reports are in flight
+        bool busy = !button.isIdle() || (!hidQueue.isEmpty() && halKeyboardIsConnected()) || hidPipeline.isBusy();
 
-            Serial.println("Long Press = Eject / show Battery Status Colour");
+        eventBus.dispatch(EVENT_LANES_INPUT_TASK, EVENT_DISPATCH_MAX_PER_PASS);  // saver level, before this pass's power decision
+        if (powerPolicy.update(halMillis(), busy)) {
+            powerMode_t mode = powerPolicy.mode();
+            halPowerSetMode(mode == POWER_BOOST, mode == POWER_SLEEP);
         }
+        publishPowerMode();
+        TELEMETRY_STAGE(inputTelemetry, INPUT_STAGE_POWER);
+        STALL_STAGE(inputWatch, INPUT_STAGE_POWER);
+
+        uint32_t idleWait_msec = (powerPolicy.mode() == POWER_SLEEP) ? POWER_SLEEP_POLL_MSEC : INPUT_IDLE_POLL_MSEC;
+        wait = busy ? 1 : pdMS_TO_TICKS(idleWait_msec);
+        TELEMETRY_CYCLE_END(inputTelemetry);
+        STALL_PASS_END(inputWatch, (busy ? portTICK_PERIOD_MS : idleWait_msec) * 1000UL);
     }
+}
+
+/*****************************************************************************
+Description : Low priority background task (core 0): dispatches the event bus
+                (press events from the input task, battery samples, BLE link
+                changes, timers), then battery saver, LED state machine, BLE
+                connection parameters, serial commands and log output
+********************************************************************************/
+void backgroundTask(void* parameter) {
+    (void)parameter;
+    TickType_t lastWake = xTaskGetTickCount();
+
+    if (LED_SELF_TEST) {
+        rgbLed.functionTest(SELF_TEST_STEP_MSEC);
+    }
+
+    for (;;) {
+        TELEMETRY_CYCLE_BEGIN(backgroundTelemetry);
+        STALL_PASS_BEGIN(backgroundWatch);
+
+        // LED self-test (if enabled) owns the LED until done; everything else keeps running
+        bool selfTest = rgbLed.functionTestRunning();
+
+        if (!selfTest) {
+            markBootPhase(BOOT_SELF_TEST_DONE);
+        }
+
+        // gestures from the input task, link changes, timers; bounded so a burst can't stretch the pass
+        publishLinkChange();
+        eventBus.pollTimers(EVENT_LANE_BACKGROUND, halMillis());
+        eventBus.dispatch(EVENT_LANES_BACKGROUND_TASK, EVENT_DISPATCH_MAX_PER_PASS);
+        TELEMETRY_STAGE(backgroundTelemetry, BACKGROUND_STAGE_EVENTS);
+        STALL_STAGE(backgroundWatch, BACKGROUND_STAGE_EVENTS);
+
+        if (batteryMonitor.update(halMillis())) {  // cheap unless a sample is due
+            batteryEvent_t sample = {(uint16_t)batteryMonitor.millivolts()};
+            eventBus.publish(EVENT_LANE_BACKGROUND, halMillis(), sample);  // handled next pass
+        }
+        manageBatterySaver();
+        publishSaverLevel();
+        TELEMETRY_STAGE(backgroundTelemetry, BACKGROUND_STAGE_BATTERY);
+        STALL_STAGE(backgroundWatch, BACKGROUND_STAGE_BATTERY);
+
+        if (!selfTest) {
+            processState();  // LED state machine + non-blocking auto shut-down
+        }
+        TELEMETRY_STAGE(backgroundTelemetry, BACKGROUND_STAGE_STATE);
+        STALL_STAGE(backgroundWatch, BACKGROUND_STAGE_STATE);
+
+        manageAdvertising();
+        manageConnectionParams();
+        TELEMETRY_STAGE(backgroundTelemetry, BACKGROUND_STAGE_BLE);
+        STALL_STAGE(backgroundWatch, BACKGROUND_STAGE_BLE);
+
+        processSerialCommand();
+        TELEMETRY_STAGE(backgroundTelemetry, BACKGROUND_STAGE_SERIAL);
+        STALL_STAGE(backgroundWatch, BACKGROUND_STAGE_SERIAL);
+
+        // format + print queued log records only as fast as the UART can take them (trace dump first)
+        if (!traceDumpStep()) {
+            logger.drain();
+        }
+        TELEMETRY_STAGE(backgroundTelemetry, BACKGROUND_STAGE_LOG);
+        STALL_STAGE(backgroundWatch, BACKGROUND_STAGE_LOG);
+        TELEMETRY_CYCLE_END(backgroundTelemetry);
+
+        // longer period while light sleep is allowed, so the idle task can actually sleep
+        uint32_t period_msec = (backgroundPowerMode == POWER_SLEEP) ? BACKGROUND_SLEEP_PERIOD_MSEC : BACKGROUND_TASK_PERIOD_MSEC;
+        STALL_PASS_END(backgroundWatch, period_msec * 1000UL);
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(period_msec));
+    }
+}
+
+// switch ISR hook: wake the input task now rather than at its next poll
+static void IRAM_ATTR wakeInputTask() {
+    if (inputTaskHandle != nullptr) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(inputTaskHandle, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+// FreeRTOS tick hook (ISR, both cores): catches a stall while it is happening
+static void IRAM_ATTR stallTick() {
+    stallWatchdog.poll(halCoreId(), halMicros());
+}
+
+void setup() {
+    // no start-up delay: log records are timestamped and queued, then drained by the background task
+    Serial.begin(SERIAL_MONITOR_SPEED);
+    markBootPhase(BOOT_SETUP);
+
+    // woken from auto-off by the foot switch?  retained state is one-shot: a later reset cold boots
+    resumeState_t resume;
+    bool resumed = halWokeFromDeepSleep() && resumeStateLoad(resume);
+    resumeStateClear();
+
+    // BLE first: advertising (and a bonded central reconnecting) overlaps everything below
+    halKeyboardBegin();
+    advSchedule.setBondedHost(halBleBondedHostKnown());
+    markBootPhase(BOOT_ADVERTISING);
+
+    LOG_INFO("Board profile: %s", Board::name());
+    LOG_INFO("Preparing flipTurn for BLE connection%s", halBleBondedHostKnown() ? " (bonded host cached)" : "");
+
+    rgbLed.begin();  // attach LED pins to LEDC pwm channels
+
+    // characterise ADC once and prime battery filter before first battery status is shown
+    adcBatteryBegin<Board>();
+    if (resumed) {
+        // skip ADC priming and the power-up battery status display; straight to reconnecting
+        batteryMonitor.resume(halMillis(), resume.battery_mV);
+        socEstimator.resume(resume.batteryPercent);
+        halKeyboardSetBatteryLevel(resume.batteryPercent);
+        button.setLowLatencyMode(resume.lowLatencyTaps);
+        autoOffCount = resume.sleepCount;
+        LOG_INFO("Woke from auto-off #%lu; resuming", (unsigned long)autoOffCount);
+    } else {
+        batteryMonitor.begin(halMillis(), BATTERY_PRIME_ROUNDS);
+        updateBatteryLevel(batteryMonitor.millivolts());  // initial battery % (read by central on connect)
+        requestState(battery_status);  // power-up battery colour, shown once the LED self-test is done
+    }
+
+    // initialise button (eg foot switch); see press_type set-up code
+    button.onEdgeCaptured(wakeInputTask);
+    button.begin();
+
+    if (!halPowerBegin(CPU_BOOST_MHZ, CPU_ECO_MHZ, PEDALS[0].pin)) {
+        LOG_WARN("Power management not available in this build; CPU stays at full clock");
+    }
+    autoOffAvailable = halCanWakeOnPin(PEDALS[0].pin);
+    if (!autoOffAvailable) {
+        LOG_WARN("Foot switch pin %d is not an RTC GPIO; auto-off disabled", PEDALS[0].pin);
+    }
+    markBootPhase(BOOT_HARDWARE_READY);
+
+    // stall watchdog: tasks register before they start; a worst stall from before a reset is kept
+    inputWatch = stallWatchdog.addSubsystem("input task", inputStageName, INPUT_STAGE_COUNT, INPUT_TASK_CORE,
+                                            STALL_INPUT_BUDGET_USEC, STALL_INPUT_SLACK_USEC);
+    backgroundWatch = stallWatchdog.addSubsystem("background task", backgroundStageName, BACKGROUND_STAGE_COUNT,
+                                                 BACKGROUND_TASK_CORE, STALL_BACKGROUND_BUDGET_USEC, STALL_BACKGROUND_SLACK_USEC);
+    if (stallWatchdog.begin()) {
+        LOG_WARN("Stall record kept from before reset; 'w' to show");
+    }
+    if (FLIPTURN_STALL_WATCHDOG && !halAttachTickHook(stallTick)) {
+        LOG_WARN("Tick hook not available; stalls only seen when the pass ends");
+    }
+
+    // event bus: handlers run on the background task (saver level: input task); first battery sample
+    //   traced on its first pass
+    eventBus.subscribe(EVENT_GESTURE, onGestureActivity);
+    eventBus.subscribe(EVENT_GESTURE, onGestureShowBattery);
+    eventBus.subscribe(EVENT_BATTERY, onBatterySample);
+    eventBus.subscribe(EVENT_CONNECTION, onConnectionChange);
+    eventBus.subscribe(EVENT_TIMER, onTimer);
+    eventBus.subscribe(EVENT_POWER_MODE, onPowerMode);
+    eventBus.subscribe(EVENT_SAVER_LEVEL, onSaverLevel);
+    batteryEvent_t sample = {(uint16_t)batteryMonitor.millivolts()};
+    eventBus.publish(EVENT_LANE_BACKGROUND, halMillis(), sample);
+    armAutoOff();
+
+    xTaskCreatePinnedToCore(inputTask, "input", TASK_STACK_BYTES, nullptr,
+                            INPUT_TASK_PRIORITY, &inputTaskHandle, INPUT_TASK_CORE);
+    xTaskCreatePinnedToCore(backgroundTask, "background", TASK_STACK_BYTES, nullptr,
+                            BACKGROUND_TASK_PRIORITY, &backgroundTaskHandle, BACKGROUND_TASK_CORE);
+    markBootPhase(BOOT_TASKS_RUNNING);
+
+}  // end setup
+
+void loop() {
+    // all work runs in inputTask / backgroundTask; Arduino loopTask is not needed
+    vTaskDelete(nullptr);
 
 }  // end loop()
@@ -0,0 +1,184 @@
+/*
+ * *************************************************************
+ * flipTurn-native.cpp - [env:native] runner: the firmware's setup() / loop()
+ *   and FreeRTOS tasks on the native HAL, driven by a script or the gig
+ *   battery life benchmark
+ *
+ *   Arduino's loopTask is modelled too: setup() then loop() run in a task of
+ *   their own, as on the ESP32.  The script gives timed inputs; the runner
+ *   prints what the firmware did - HID reports and LED colours, timestamped
+ *   on the virtual clock - alongside the firmware's own serial output.
+ *
+ *   Script, one event per line (from a file, or stdin if none given):
+ *     <msec> pedal <n> down|up    foot switch edge on PEDALS[n]
+ *     <msec> connect | disconnect BLE central
+ *     <msec> battery <mV>         pack voltage (fake ADC, divider applied)
+ *     <msec> serial <text>        characters for the serial command handler
+ *     <msec> end                  stop (otherwise at the last event)
+ *   '#' starts a comment.  The link starts disconnected at 4000 mV.
+ *
+ *   -p plays the scripted gig of lib/powerModel instead and reports where
+ *   the battery goes: -m loads measured current figures (currentModel.h),
+ *   -s seeds the page turn timing, -w saves the result as a baseline and -r
+ *   compares against one (test/test_powerModel/baseline.txt is the committed
+ *   tree's; test_powerModel checks it on every pio test -e native).
+ *
+ *   Usage:  pio run -e native && .pio/build/native/program [script]
+ *           .pio/build/native/program -p [-m current model] [-s seed] [-r baseline] [-w baseline]
+ *   Exit:   0 ok, 1 firmware went into deep sleep or stopped (-p: or battery
+ *           life dropped by more than the baseline's tolerance), 2 bad arguments
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#if !defined(ARDUINO) && !defined(PIO_UNIT_TESTING)  // unit tests link the firmware, with main() of their own
+
+#include <Arduino.h>
+
+#include "batteryMonitor.h"  // fakeAdcSet_mV()
+#include "hal.h"
+#include "myConstants.h"
+#include "powerModel.h"
+
+constexpr uint32_t START_BATTERY_MV = 4000;
+static const char* const keyName[] = {"down", "up", "eject"};
+static const int ledPin[3] = {Board::RED_LED_PIN, Board::GREEN_LED_PIN, Board::BLUE_LED_PIN};
+
+static int reported = 0;  // HID reports already printed
+static int shownLed[3] = {-1, -1, -1};
+
+static void printTime(uint64_t time_usec) {
+    printf("[%8lu.%03lu ms] ", (unsigned long)(time_usec / 1000), (unsigned long)(time_usec % 1000));
+}
+
+// after each task step: anything new the firmware did
+static void reportOutputs() {
+    for (; reported < simHidReportCount(); reported++) {
+        const simHidReport_t& report = simHidReport(reported);
+        printTime(report.time_usec);  // 32 bit, like micros()
+        printf("HID %s\n", keyName[report.key]);
+    }
+    int led[3];
+    for (int c = 0; c < 3; c++) {
+        led[c] = simLedValue(ledPin[c]);
+    }
+    if (memcmp(led, shownLed, sizeof(led)) != 0) {
+        memcpy(shownLed, led, sizeof(led));
+        printTime(simNow_usec());
+        printf("LED r %d g %d b %d\n", led[0], led[1], led[2]);
+    }
+}
+
+// one script line; false if it can't be parsed
+static bool applyEvent(const char* command, const char* args, bool& end) {
+    int pedal;
+    char edge[8];
+    unsigned long battery_mV;
+    if ((strcmp(command, "pedal") == 0) && (sscanf(args, "%d %7s", &pedal, edge) == 2) && (pedal >= 0) &&
+        (pedal < PEDAL_COUNT) && ((strcmp(edge, "down") == 0) || (strcmp(edge, "up") == 0))) {
+        simSetPin(PEDALS[pedal].pin, strcmp(edge, "up") == 0);  // pressed = LOW
+    } else if (strcmp(command, "connect") == 0) {
+        simSetConnected(true);
+    } else if (strcmp(command, "disconnect") == 0) {
+        simSetConnected(false);
+    } else if ((strcmp(command, "battery") == 0) && (sscanf(args, "%lu", &battery_mV) == 1)) {
+        fakeAdcSet_mV(battery_mV / Board::BATTERY_DIVIDER_RATIO);
+    } else if (strcmp(command, "serial") == 0) {
+        hostSerialInput(args);
+    } else if (strcmp(command, "end") == 0) {
+        end = true;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// -p: gig battery life benchmark; exit code as main()
+static int runPowerModel(int argc, char** argv) {
+    currentModel_t model = DEFAULT_CURRENT_MODEL;
+    uint32_t seed = 1;
+    const char* comparePath = nullptr;
+    const char* writePath = nullptr;
+    for (int i = 2; i < argc; i++) {
+        if ((strcmp(argv[i], "-m") == 0) && (i + 1 < argc)) {
+            if (!loadCurrentModel(argv[++i], model)) {
+                return 2;
+            }
+        } else if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc)) {
+            seed = (uint32_t)strtoul(argv[++i], nullptr, 0);
+        } else if ((strcmp(argv[i], "-r") == 0) && (i + 1 < argc)) {
+            comparePath = argv[++i];
+        } else if ((strcmp(argv[i], "-w") == 0) && (i + 1 < argc)) {
+            writePath = argv[++i];
+        } else {
+            fprintf(stderr, "usage: program -p [-m current model] [-s seed] [-r baseline] [-w baseline]\n");
+            return 2;
+        }
+    }
+
+    gigResult_t result;
+    bool completed = runGig(model, seed, result);
+    printGigReport(model, result);
+    if ((writePath != nullptr) && !writePowerBaseline(writePath, result)) {
+        fprintf(stderr, "%s: cannot write baseline\n", writePath);
+        return 2;
+    }
+    int verdict = (comparePath != nullptr) ? comparePowerBaseline(comparePath, result) : 0;
+    return ((verdict == 0) && !completed) ? 1 : verdict;
+}
+
+int main(int argc, char** argv) {
+    if ((argc > 1) && (strcmp(argv[1], "-p") == 0)) {
+        return runPowerModel(argc, argv);
+    }
+    FILE* script = (argc > 1) ? fopen(argv[1], "r") : stdin;
+    if ((argc > 2) || (script == nullptr)) {
+        fprintf(stderr, "usage: program [script] | program -p [options]\n");
+        return 2;
+    }
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+
+    simReset();
+    fakeAdcSet_mV(START_BATTERY_MV / Board::BATTERY_DIVIDER_RATIO);
+    hostSetStepHook(reportOutputs);
+    hostStartArduino();
+
+    char line[160];
+    int lineNumber = 0;
+    bool end = false;
+    bool running = true;
+    while (running && !end && (fgets(line, sizeof(line), script) != nullptr)) {
+        lineNumber++;
+        char* comment = strchr(line, '#');
+        if (comment != nullptr) {
+            *comment = 0;
+        }
+        line[strcspn(line, "\r\n")] = 0;
+        unsigned long time_msec;
+        char command[16];
+        int used = 0;
+        if (sscanf(line, " %lu %15s %n", &time_msec, command, &used) < 2) {
+            if (strspn(line, " \t") == strlen(line)) {
+                continue;  // blank
+            }
+            fprintf(stderr, "line %d: expected <msec> <event>\n", lineNumber);
+            return 2;
+        }
+        running = hostRunUntil((uint64_t)time_msec * 1000) && !simInDeepSleep();
+        if (running && !applyEvent(command, line + used, end)) {
+            fprintf(stderr, "line %d: unknown event '%s'\n", lineNumber, line);
+            return 2;
+        }
+    }
+    running = running && hostRunUntil(simNow_usec()) && !simInDeepSleep();  // let the last event take effect
+
+    if (simInDeepSleep()) {
+        printTime(simNow_usec());
+        printf("deep sleep\n");
+    }
+    return running ? 0 : 1;
+}
+
+#endif  // !ARDUINO && !PIO_UNIT_TESTING
@@ -0,0 +1,138 @@
+/*
+ * *************************************************************
+ * test_main.cpp - unit tests for GestureClassifier (lib/press_type)
+ *
+ *   Edges and ticks are fed with explicit timestamps, so each test sits
+ *   exactly on, or one microsecond either side of, the configured debounce,
+ *   double tap and hold thresholds in myConstants.h.
+ *
+ *   Run:  pio test -e native -f test_gestureClassifier
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include <unity.h>
+
+#include "gestureClassifier.h"
+#include "myConstants.h"
+
+constexpr uint32_t DEBOUNCE_USEC = SWITCH_DEBOUNCE_MSEC * 1000;
+constexpr uint32_t DOUBLE_TAP_USEC = DOUBLE_TAP_WINDOW_MSEC * 1000;
+constexpr uint32_t HOLD_USEC = HOLD_DURATION_MSEC * 1000;
+constexpr uint32_t START_USEC = 1000000;  // clear of the classifier's initial last-edge time of 0
+constexpr uint32_t TAP_USEC = 80000;      // a typical foot tap
+
+static GestureClassifier classifier(DEBOUNCE_USEC, DOUBLE_TAP_USEC, HOLD_USEC);
+
+static pressType_T edge(uint32_t time_usec, bool pressed) {
+    switchEdge_t e = {time_usec, pressed};
+    return classifier.onEdge(e);
+}
+
+void setUp() {
+    classifier = GestureClassifier(DEBOUNCE_USEC, DOUBLE_TAP_USEC, HOLD_USEC);  // fresh edge history each test
+}
+
+void tearDown() {
+}
+
+void test_single_tap_reported_when_double_tap_window_closes() {
+    TEST_ASSERT_EQUAL(NO_PRESS, edge(START_USEC, true));
+    uint32_t release_usec = START_USEC + TAP_USEC;
+    TEST_ASSERT_EQUAL(NO_PRESS, edge(release_usec, false));
+    TEST_ASSERT_TRUE(classifier.hasPendingTimeout());
+    TEST_ASSERT_EQUAL(NO_PRESS, classifier.onTick(release_usec + DOUBLE_TAP_USEC - 1, false));
+    TEST_ASSERT_EQUAL(SHORT_PRESS, classifier.onTick(release_usec + DOUBLE_TAP_USEC, false));
+    TEST_ASSERT_FALSE(classifier.hasPendingTimeout());
+    TEST_ASSERT_EQUAL(NO_PRESS, classifier.onTick(release_usec + 2 * DOUBLE_TAP_USEC, false));  // reported once
+}
+
+void test_press_released_just_before_hold_threshold_is_a_tap() {
+    edge(START_USEC, true);
+    TEST_ASSERT_EQUAL(NO_PRESS, classifier.onTick(START_USEC + HOLD_USEC - 1, true));
+    uint32_t release_usec = START_USEC + HOLD_USEC - 1;
+    TEST_ASSERT_EQUAL(NO_PRESS, edge(release_usec, false));
+    TEST_ASSERT_EQUAL(SHORT_PRESS, classifier.onTick(release_usec + DOUBLE_TAP_USEC, false));
+}
+
+void test_long_press_reported_at_hold_threshold_while_held() {
+    edge(START_USEC, true);
+    TEST_ASSERT_EQUAL(NO_PRESS, classifier.onTick(START_USEC + HOLD_USEC - 1, true));
+    TEST_ASSERT_EQUAL(LONG_PRESS, classifier.onTick(START_USEC + HOLD_USEC, true));
+    TEST_ASSERT_TRUE(classifier.isPressed());
+
+    uint32_t release_usec = START_USEC + 2 * HOLD_USEC;  // the release ends it: no tap afterwards
+    TEST_ASSERT_EQUAL(NO_PRESS, edge(release_usec, false));
+    TEST_ASSERT_EQUAL(NO_PRESS, classifier.onTick(release_usec + DOUBLE_TAP_USEC, false));
+    TEST_ASSERT_FALSE(classifier.hasPendingTimeout());
+}
+
+void test_second_tap_inside_window_is_double_press() {
+    edge(START_USEC, true);
+    uint32_t release_usec = START_USEC + TAP_USEC;
+    edge(release_usec, false);
+    uint32_t second_usec = release_usec + DOUBLE_TAP_USEC - 1;
+    TEST_ASSERT_EQUAL(NO_PRESS, edge(second_usec, true));
+    TEST_ASSERT_EQUAL(DOUBLE_PRESS, edge(second_usec + TAP_USEC, false));
+    TEST_ASSERT_EQUAL(NO_PRESS, classifier.onTick(second_usec + TAP_USEC + DOUBLE_TAP_USEC, false));
+}
+
+void test_second_tap_at_window_end_is_two_single_taps() {
+    edge(START_USEC, true);
+    uint32_t release_usec = START_USEC + TAP_USEC;
+    edge(release_usec, false);
+    uint32_t second_usec = release_usec + DOUBLE_TAP_USEC;
+    TEST_ASSERT_EQUAL(SHORT_PRESS, edge(second_usec, true));  // window closed before this press
+    uint32_t secondRelease_usec = second_usec + TAP_USEC;
+    TEST_ASSERT_EQUAL(NO_PRESS, edge(secondRelease_usec, false));
+    TEST_ASSERT_EQUAL(SHORT_PRESS, classifier.onTick(secondRelease_usec + DOUBLE_TAP_USEC, false));
+}
+
+void test_contact_bounce_is_ignored() {
+    edge(START_USEC, true);
+    TEST_ASSERT_EQUAL(NO_PRESS, edge(START_USEC + 1000, false));  // bounce inside the debounce time
+    TEST_ASSERT_EQUAL(NO_PRESS, edge(START_USEC + DEBOUNCE_USEC - 1, true));
+    TEST_ASSERT_TRUE(classifier.isPressed());
+
+    uint32_t release_usec = START_USEC + TAP_USEC;
+    edge(release_usec, false);
+    TEST_ASSERT_EQUAL(NO_PRESS, edge(release_usec + 2000, true));  // release bounce, not a second tap
+    TEST_ASSERT_EQUAL(NO_PRESS, edge(release_usec + 3000, false));
+    TEST_ASSERT_FALSE(classifier.isPressed());
+    TEST_ASSERT_EQUAL(SHORT_PRESS, classifier.onTick(release_usec + DOUBLE_TAP_USEC, false));
+}
+
+void test_low_latency_reports_tap_on_release() {
+    classifier.setLowLatency(true);
+    edge(START_USEC, true);
+    uint32_t release_usec = START_USEC + TAP_USEC;
+    TEST_ASSERT_EQUAL(SHORT_PRESS, edge(release_usec, false));
+    TEST_ASSERT_EQUAL(NO_PRESS, classifier.onTick(release_usec + DOUBLE_TAP_USEC, false));  // not sent twice
+}
+
+void test_low_latency_double_tap_follows_its_short_press() {
+    classifier.setLowLatency(true);
+    edge(START_USEC, true);
+    uint32_t release_usec = START_USEC + TAP_USEC;
+    TEST_ASSERT_EQUAL(SHORT_PRESS, edge(release_usec, false));
+    uint32_t second_usec = release_usec + DOUBLE_TAP_USEC / 2;
+    TEST_ASSERT_EQUAL(NO_PRESS, edge(second_usec, true));
+    TEST_ASSERT_EQUAL(DOUBLE_PRESS_AFTER_SHORT, edge(second_usec + TAP_USEC, false));
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_single_tap_reported_when_double_tap_window_closes);
+    RUN_TEST(test_press_released_just_before_hold_threshold_is_a_tap);
+    RUN_TEST(test_long_press_reported_at_hold_threshold_while_held);
+    RUN_TEST(test_second_tap_inside_window_is_double_press);
+    RUN_TEST(test_second_tap_at_window_end_is_two_single_taps);
+    RUN_TEST(test_contact_bounce_is_ignored);
+    RUN_TEST(test_low_latency_reports_tap_on_release);
+    RUN_TEST(test_low_latency_double_tap_follows_its_short_press);
+    return UNITY_END();
+}
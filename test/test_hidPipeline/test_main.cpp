@@ -0,0 +1,162 @@
+/*
+ * *************************************************************
+ * test_main.cpp - unit tests for HidPipeline and HidEventQueue (lib/hidQueue)
+ *
+ *   Press / release ordering, a refused report offered again, and a press
+ *   refused just before the link drops going back in the queue for replay
+ *   rather than being lost.
+ *
+ *   Run:  pio test -e native -f test_hidPipeline
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include <unity.h>
+
+#include "hidPipeline.h"
+#include "hidQueue.h"
+
+constexpr uint32_t MAX_AGE_MSEC = 5000;
+constexpr uint32_t MAX_LATENCY_MSEC = 1000;
+constexpr uint32_t SETTLE_MSEC = 1000;
+constexpr int CREDITS = 8;
+
+HidEventQueue queue(MAX_AGE_MSEC, MAX_LATENCY_MSEC, 0, SETTLE_MSEC);
+HidPipeline* pipeline;
+
+void setUp() {
+    queue = HidEventQueue(MAX_AGE_MSEC, MAX_LATENCY_MSEC, 0, SETTLE_MSEC);
+    pipeline = new HidPipeline(queue, 4, 1000, 125);
+}
+
+void tearDown() {
+    delete pipeline;
+}
+
+// next() at now_msec on a live link
+static bool offer(uint32_t now_msec, hidReport_t& report) {
+    return pipeline->next(now_msec, now_msec * 1000, true, CREDITS, report);
+}
+
+static void disconnect(uint32_t now_msec) {
+    hidReport_t report;
+    TEST_ASSERT_FALSE(pipeline->next(now_msec, now_msec * 1000, false, CREDITS, report));
+}
+
+void test_press_then_release() {
+    hidReport_t report;
+    offer(0, report);  // link comes up: settle starts
+    queue.push(HAL_KEY_DOWN_ARROW, 10, true);
+    TEST_ASSERT_FALSE(offer(10, report));  // still settling
+
+    TEST_ASSERT_TRUE(offer(SETTLE_MSEC, report));
+    TEST_ASSERT_EQUAL(HAL_KEY_DOWN_ARROW, report.key);
+    TEST_ASSERT_TRUE(report.pressed);
+    pipeline->sent(true, SETTLE_MSEC * 1000);
+
+    TEST_ASSERT_TRUE(offer(SETTLE_MSEC, report));
+    TEST_ASSERT_EQUAL(HAL_KEY_DOWN_ARROW, report.key);
+    TEST_ASSERT_FALSE(report.pressed);
+    pipeline->sent(true, SETTLE_MSEC * 1000);
+    TEST_ASSERT_FALSE(offer(SETTLE_MSEC, report));
+    TEST_ASSERT_EQUAL_UINT32(2, pipeline->stats().reports);
+}
+
+void test_refused_press_offered_again() {
+    hidReport_t report;
+    offer(0, report);
+    queue.push(HAL_KEY_MEDIA_EJECT, 10, true);
+    TEST_ASSERT_TRUE(offer(SETTLE_MSEC, report));
+    pipeline->sent(false, SETTLE_MSEC * 1000);
+    TEST_ASSERT_TRUE(queue.isEmpty());  // taken from the queue, held by the pipeline
+
+    TEST_ASSERT_TRUE(offer(SETTLE_MSEC + 1, report));
+    TEST_ASSERT_EQUAL(HAL_KEY_MEDIA_EJECT, report.key);
+    TEST_ASSERT_TRUE(report.pressed);
+    TEST_ASSERT_EQUAL_UINT32(1, pipeline->stats().refused);
+}
+
+// the stack refuses a press, then the link drops before it is offered again
+void test_refused_press_survives_disconnect() {
+    hidReport_t report;
+    offer(0, report);
+    queue.push(HAL_KEY_DOWN_ARROW, 10, true);
+    TEST_ASSERT_TRUE(offer(SETTLE_MSEC, report));
+    pipeline->sent(false, SETTLE_MSEC * 1000);
+
+    disconnect(SETTLE_MSEC + 5);
+    TEST_ASSERT_EQUAL_UINT16(1, queue.depth());  // back in the queue, marked for replay
+
+    uint32_t reconnect_msec = SETTLE_MSEC + 2000;  // past the latency bound: replay entries only age
+    TEST_ASSERT_FALSE(offer(reconnect_msec, report));
+    TEST_ASSERT_TRUE(offer(reconnect_msec + SETTLE_MSEC, report));
+    TEST_ASSERT_EQUAL(HAL_KEY_DOWN_ARROW, report.key);
+    TEST_ASSERT_TRUE(report.pressed);
+    pipeline->sent(true, (reconnect_msec + SETTLE_MSEC) * 1000);
+    TEST_ASSERT_EQUAL_UINT32(1, queue.stats().sent);
+    TEST_ASSERT_EQUAL_UINT32(1, queue.stats().replayed);
+    TEST_ASSERT_EQUAL_UINT32(0, queue.stats().stale + queue.stats().expired);
+}
+
+// a requeued arrow goes in front of (or merges with) what was pressed after it
+void test_requeued_press_replays_first() {
+    hidReport_t report;
+    offer(0, report);
+    queue.push(HAL_KEY_MEDIA_EJECT, 10, true);
+    queue.push(HAL_KEY_DOWN_ARROW, 20, true);
+    queue.push(HAL_KEY_DOWN_ARROW, 30, true);
+    TEST_ASSERT_TRUE(offer(SETTLE_MSEC, report));
+    TEST_ASSERT_EQUAL(HAL_KEY_MEDIA_EJECT, report.key);
+    pipeline->sent(false, SETTLE_MSEC * 1000);
+    disconnect(SETTLE_MSEC + 5);
+    TEST_ASSERT_EQUAL_UINT16(2, queue.depth());
+
+    halKey_t key;
+    TEST_ASSERT_FALSE(queue.next(SETTLE_MSEC + 10, true, key));  // settling
+    uint32_t now_msec = 2 * SETTLE_MSEC + 10;
+    TEST_ASSERT_TRUE(queue.next(now_msec, true, key));
+    TEST_ASSERT_EQUAL(HAL_KEY_MEDIA_EJECT, key);
+    queue.requeue(key, now_msec);  // arrow entry now at the head; the eject goes in front again
+    TEST_ASSERT_TRUE(queue.next(now_msec, true, key));
+    TEST_ASSERT_EQUAL(HAL_KEY_MEDIA_EJECT, key);
+    TEST_ASSERT_TRUE(queue.next(now_msec, true, key));
+    TEST_ASSERT_EQUAL(HAL_KEY_DOWN_ARROW, key);
+    queue.requeue(key, now_msec);  // merges back into the two step entry
+    TEST_ASSERT_EQUAL_UINT16(1, queue.depth());
+    TEST_ASSERT_TRUE(queue.next(now_msec, true, key));
+    TEST_ASSERT_TRUE(queue.next(now_msec, true, key));
+    TEST_ASSERT_EQUAL(HAL_KEY_DOWN_ARROW, key);
+    TEST_ASSERT_FALSE(queue.next(now_msec, true, key));
+    TEST_ASSERT_EQUAL_UINT32(3, queue.stats().sent);
+}
+
+// a release lost to a disconnect is not replayed: the central releases all keys itself
+void test_refused_release_not_requeued() {
+    hidReport_t report;
+    offer(0, report);
+    queue.push(HAL_KEY_UP_ARROW, 10, true);
+    TEST_ASSERT_TRUE(offer(SETTLE_MSEC, report));
+    pipeline->sent(true, SETTLE_MSEC * 1000);
+    TEST_ASSERT_TRUE(offer(SETTLE_MSEC, report));
+    TEST_ASSERT_FALSE(report.pressed);
+    pipeline->sent(false, SETTLE_MSEC * 1000);
+
+    disconnect(SETTLE_MSEC + 5);
+    TEST_ASSERT_TRUE(queue.isEmpty());
+    TEST_ASSERT_FALSE(offer(3 * SETTLE_MSEC, report));
+    TEST_ASSERT_FALSE(pipeline->isBusy());
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_press_then_release);
+    RUN_TEST(test_refused_press_offered_again);
+    RUN_TEST(test_refused_press_survives_disconnect);
+    RUN_TEST(test_requeued_press_replays_first);
+    RUN_TEST(test_refused_release_not_requeued);
+    return UNITY_END();
+}
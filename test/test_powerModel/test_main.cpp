@@ -0,0 +1,67 @@
+/*
+ * *************************************************************
+ * test_main.cpp - battery life regression test (lib/powerModel)
+ *
+ *   Plays the scripted three-hour gig into the firmware (setup() and its
+ *   tasks, linked from src/ - test_build_src in platformio.ini) and fails
+ *   if projected battery life dropped below baseline.txt by more than its
+ *   tolerance.  After an intended change, regenerate the baseline with
+ *   .pio/build/native/program -p -w test/test_powerModel/baseline.txt
+ *
+ *   Run:  pio test -e native -f test_powerModel
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include <unity.h>
+
+#include <string>
+
+#include "powerModel.h"
+
+static gigResult_t result;  // the firmware boots once per process: one gig shared by every test
+static bool completed;
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// baseline.txt next to this file, wherever the build runs from
+static std::string baselinePath() {
+    std::string path = __FILE__;
+    size_t slash = path.find_last_of("/\\");
+    return (slash == std::string::npos) ? "baseline.txt" : path.substr(0, slash + 1) + "baseline.txt";
+}
+
+void test_firmware_plays_whole_gig() {
+    TEST_ASSERT_TRUE_MESSAGE(completed, "firmware stopped (deep sleep or stuck task) before the end of the gig");
+}
+
+// every gesture reaches the central, bar presses that age out during the BLE dropout
+void test_gestures_sent_as_keys() {
+    int presses = result.work.turns + result.work.doubles + result.work.holds;
+    TEST_ASSERT_LESS_OR_EQUAL_INT(presses, result.keys);
+    TEST_ASSERT_GREATER_OR_EQUAL_INT(presses - 3, result.keys);
+}
+
+void test_battery_life_not_below_baseline() {
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, comparePowerBaseline(baselinePath().c_str(), result),
+                                  "battery life regression (or no baseline) - see the report above");
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    completed = runGig(DEFAULT_CURRENT_MODEL, 1, result);
+    printGigReport(DEFAULT_CURRENT_MODEL, result);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_firmware_plays_whole_gig);
+    RUN_TEST(test_gestures_sent_as_keys);
+    RUN_TEST(test_battery_life_not_below_baseline);
+    return UNITY_END();
+}
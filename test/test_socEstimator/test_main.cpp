@@ -0,0 +1,142 @@
+/*
+ * *************************************************************
+ * test_main.cpp - unit tests for SocEstimator (lib/socEstimator) fed
+ *   through BatteryMonitor from the fake ADC
+ *
+ *   Discharge curve lookup at and between its points, the hysteresis on
+ *   the reported percentage, and voltage traces (a step and ADC noise)
+ *   passed through the EMA filter as the firmware does: fakeAdcSet_mV() ->
+ *   BatteryMonitor::update() -> SocEstimator::update().
+ *
+ *   Run:  pio test -e native -f test_socEstimator
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include <unity.h>
+
+#include "batteryMonitor.h"
+#include "myConstants.h"
+#include "socEstimator.h"
+
+constexpr int TRACE_SAMPLES = 60;  // ~8 samples settle the EMA after a step; plenty of margin
+
+static BatteryMonitor monitor(adcBatteryRead_mV<Board>, BATTERY_SAMPLE_INTERVAL_MSEC, Board::BATTERY_DIVIDER_RATIO);
+static SocEstimator estimator(SOC_HYSTERESIS_PERCENT);
+static unsigned long now_msec;
+
+static void setPack_mV(uint32_t pack_mV) {
+    fakeAdcSet_mV(pack_mV / Board::BATTERY_DIVIDER_RATIO);
+}
+
+// one battery sample as the background task takes it; true if the central would be notified
+static bool sample() {
+    now_msec += BATTERY_SAMPLE_INTERVAL_MSEC;
+    TEST_ASSERT_TRUE(monitor.update(now_msec));
+    return estimator.update(monitor.millivolts());
+}
+
+void setUp() {
+    monitor = BatteryMonitor(adcBatteryRead_mV<Board>, BATTERY_SAMPLE_INTERVAL_MSEC, Board::BATTERY_DIVIDER_RATIO);
+    estimator = SocEstimator(SOC_HYSTERESIS_PERCENT);
+    now_msec = 0;
+}
+
+void tearDown() {
+}
+
+void test_curve_points_map_exactly() {
+    for (int i = 0; i < LIPO_CURVE_POINTS; i++) {
+        TEST_ASSERT_EQUAL_UINT16(LIPO_DISCHARGE_CURVE[i].permille,
+                                 SocEstimator::permilleFromMillivolts(LIPO_DISCHARGE_CURVE[i].millivolts));
+    }
+}
+
+void test_interpolates_between_points() {
+    TEST_ASSERT_EQUAL_UINT16(10, SocEstimator::permilleFromMillivolts(3200));   // 3000 / 0 .. 3400 / 20
+    TEST_ASSERT_EQUAL_UINT16(125, SocEstimator::permilleFromMillivolts(3700));  // 3690 / 100 .. 3710 / 150
+    TEST_ASSERT_EQUAL_UINT16(975, SocEstimator::permilleFromMillivolts(4175));  // 4150 / 950 .. 4200 / 1000
+    TEST_ASSERT_EQUAL_UINT16(658, SocEstimator::permilleFromMillivolts(3917));  // rounds down: 650 + 7 * 50 / 40
+}
+
+void test_clamps_outside_curve() {
+    TEST_ASSERT_EQUAL_UINT16(0, SocEstimator::permilleFromMillivolts(2500));
+    TEST_ASSERT_EQUAL_UINT16(1000, SocEstimator::permilleFromMillivolts(4350));  // on charge
+}
+
+void test_first_update_always_reports() {
+    TEST_ASSERT_TRUE(estimator.update(3840));
+    TEST_ASSERT_EQUAL_UINT8(50, estimator.percent());
+    TEST_ASSERT_EQUAL_UINT32(1, estimator.notifyCount());
+}
+
+void test_hysteresis_holds_small_moves() {
+    estimator.update(3840);                     // 50%
+    TEST_ASSERT_FALSE(estimator.update(3837));  // 49.3% -> 49, one below
+    TEST_ASSERT_FALSE(estimator.update(3841));  // 50.5% -> 51, one above
+    TEST_ASSERT_EQUAL_UINT8(50, estimator.percent());
+    TEST_ASSERT_TRUE(estimator.update(3832));  // 48%: moved by the hysteresis
+    TEST_ASSERT_EQUAL_UINT8(48, estimator.percent());
+    TEST_ASSERT_FALSE(estimator.update(3837));  // back up to 49%: measured from 48 now
+    TEST_ASSERT_EQUAL_UINT32(2, estimator.notifyCount());
+}
+
+void test_resume_reports_from_retained_percent() {
+    estimator.resume(60);
+    TEST_ASSERT_FALSE(estimator.update(3866));  // 59%
+    TEST_ASSERT_TRUE(estimator.update(3850));   // 55%
+    TEST_ASSERT_EQUAL_UINT8(55, estimator.percent());
+}
+
+// pack drops from 50% to 40% (eg under a sustained load): the filter walks the report down in hysteresis steps
+void test_voltage_step_through_filter() {
+    setPack_mV(3840);
+    monitor.begin(now_msec, BATTERY_PRIME_ROUNDS);
+    TEST_ASSERT_TRUE(estimator.update(monitor.millivolts()));
+    TEST_ASSERT_EQUAL_UINT8(50, estimator.percent());
+
+    setPack_mV(3800);
+    uint8_t last = estimator.percent();
+    for (int i = 0; i < TRACE_SAMPLES; i++) {
+        if (sample()) {
+            TEST_ASSERT_TRUE(estimator.percent() < last);  // only ever down, by at least the hysteresis
+            TEST_ASSERT_TRUE(last - estimator.percent() >= SOC_HYSTERESIS_PERCENT);
+            last = estimator.percent();
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(3800, monitor.millivolts());
+    TEST_ASSERT_EQUAL_UINT8(40, estimator.percent());
+    TEST_ASSERT_TRUE(estimator.notifyCount() <= 1 + (50 - 40) / SOC_HYSTERESIS_PERCENT);
+}
+
+// ADC noise of +-16 mV at the pack (-6% / +4% of charge on this steep part of the curve) is not passed on;
+//   the filter leaves ~4 mV of ripple, so much more than this would flap the report by the hysteresis
+void test_adc_noise_does_not_flap_report() {
+    setPack_mV(3800);
+    monitor.begin(now_msec, BATTERY_PRIME_ROUNDS);
+    estimator.update(monitor.millivolts());
+    uint32_t notified = estimator.notifyCount();
+    for (int i = 0; i < TRACE_SAMPLES; i++) {
+        setPack_mV((i & 1) ? 3816 : 3784);
+        sample();
+    }
+    TEST_ASSERT_EQUAL_UINT32(notified, estimator.notifyCount());
+    TEST_ASSERT_EQUAL_UINT8(40, estimator.percent());
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_curve_points_map_exactly);
+    RUN_TEST(test_interpolates_between_points);
+    RUN_TEST(test_clamps_outside_curve);
+    RUN_TEST(test_first_update_always_reports);
+    RUN_TEST(test_hysteresis_holds_small_moves);
+    RUN_TEST(test_resume_reports_from_retained_percent);
+    RUN_TEST(test_voltage_step_through_filter);
+    RUN_TEST(test_adc_noise_does_not_flap_report);
+    return UNITY_END();
+}
@@ -0,0 +1,116 @@
+/*
+ * *************************************************************
+ * test_main.cpp - unit tests for SpscQueue (lib/spscQueue)
+ *
+ *   Single threaded: empty / full behaviour, FIFO order, and the ring
+ *   indices wrapping round many times.
+ *
+ *   Run:  pio test -e native -f test_spscQueue
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include <unity.h>
+
+#include "spscQueue.h"
+
+constexpr uint16_t CAPACITY = 8;
+typedef SpscQueue<uint32_t, CAPACITY> TestQueue;
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_new_queue_is_empty() {
+    TestQueue queue;
+    uint32_t item = 99;
+    TEST_ASSERT_TRUE(queue.isEmpty());
+    TEST_ASSERT_EQUAL_UINT16(0, queue.size());
+    TEST_ASSERT_FALSE(queue.pop(item));
+    TEST_ASSERT_EQUAL_UINT32(99, item);  // untouched
+    TEST_ASSERT_EQUAL_UINT32(0, queue.dropped());
+}
+
+void test_full_queue_refuses_and_counts_drop() {
+    TestQueue queue;
+    for (uint32_t i = 0; i < CAPACITY; i++) {
+        TEST_ASSERT_TRUE(queue.push(i));
+    }
+    TEST_ASSERT_EQUAL_UINT16(CAPACITY, queue.size());
+    TEST_ASSERT_FALSE(queue.push(100));
+    TEST_ASSERT_FALSE(queue.push(101));
+    TEST_ASSERT_EQUAL_UINT32(2, queue.dropped());
+
+    uint32_t item;
+    TEST_ASSERT_TRUE(queue.pop(item));
+    TEST_ASSERT_EQUAL_UINT32(0, item);  // the refused items did not overwrite the oldest
+    TEST_ASSERT_TRUE(queue.push(102));  // room again after one pop
+    TEST_ASSERT_FALSE(queue.push(103));
+}
+
+void test_drains_in_fifo_order_to_empty() {
+    TestQueue queue;
+    for (uint32_t i = 0; i < CAPACITY; i++) {
+        queue.push(i * 10);
+    }
+    uint32_t item;
+    for (uint32_t i = 0; i < CAPACITY; i++) {
+        TEST_ASSERT_TRUE(queue.pop(item));
+        TEST_ASSERT_EQUAL_UINT32(i * 10, item);
+    }
+    TEST_ASSERT_TRUE(queue.isEmpty());
+    TEST_ASSERT_FALSE(queue.pop(item));
+}
+
+// indices run far past the capacity; order and size must hold at every offset into the ring
+void test_wraparound_keeps_order_and_size() {
+    TestQueue queue;
+    uint32_t pushed = 0, popped = 0;
+    for (int round = 0; round < 10 * CAPACITY; round++) {
+        int burst = 1 + round % CAPACITY;  // 1 .. CAPACITY, so the fill level moves round the ring
+        for (int i = 0; i < burst; i++) {
+            TEST_ASSERT_TRUE(queue.push(pushed++));
+        }
+        TEST_ASSERT_EQUAL_UINT16(burst, queue.size());
+        uint32_t item;
+        while (queue.pop(item)) {
+            TEST_ASSERT_EQUAL_UINT32(popped++, item);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(pushed, popped);
+    TEST_ASSERT_EQUAL_UINT32(0, queue.dropped());
+}
+
+void test_full_after_wraparound() {
+    TestQueue queue;
+    uint32_t item;
+    for (uint32_t i = 0; i < CAPACITY + 3; i++) {  // head and tail now 3 slots past the ring's end
+        queue.push(i);
+        queue.pop(item);
+    }
+    for (uint32_t i = 0; i < CAPACITY; i++) {
+        TEST_ASSERT_TRUE(queue.push(i));
+    }
+    TEST_ASSERT_FALSE(queue.push(CAPACITY));
+    for (uint32_t i = 0; i < CAPACITY; i++) {
+        TEST_ASSERT_TRUE(queue.pop(item));
+        TEST_ASSERT_EQUAL_UINT32(i, item);
+    }
+    TEST_ASSERT_TRUE(queue.isEmpty());
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_new_queue_is_empty);
+    RUN_TEST(test_full_queue_refuses_and_counts_drop);
+    RUN_TEST(test_drains_in_fifo_order_to_empty);
+    RUN_TEST(test_wraparound_keeps_order_and_size);
+    RUN_TEST(test_full_after_wraparound);
+    return UNITY_END();
+}
@@ -0,0 +1,310 @@
+/*
+ * *************************************************************
+ * hidBench.cpp - host tool: HID report throughput / latency benchmark
+ *
+ *   Compares the two ways of getting keys to the central, on the native HAL's
+ *   BLE link model (notifications leave at connection events, a few per
+ *   event, and the stack has a fixed number of buffers):
+ *     fixed delay   one key per HID_QUEUE send gap (10 ms), written as press +
+ *                   release with the BLE keyboard library's 7 ms sleep after
+ *                   each report - the input task is blocked meanwhile
+ *     flow control  HidPipeline: reports sent as soon as the completion
+ *                   window and stack buffers allow, nothing blocks
+ *   Scenarios: single page turns at random link phase, a burst of page turns
+ *   (eg replay after a dropout), and 3 s of hold-to-scroll, each on a good
+ *   link (15 ms interval), a congested one (30 ms, one report per event) and
+ *   a poor one (75 ms, one per event - slower than the auto-repeat rate).
+ *
+ *   Latency is push into the HID queue -> press report delivered (its
+ *   completion event); "blocked" is input task time spent sleeping in a send.
+ *
+ *   Flow control is not a win everywhere: on the congested and poor links it
+ *   delivers every burst key where fixed delay loses the ones the stack
+ *   refuses, but at a lower key rate and with higher mean / max latency.
+ *   HID_MAX_LATENCY_MSEC caps the queueing part; keys past it are dropped
+ *   (stale column), and delivery can still take a few connection intervals
+ *   more for the reports already with the stack.
+ *
+ *   Build (from the repository root):
+ *     g++ -std=gnu++11 -O2 -Ilib/hal/native -Ilib/hal -Ilib/hidQueue -Ilib/myConstants \
+ *         -Ilib/boardProfile -Ilib/press_type -Ilib/batterySaver -Ilib/connParams -Ilib/powerPolicy \
+ *         -Ilib/controlRGB -Ilib/spscQueue -Ilib/logger \
+ *         tools/hidBench/hidBench.cpp lib/hidQueue/hidQueue.cpp lib/hidQueue/hidPipeline.cpp \
+ *         lib/hal/hal_native.cpp -o hidBench
+ *
+ *   Usage:  hidBench [-s seed]
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <deque>
+
+#include "hal.h"
+#include "hidPipeline.h"
+#include "hidQueue.h"
+#include "myConstants.h"
+
+constexpr uint32_t FIXED_GAP_MSEC = 10;           // HID_SEND_GAP_MSEC before the pipeline
+constexpr uint32_t LIBRARY_REPORT_DELAY_MSEC = 7;  // BleKeyboard default sleep after each report
+constexpr uint32_t SETTLE_MSEC = 2000;            // queue's reconnect settle, then the scenario starts
+constexpr int SINGLE_TURNS = 50;
+constexpr uint32_t SINGLE_SPACING_MSEC = 1000;
+constexpr int BURST_KEYS = 12;
+constexpr uint32_t HOLD_MSEC = 3000;
+constexpr uint32_t DRAIN_MSEC = 3000;  // after the last push, for deliveries to finish
+
+struct link_t {
+    const char* name;
+    uint32_t interval_usec;
+    int reportsPerEvent;
+    int buffers;
+};
+constexpr link_t LINKS[] = {{"good link", 15000, 4, 10}, {"congested", 30000, 1, 3}, {"poor link", 75000, 1, 3}};
+
+enum scenario_t { SINGLE,
+                  BURST,
+                  HOLD };
+static const char* const scenarioName[] = {"single turns", "burst", "hold-to-scroll"};
+
+struct result_t {
+    int pushed;
+    int delivered;
+    int afterRelease;  // hold-to-scroll: keys delivered after the pedal came up
+    int stale;         // keys the queue dropped as past the latency bound
+    uint32_t firstPush_msec, lastDelivery_msec;
+    uint64_t totalLatency_usec;
+    uint32_t maxLatency_usec;
+    uint32_t blocked_msec;
+    uint32_t backpressure;
+};
+
+static uint32_t lcg = 1;
+static uint32_t random(uint32_t range) {
+    lcg = lcg * 1664525u + 1013904223u;
+    return (lcg >> 8) % range;
+}
+
+// reports handed to the stack, in order: press reports carry their key's push time
+struct sentReport_t {
+    bool pressed;
+    uint32_t push_usec;
+};
+
+class Bench {
+   public:
+    Bench(bool flowControl, scenario_t scenario, const link_t& link)
+        : _flowControl(flowControl),
+          _scenario(scenario),
+          _queue(HID_EVENT_MAX_AGE_MSEC, flowControl ? HID_MAX_LATENCY_MSEC : 0, flowControl ? HID_SEND_GAP_MSEC : FIXED_GAP_MSEC,
+                 HID_RECONNECT_SETTLE_MSEC),
+          _pipeline(_queue, HID_MAX_OUTSTANDING, HID_COMPLETION_TIMEOUT_MSEC, HID_REPEAT_INTERVAL_MSEC),
+          _result() {
+        simReset();
+        simSetLink(link.interval_usec, link.reportsPerEvent, link.buffers);
+        simSetConnected(true);
+    }
+
+    result_t run() {
+        uint32_t start_msec = SETTLE_MSEC;
+        uint32_t end_msec = start_msec + DRAIN_MSEC;
+        int nextTurn = 0;
+        uint32_t nextTurn_msec = start_msec + random(50);
+        bool holding = false;
+        if (_scenario == SINGLE) {
+            end_msec += SINGLE_TURNS * SINGLE_SPACING_MSEC;
+        } else if (_scenario == HOLD) {
+            end_msec += HOLD_MSEC;
+        }
+
+        while (halMillis() < end_msec) {
+            uint32_t now_msec = halMillis();
+            if ((_scenario == SINGLE) && (nextTurn < SINGLE_TURNS) && (now_msec >= nextTurn_msec)) {
+                push(now_msec);
+                nextTurn++;
+                nextTurn_msec = start_msec + nextTurn * SINGLE_SPACING_MSEC + random(50);  // random link phase
+            } else if ((_scenario == BURST) && (now_msec == start_msec)) {
+                for (int k = 0; k < BURST_KEYS; k++) {
+                    push(now_msec);
+                }
+            } else if ((_scenario == HOLD) && (now_msec == start_msec)) {
+                holding = true;
+                if (_flowControl) {
+                    _pipeline.startRepeat(HAL_KEY_DOWN_ARROW, now_msec);
+                }
+                _nextRepeat_msec = now_msec;
+            } else if (holding && (now_msec >= start_msec + HOLD_MSEC)) {
+                holding = false;
+                _released = true;
+                _pipeline.stopRepeat();
+            }
+            // fixed delay: the old firmware auto-repeated by pushing on a timer, whatever the backlog
+            if (holding && !_flowControl && (now_msec >= _nextRepeat_msec)) {
+                push(now_msec);
+                _nextRepeat_msec = now_msec + HID_REPEAT_INTERVAL_MSEC;
+            }
+
+            takeCompletions();
+            if (_flowControl) {
+                sendFlowControlled();
+            } else {
+                sendFixedDelay();
+            }
+            simAdvanceMsec(1);  // input task polls at tick rate while busy
+        }
+        takeCompletions();
+        _result.backpressure = _pipeline.stats().backpressure;
+        _result.stale = _queue.stats().stale;
+        return _result;
+    }
+
+   private:
+    void push(uint32_t now_msec) {
+        _queue.push(HAL_KEY_DOWN_ARROW, now_msec, true);
+        _pushTimes.push_back(halMicros());
+        if (_result.pushed++ == 0) {
+            _result.firstPush_msec = now_msec;
+        }
+    }
+
+    // the pipeline counts its own repeats; match them to push times as they are queued
+    void noteRepeats() {
+        while (_repeatsSeen < _pipeline.stats().repeats) {
+            _repeatsSeen++;
+            _pushTimes.push_back(halMicros());
+            if (_result.pushed++ == 0) {
+                _result.firstPush_msec = halMillis();
+            }
+        }
+    }
+
+    // keys the queue dropped as stale were the oldest queued: forget their push times
+    void noteStale() {
+        while (_staleSeen < _queue.stats().stale) {
+            _staleSeen++;
+            _pushTimes.pop_front();
+        }
+    }
+
+    void sendFlowControlled() {
+        _pipeline.completed(_completions, halMicros());
+        _completions = 0;
+        hidReport_t report;
+        for (;;) {
+            bool offered = _pipeline.next(halMillis(), halMicros(), true, halBleSendCredits(), report);
+            noteRepeats();
+            noteStale();
+            if (!offered) {
+                break;
+            }
+            bool accepted = halKeyboardSendReport(report.key, report.pressed);
+            _pipeline.sent(accepted, halMicros());
+            if (!accepted) {
+                break;
+            }
+            recordSent(report.pressed);
+        }
+    }
+
+    void sendFixedDelay() {
+        halKey_t key;
+        if (!_queue.next(halMillis(), true, key)) {
+            return;
+        }
+        for (int r = 0; r < 2; r++) {  // BleKeyboard::write(): press, sleep, release, sleep
+            bool pressed = (r == 0);
+            if (halKeyboardSendReport(key, pressed)) {
+                recordSent(pressed);
+            } else if (pressed) {
+                _pushTimes.pop_front();  // stack full: key lost
+            }
+            simAdvanceMsec(LIBRARY_REPORT_DELAY_MSEC);
+            _result.blocked_msec += LIBRARY_REPORT_DELAY_MSEC;
+            takeCompletions();
+        }
+    }
+
+    void recordSent(bool pressed) {
+        sentReport_t sent = {pressed, 0};
+        if (pressed) {
+            sent.push_usec = _pushTimes.front();
+            _pushTimes.pop_front();
+        }
+        _inFlight.push_back(sent);
+    }
+
+    // completions are in send order: each press completed is a key delivered
+    void takeCompletions() {
+        uint32_t count = halBleTakeCompletions();
+        _completions += count;
+        for (; (count > 0) && !_inFlight.empty(); count--) {
+            sentReport_t done = _inFlight.front();
+            _inFlight.pop_front();
+            if (!done.pressed) {
+                continue;
+            }
+            uint32_t latency_usec = halMicros() - done.push_usec;
+            _result.delivered++;
+            _result.totalLatency_usec += latency_usec;
+            if (latency_usec > _result.maxLatency_usec) {
+                _result.maxLatency_usec = latency_usec;
+            }
+            _result.lastDelivery_msec = halMillis();
+            if (_released) {
+                _result.afterRelease++;
+            }
+        }
+    }
+
+    bool _flowControl;
+    scenario_t _scenario;
+    HidEventQueue _queue;
+    HidPipeline _pipeline;
+    result_t _result;
+    std::deque<uint32_t> _pushTimes;  // keys queued, not yet sent
+    std::deque<sentReport_t> _inFlight;
+    uint32_t _completions = 0;  // for the pipeline, taken with the bench's own accounting
+    uint32_t _repeatsSeen = 0;
+    uint32_t _staleSeen = 0;
+    uint32_t _nextRepeat_msec = 0;
+    bool _released = false;
+};
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc)) {
+            lcg = (uint32_t)strtoul(argv[++i], nullptr, 0);
+        } else {
+            fprintf(stderr, "usage: hidBench [-s seed]\n");
+            return 2;
+        }
+    }
+
+    printf("%-15s %-10s %-13s %5s %9s %6s %7s %9s %9s %8s %7s %6s\n", "scenario", "link", "mode", "keys",
+           "delivered", "stale", "keys/s", "mean ms", "max ms", "blocked", "backpr", "late");
+    for (int s = SINGLE; s <= HOLD; s++) {
+        for (const link_t& link : LINKS) {
+            for (int flow = 0; flow < 2; flow++) {
+                uint32_t seed = lcg;
+                Bench bench(flow == 1, (scenario_t)s, link);
+                result_t r = bench.run();
+                lcg = seed;  // same random phases for both modes
+                uint32_t span_msec = r.lastDelivery_msec - r.firstPush_msec;
+                double rate = ((s != SINGLE) && (span_msec > 0)) ? 1000.0 * r.delivered / span_msec : 0;
+                printf("%-15s %-10s %-13s %5d %9d %6d %7.1f %9.1f %9.1f %8lu %7lu %6d\n", scenarioName[s], link.name,
+                       flow ? "flow control" : "fixed delay", r.pushed, r.delivered, r.stale, rate,
+                       r.delivered ? r.totalLatency_usec / 1000.0 / r.delivered : 0.0, r.maxLatency_usec / 1000.0,
+                       (unsigned long)r.blocked_msec, (unsigned long)r.backpressure, r.afterRelease);
+            }
+        }
+    }
+    printf("keys/s over first push -> last delivery (burst, hold); stale = dropped past HID_MAX_LATENCY_MSEC;\n"
+           "blocked = input task asleep in a send (ms); backpr = backpressure events;\n"
+           "late = hold-to-scroll keys delivered after release\n");
+    return 0;
+}
@@ -0,0 +1,238 @@
+/*
+ * *************************************************************
+ * lowLatencyBench.cpp - host tool: latency saved by low latency taps
+ *
+ *   Plays the same scripted foot switch taps through PedalBank (the
+ *   firmware's debounce + gesture classifier) on the native HAL, once in
+ *   normal mode and once in low latency mode (FLIPTURN_LOW_LATENCY_TAPS /
+ *   button.setLowLatencyMode()), and times each page turn from the release
+ *   that completes it to the gesture that sends its key.  Taps have random
+ *   lengths, double tap gaps and contact bounce; the classifier is fed
+ *   scans at the edges and ticks every 1 ms while a timer is pending, as
+ *   the input task does.
+ *
+ *   Only gesture classification differs between the modes: the HID queue
+ *   and BLE link add the same time to both.  The cost of low latency mode
+ *   is shown too: a double tap sends three keys instead of one, and the
+ *   early page down is on screen until the second release.
+ *
+ *   Build (from the repository root):
+ *     g++ -std=gnu++11 -O2 -Ilib/hal/native -Ilib/hal -Ilib/myConstants -Ilib/boardProfile \
+ *         -Ilib/press_type -Ilib/batterySaver \
+ *         tools/lowLatencyBench/lowLatencyBench.cpp lib/press_type/pedalBank.cpp \
+ *         lib/press_type/gestureClassifier.cpp lib/hal/hal_native.cpp -o lowLatencyBench
+ *
+ *   Usage:  lowLatencyBench [-s seed]
+ *   Exit:   0 ok, 1 a gesture was misclassified, 2 usage
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hal.h"
+#include "myConstants.h"
+#include "pedalBank.h"
+
+constexpr int GESTURES = 400;
+constexpr int DOUBLE_TAP_PERCENT = 25;
+constexpr uint32_t GESTURE_SPACING_MSEC = 1500;  // page turns well apart: every gesture times out on its own
+constexpr uint32_t TAP_MIN_MSEC = 50, TAP_RANGE_MSEC = 130;   // press length
+constexpr uint32_t GAP_MIN_MSEC = 60, GAP_RANGE_MSEC = 150;   // double tap: release -> second press, inside the window
+constexpr int BOUNCE_PERCENT = 30;                           // edges followed by contact bounce
+constexpr uint32_t BOUNCE_USEC = 400;                         // between bounce edges, well inside the debounce time
+constexpr int MAX_EDGES = GESTURES * 4 * 3;                   // 4 edges per double tap, each with up to 2 bounce edges
+
+struct edge_t {
+    uint32_t time_usec;
+    bool pressed;
+};
+
+// one scripted page turn; release_usec = the release that completes it
+struct script_t {
+    bool doubleTap;
+    uint32_t release_usec;
+};
+
+struct result_t {
+    int turns[2];             // [0] single taps, [1] double taps
+    uint64_t total_usec[2];   // completing release -> key gesture
+    uint32_t max_usec[2];
+    int keys;                 // HID keys the gestures send
+    uint64_t wrongPage_usec;  // low latency double taps: early page down until the correction
+    int misclassified;
+};
+
+static uint32_t lcg = 1;
+static uint32_t random(uint32_t range) {
+    lcg = lcg * 1664525u + 1013904223u;
+    return (lcg >> 8) % range;
+}
+
+static script_t script[GESTURES];
+static edge_t edges[MAX_EDGES];
+static int edgeCount = 0;
+
+static void addEdge(uint32_t time_usec, bool pressed) {
+    edges[edgeCount++] = {time_usec, pressed};
+    if ((int)random(100) < BOUNCE_PERCENT) {
+        edges[edgeCount++] = {time_usec + BOUNCE_USEC, !pressed};
+        edges[edgeCount++] = {time_usec + 2 * BOUNCE_USEC, pressed};
+    }
+}
+
+static void makeScript() {
+    edgeCount = 0;
+    for (int g = 0; g < GESTURES; g++) {
+        script_t& s = script[g];
+        uint32_t press_usec = (1000 + g * GESTURE_SPACING_MSEC + random(100)) * 1000;
+        s.doubleTap = (int)random(100) < DOUBLE_TAP_PERCENT;
+        s.release_usec = press_usec + (TAP_MIN_MSEC + random(TAP_RANGE_MSEC)) * 1000;
+        addEdge(press_usec, true);
+        addEdge(s.release_usec, false);
+        if (s.doubleTap) {
+            uint32_t second_usec = s.release_usec + (GAP_MIN_MSEC + random(GAP_RANGE_MSEC)) * 1000;
+            s.release_usec = second_usec + (TAP_MIN_MSEC + random(TAP_RANGE_MSEC)) * 1000;
+            addEdge(second_usec, true);
+            addEdge(s.release_usec, false);
+        }
+    }
+}
+
+static PedalBank* bank = nullptr;
+
+static void pedalIsr() {
+    pedalScan_t scan = {halMicros(), halReadInputs()};
+    bank->onScan(scan);
+}
+
+class Bench {
+   public:
+    explicit Bench(bool lowLatency)
+        : _bank(SWITCH_DEBOUNCE_MSEC * 1000, DOUBLE_TAP_WINDOW_MSEC * 1000, HOLD_DURATION_MSEC * 1000,
+                CHORD_WINDOW_MSEC * 1000),
+          _result(),
+          _lowLatency(lowLatency) {
+        simReset();
+        bank = &_bank;
+        _pin = PEDALS[0].pin;
+        _bank.addPedal(_pin);
+        _bank.setLowLatency(lowLatency);
+        halAttachChangeInterrupt(_pin, pedalIsr);
+    }
+
+    result_t run() {
+        uint32_t end_usec = script[GESTURES - 1].release_usec + 2 * HOLD_DURATION_MSEC * 1000;
+        int e = 0;
+        uint32_t nextTick_usec = halMicros();
+        while (halMicros() < end_usec) {
+            if ((e < edgeCount) && (edges[e].time_usec <= nextTick_usec)) {
+                simAdvanceUsec(edges[e].time_usec - halMicros());
+                simSetPin(_pin, !edges[e].pressed);  // pressed = LOW; the isr scans
+                e++;
+                takeGestures();
+                nextTick_usec = halMicros() + 1000;  // input task woken: ticks from here while busy
+                continue;
+            }
+            simAdvanceUsec(nextTick_usec - halMicros());
+            _bank.onTick(halMicros(), halReadInputs());
+            takeGestures();
+            nextTick_usec += _bank.isIdle() ? INPUT_IDLE_POLL_MSEC * 1000 : 1000;
+        }
+        _result.misclassified += GESTURES - _next;  // never reported
+        return _result;
+    }
+
+   private:
+    // matches each gesture against the script, in order
+    void takeGestures() {
+        pedalGesture_t gesture;
+        while (_bank.takeGesture(gesture)) {
+            uint32_t now_usec = halMicros();
+            if (_next == GESTURES) {
+                _result.misclassified++;
+                continue;
+            }
+            const script_t& s = script[_next];
+            if (gesture.type == SHORT_PRESS) {
+                _result.keys++;
+                if (!s.doubleTap) {
+                    record(0, now_usec - s.release_usec);
+                } else if (_lowLatency && (now_usec < s.release_usec)) {
+                    _earlyShort_usec = now_usec;  // first tap of a double, sent on release
+                } else {
+                    _result.misclassified++;  // a double tap split into single taps
+                }
+                continue;
+            }
+            if ((gesture.type == DOUBLE_PRESS) && s.doubleTap) {
+                _result.keys++;
+                record(1, now_usec - s.release_usec);
+            } else if ((gesture.type == DOUBLE_PRESS_AFTER_SHORT) && s.doubleTap) {
+                _result.keys += 2;  // undo the early page down, then page up
+                _result.wrongPage_usec += now_usec - _earlyShort_usec;
+                record(1, now_usec - s.release_usec);
+            } else {
+                _result.misclassified++;
+                _next++;
+            }
+        }
+    }
+
+    void record(int kind, uint32_t latency_usec) {
+        _result.turns[kind]++;
+        _result.total_usec[kind] += latency_usec;
+        if (latency_usec > _result.max_usec[kind]) {
+            _result.max_usec[kind] = latency_usec;
+        }
+        _next++;
+    }
+
+    PedalBank _bank;
+    int _pin;
+    result_t _result;
+    bool _lowLatency;
+    int _next = 0;  // script entry expected next
+    uint32_t _earlyShort_usec = 0;
+};
+
+static double meanMsec(uint64_t total_usec, int count) {
+    return count ? total_usec / 1000.0 / count : 0.0;
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc)) {
+            lcg = (uint32_t)strtoul(argv[++i], nullptr, 0);
+        } else {
+            fprintf(stderr, "usage: lowLatencyBench [-s seed]\n");
+            return 2;
+        }
+    }
+    makeScript();
+
+    result_t r[2];
+    for (int low = 0; low < 2; low++) {
+        Bench bench(low == 1);
+        r[low] = bench.run();
+    }
+
+    printf("%-12s %6s %9s %9s %6s %9s %9s %6s %11s %6s\n", "mode", "single", "mean ms", "max ms", "double",
+           "mean ms", "max ms", "keys", "wrong ms", "errors");
+    for (int low = 0; low < 2; low++) {
+        int doubles = r[low].turns[1];
+        printf("%-12s %6d %9.1f %9.1f %6d %9.1f %9.1f %6d %11.1f %6d\n", low ? "low latency" : "normal",
+               r[low].turns[0], meanMsec(r[low].total_usec[0], r[low].turns[0]), r[low].max_usec[0] / 1000.0, doubles,
+               meanMsec(r[low].total_usec[1], doubles), r[low].max_usec[1] / 1000.0, r[low].keys,
+               meanMsec(r[low].wrongPage_usec, doubles), r[low].misclassified);
+    }
+    printf("saved per single tap: %.1f ms mean\n",
+           meanMsec(r[0].total_usec[0], r[0].turns[0]) - meanMsec(r[1].total_usec[0], r[1].turns[0]));
+    printf("latency = completing release -> gesture reported (key queued); keys = HID keys sent;\n"
+           "wrong ms = mean time a double tap's early page down is shown; errors = misclassified gestures\n");
+    return (r[0].misclassified + r[1].misclassified) ? 1 : 0;
+}
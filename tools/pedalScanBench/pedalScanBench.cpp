@@ -0,0 +1,127 @@
+/*
+ * *************************************************************
+ * pedalScanBench.cpp - host tool: PedalBank scan and chord detection cost
+ *
+ *   Times the work the input task does per GPIO input register snapshot
+ *   (PedalBank::onScan) and per timer tick (onTick), with 1, 4 and 8 pedals
+ *   configured, and one full chord press + release cycle with 8 pedals.
+ *   A scan with no level change and an idle tick should cost the same
+ *   whatever the pedal count: the pedal pins are masked in one operation
+ *   and only changed pins are visited.
+ *
+ *   Host figures (x86) show how the cost scales, not ESP32 cycle counts.
+ *   The chord cycle also checks that every cycle gives one CHORD_PRESS.
+ *
+ *   Build (from the repository root):
+ *     g++ -std=gnu++11 -O2 -Ilib/hal/native -Ilib/hal -Ilib/myConstants -Ilib/boardProfile \
+ *         -Ilib/press_type -Ilib/batterySaver \
+ *         tools/pedalScanBench/pedalScanBench.cpp lib/press_type/pedalBank.cpp \
+ *         lib/press_type/gestureClassifier.cpp lib/hal/hal_native.cpp -o pedalScanBench
+ *
+ *   Usage:  pedalScanBench [-n iterations]
+ *   Exit:   0 ok, 1 chord cycles did not give one CHORD_PRESS each, 2 usage
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "hal.h"
+#include "myConstants.h"
+#include "pedalBank.h"
+
+constexpr int PIN_SPACING = 4;                   // pedals on GPIO 0, 4, 8 ... (any pins in the register)
+constexpr uint64_t ALL_RELEASED = ~0ULL;         // pedals wired NO to GND: high = released
+constexpr uint32_t CHORD_SECOND_USEC = 10;       // second pedal of the chord, well inside CHORD_WINDOW_MSEC
+constexpr uint32_t CHORD_RELEASE_USEC = 500;
+constexpr uint32_t CYCLE_USEC = 1000;
+constexpr int CHORD_CYCLES_DIVISOR = 5;          // chord cycles are slower: fewer of them
+constexpr int PEDAL_COUNTS[] = {1, 4, MAX_PEDALS};
+
+typedef std::chrono::steady_clock benchClock;
+
+static double nsecPer(benchClock::time_point start, benchClock::time_point end, int iterations) {
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+static PedalBank makeBank(int pedals, uint32_t debounce_usec) {
+    PedalBank bank(debounce_usec, DOUBLE_TAP_WINDOW_MSEC * 1000, HOLD_DURATION_MSEC * 1000, CHORD_WINDOW_MSEC * 1000);
+    for (int p = 0; p < pedals; p++) {
+        bank.addPedal(p * PIN_SPACING);
+    }
+    return bank;
+}
+
+// scan with no level change: the common case, eg another pin on the register changed
+static double timeIdleScan(int pedals, int iterations) {
+    PedalBank bank = makeBank(pedals, SWITCH_DEBOUNCE_MSEC * 1000);
+    pedalScan_t scan = {halMicros(), ALL_RELEASED};
+    benchClock::time_point start = benchClock::now();
+    for (int i = 0; i < iterations; i++) {
+        scan.time_usec++;
+        bank.onScan(scan);
+    }
+    return nsecPer(start, benchClock::now(), iterations);
+}
+
+// tick with no timer pending: the input task's poll while nothing is pressed
+static double timeIdleTick(int pedals, int iterations) {
+    PedalBank bank = makeBank(pedals, SWITCH_DEBOUNCE_MSEC * 1000);
+    uint32_t now_usec = halMicros();
+    benchClock::time_point start = benchClock::now();
+    for (int i = 0; i < iterations; i++) {
+        bank.onTick(now_usec + i, ALL_RELEASED);
+    }
+    return nsecPer(start, benchClock::now(), iterations);
+}
+
+// pedals 0 and 1 pressed together then released, gesture taken; chords counts the CHORD_PRESSes
+static double timeChordCycle(int cycles, int& chords) {
+    PedalBank bank = makeBank(MAX_PEDALS, 0);  // no debounce: every scan is an edge
+    bank.addChord(0x03);
+    const uint64_t pedal0 = 1ULL << 0, pedal1 = 1ULL << PIN_SPACING;
+    pedalGesture_t gesture;
+    chords = 0;
+    benchClock::time_point start = benchClock::now();
+    for (int i = 0; i < cycles; i++) {
+        uint32_t cycle_usec = i * CYCLE_USEC;
+        bank.onScan({cycle_usec, ALL_RELEASED & ~pedal0});
+        bank.onScan({cycle_usec + CHORD_SECOND_USEC, ALL_RELEASED & ~(pedal0 | pedal1)});
+        bank.onScan({cycle_usec + CHORD_RELEASE_USEC, ALL_RELEASED});
+        while (bank.takeGesture(gesture)) {
+            chords += (gesture.type == CHORD_PRESS);
+        }
+    }
+    return nsecPer(start, benchClock::now(), cycles);
+}
+
+int main(int argc, char** argv) {
+    int iterations = 10000000;
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc) && (atoi(argv[i + 1]) >= CHORD_CYCLES_DIVISOR)) {
+            iterations = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: pedalScanBench [-n iterations]\n");
+            return 2;
+        }
+    }
+    simReset();
+
+    printf("%-7s %14s %14s\n", "pedals", "idle scan ns", "idle tick ns");
+    for (int pedals : PEDAL_COUNTS) {
+        printf("%-7d %14.2f %14.2f\n", pedals, timeIdleScan(pedals, iterations), timeIdleTick(pedals, iterations));
+    }
+
+    int cycles = iterations / CHORD_CYCLES_DIVISOR;
+    int chords;
+    double chord_nsec = timeChordCycle(cycles, chords);
+    printf("chord press + release cycle, %d pedals: %.2f ns (%d of %d cycles gave CHORD_PRESS)\n", MAX_PEDALS,
+           chord_nsec, chords, cycles);
+    return (chords == cycles) ? 0 : 1;
+}
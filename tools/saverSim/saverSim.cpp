@@ -0,0 +1,204 @@
+/*
+ * *************************************************************
+ * saverSim.cpp - host tool: battery saver runtime simulation
+ *
+ *   Discharges a simulated pack along the LiPo curve (socEstimator.h) while
+ *   the real policies run on the native HAL: flipState LED machine,
+ *   batteryMonitor + socEstimator, powerPolicy, connParams and batterySaver.
+ *   Each 10 ms step draws current from the component model in
+ *   lib/powerModel/currentModel.h until flipTurn auto shuts down.  Runs
+ *   once with the battery saver held at NORMAL and once with it live, and
+ *   reports the extra runtime.
+ *
+ *   The default current figures are coarse ESP32 / LED estimates - good for
+ *   comparing policies, not for absolute battery life (-m loads measured ones).
+ *
+ *   Build (from the repository root):
+ *     g++ -std=gnu++11 -O2 -D LOG_LEVEL_FLIPSTATE=LOG_LEVEL_NONE -D LOG_LEVEL_BATTERY=LOG_LEVEL_NONE \
+ *         -Ilib/hal/native -Ilib/powerModel -Ilib/hal -Ilib/press_type -Ilib/traceRecorder \
+ *         -Ilib/flipState -Ilib/controlRGB -Ilib/batteryMonitor -Ilib/batterySaver -Ilib/socEstimator -Ilib/logger \
+ *         -Ilib/spscQueue -Ilib/myConstants -Ilib/boardProfile -Ilib/powerPolicy -Ilib/connParams \
+ *         tools/saverSim/saverSim.cpp lib/batterySaver/batterySaver.cpp lib/powerPolicy/powerPolicy.cpp \
+ *         lib/connParams/connParams.cpp lib/traceRecorder/traceRecorder.cpp lib/flipState/flipState.cpp \
+ *         lib/controlRGB/controlRGB.cpp lib/batteryMonitor/batteryMonitor.cpp \
+ *         lib/batteryMonitor/batteryAdc.cpp lib/socEstimator/socEstimator.cpp lib/logger/logger.cpp \
+ *         lib/hal/hal_native.cpp -o saverSim
+ *
+ *   Usage:  saverSim [-m current model] [-c capacity mAh] [-i seconds between page turns] [-s start %] [-v]
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batteryMonitor.h"
+#include "batterySaver.h"
+#include "connParams.h"
+#include "controlRGB.h"
+#include "currentModel.h"
+#include "flipState.h"
+#include "hal.h"
+#include "myConstants.h"
+#include "powerPolicy.h"
+#include "socEstimator.h"
+
+constexpr uint32_t STEP_MSEC = 10;       // background task period
+constexpr uint32_t PRESS_BUSY_MSEC = 60;  // gesture classification + HID send after a page turn
+
+struct runResult_t {
+    double runtime_min;
+    double below20_min;  // runtime after the reported charge first fell below 20%
+    double level_min[SAVER_LEVEL_COUNT];
+    double average_mA;
+};
+
+static runResult_t run(bool saverLive, const currentModel_t& model, uint32_t pressInterval_msec, double start_percent, bool verbose) {
+    runResult_t result = {};
+    PowerPolicy powerPolicy(POWER_BOOST_MSEC, POWER_SLEEP_AFTER_MSEC);
+    ConnectionPolicy connPolicy(CONN_IDLE_AFTER_MSEC, CONN_UPDATE_RETRY_MSEC);
+    BatterySaver batterySaver(SAVER_REDUCED_BELOW_PERCENT, SAVER_CRITICAL_BELOW_PERCENT, SAVER_HYSTERESIS_PERCENT);
+    connParams_t conn = CONN_PARAMS_ACTIVE;
+
+    // globals from flipState.cpp back to power-on defaults
+    socEstimator = SocEstimator(SOC_HYSTERESIS_PERCENT);
+    batteryMonitor.setSampleInterval(BATTERY_SAMPLE_INTERVAL_MSEC);
+    rgbLed.setBrightness(100);
+    setIndicationScale(100);
+
+    double charge_mAs = model.capacity_mAh * 3600.0 * start_percent / 100.0;
+    const double full_mAs = model.capacity_mAh * 3600.0;
+    double sink_mAs[SINK_COUNT] = {};
+    simReset();
+    halPowerBegin(CPU_BOOST_MHZ, CPU_ECO_MHZ, PEDALS[0].pin);  // as setup() does
+    simSetConnected(true);
+    fakeAdcSet_mV(packOcv_mV(start_percent * 10) / Board::BATTERY_DIVIDER_RATIO);
+    rgbLed.begin();
+    batteryMonitor.begin(halMillis(), BATTERY_PRIME_ROUNDS);
+    updateBatteryLevel(batteryMonitor.millivolts());
+    requestState(battery_status);
+
+    bool below20 = false;
+    unsigned long below20_msec = 0;
+    unsigned long lastPress_msec = 0;
+    while (!simInDeepSleep()) {
+        unsigned long now_msec = halMillis();
+        if ((now_msec - lastPress_msec) >= pressInterval_msec) {
+            lastPress_msec = now_msec;
+            connPolicy.onActivity(now_msec);
+        }
+        bool busy = (now_msec - lastPress_msec) < PRESS_BUSY_MSEC;
+
+        // battery saver: both tasks' sides of a level change, as in flipTurn-main.cpp
+        if (saverLive && batterySaver.update(now_msec, socEstimator.percent())) {
+            const saverProfile_t& p = SAVER_PROFILES[batterySaver.level()];
+            applySaverBackground(p, batteryMonitor, connPolicy);
+            applySaverInput(p, powerPolicy);
+            if (verbose) {
+                printf("  %7.1f min  %-8s -> %-8s at %u%%\n", now_msec / 60000.0,
+                       SAVER_PROFILES[batterySaver.previous()].name, p.name, socEstimator.percent());
+            }
+        }
+        powerPolicy.update(now_msec, busy);
+        connProfile_t profile = connPolicy.update(now_msec, true);
+        if (profile != CONN_PROFILE_NONE) {
+            connPolicy.applied(profile, true, now_msec);
+            conn = ConnectionPolicy::params(profile);
+        }
+        if (batteryMonitor.update(now_msec)) {
+            updateBatteryLevel(batteryMonitor.millivolts());
+            sink_mAs[SINK_ADC] += model.adcSample_mAs;
+            charge_mAs -= model.adcSample_mAs;
+        }
+        processState();
+
+        powerSample_t sample;
+        sample.mode = powerPolicy.mode();
+        sample.boostMhz = simPowerMaxMhz();
+        sample.ecoMhz = CPU_ECO_MHZ;
+        sample.wakesPerSecond = 1000.0 / POWER_SLEEP_POLL_MSEC + 1000.0 / BACKGROUND_SLEEP_PERIOD_MSEC;
+        sample.radioEventsPerSecond = 1000.0 / (conn.maxInterval * 1.25 * (busy ? 1 : conn.latency + 1));
+        sample.radioEvent_mAs = model.bleEvent_mAs;
+        sampleLeds(sample);
+        charge_mAs -= accumulateCharge(model, sample, STEP_MSEC / 1000.0, sink_mAs);
+        fakeAdcSet_mV(packOcv_mV(charge_mAs / full_mAs * 1000.0) / Board::BATTERY_DIVIDER_RATIO);
+
+        if (!below20 && (socEstimator.percent() < 20)) {
+            below20 = true;
+            below20_msec = now_msec;
+        }
+        simAdvanceMsec(STEP_MSEC);
+    }
+
+    unsigned long end_msec = halMillis();
+    batterySaver.update(end_msec, socEstimator.percent());
+    result.runtime_min = end_msec / 60000.0;
+    result.below20_min = below20 ? (end_msec - below20_msec) / 60000.0 : 0;
+    for (int l = 0; l < SAVER_LEVEL_COUNT; l++) {
+        result.level_min[l] = batterySaver.residency_msec((saverLevel_t)l) / 60000.0;
+    }
+    double total_mAs = 0;
+    for (int s = 0; s < SINK_COUNT; s++) {
+        total_mAs += sink_mAs[s];
+    }
+    result.average_mA = total_mAs / (end_msec / 1000.0);
+    return result;
+}
+
+static void print(const char* name, const runResult_t& r) {
+    printf("%-9s %8.1f %10.1f %9.1f %9.1f %9.1f %8.2f\n", name, r.runtime_min, r.below20_min,
+           r.level_min[SAVER_NORMAL], r.level_min[SAVER_REDUCED], r.level_min[SAVER_CRITICAL], r.average_mA);
+}
+
+int main(int argc, char** argv) {
+    currentModel_t model = DEFAULT_CURRENT_MODEL;
+    double capacity_mAh = 0;  // 0 = from the current model
+    double pressInterval_sec = 30;
+    double start_percent = 100;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-m") == 0) && (i + 1 < argc)) {
+            if (!loadCurrentModel(argv[++i], model)) {
+                return 2;
+            }
+        } else if ((strcmp(argv[i], "-c") == 0) && (i + 1 < argc)) {
+            capacity_mAh = atof(argv[++i]);
+        } else if ((strcmp(argv[i], "-i") == 0) && (i + 1 < argc)) {
+            pressInterval_sec = atof(argv[++i]);
+        } else if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc)) {
+            start_percent = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+        } else {
+            fprintf(stderr, "usage: saverSim [-m current model] [-c capacity mAh] [-i seconds between page turns] [-s start %%] [-v]\n");
+            return 2;
+        }
+    }
+    if (capacity_mAh > 0) {
+        model.capacity_mAh = capacity_mAh;
+    }
+    if ((model.capacity_mAh <= 0) || (pressInterval_sec <= 0) || (start_percent <= 0) || (start_percent > 100)) {
+        fprintf(stderr, "saverSim: capacity and page turn interval must be > 0, start 1 - 100%%\n");
+        return 2;
+    }
+    uint32_t pressInterval_msec = (uint32_t)(pressInterval_sec * 1000);
+
+    printf("pack %.0f mAh from %.0f%%, page turn every %.0f s, BLE connected throughout\n", model.capacity_mAh, start_percent,
+           pressInterval_sec);
+    runResult_t baseline = run(false, model, pressInterval_msec, start_percent, false);
+    if (verbose) {
+        printf("saver level changes:\n");
+    }
+    runResult_t saver = run(true, model, pressInterval_msec, start_percent, verbose);
+
+    printf("%-9s %8s %10s %9s %9s %9s %8s\n", "", "runtime", "below 20%", "normal", "reduced", "critical", "avg mA");
+    printf("%-9s %8s %10s %9s %9s %9s %8s\n", "", "min", "min", "min", "min", "min", "");
+    print("baseline", baseline);
+    print("saver", saver);
+    printf("battery saver adds %.1f minutes (%+.0f%% runtime below 20%%)\n", saver.runtime_min - baseline.runtime_min,
+           baseline.below20_min > 0 ? 100.0 * (saver.below20_min - baseline.below20_min) / baseline.below20_min : 0.0);
+    return 0;
+}
@@ -0,0 +1,401 @@
+/*
+ * *************************************************************
+ * traceReplay.cpp - host tool: decode a flipTurn trace and replay it
+ *
+ *   Reads a trace captured with serial command 'r' (or 'f' for the copy
+ *   saved in flash by 'R') - a serial monitor log containing the TRACE
+ *   lines, or the raw snapshot bytes - then
+ *     1. prints the merged timeline of both cores (-v)
+ *     2. replays the raw pedal edges through PedalBank with the gesture
+ *        timing from the trace header, and matches the gestures against
+ *        the ones the firmware recorded
+ *     3. replays battery voltage, BLE link changes and (replayed) long
+ *        presses through the real flipState machine on the native HAL,
+ *        and matches the state transitions against the recorded ones
+ *   Exit code 0 = replay matches the field session, 1 = differences,
+ *   2 = unreadable trace; so a captured trace doubles as a regression test.
+ *   -b N repeats the gesture replay N times and reports the cost per record.
+ *
+ *   Build (from the repository root):
+ *     g++ -std=gnu++11 -O2 -Ilib/hal/native -Ilib/hal -Ilib/press_type \
+ *         -Ilib/traceRecorder -Ilib/flipState -Ilib/controlRGB -Ilib/batteryMonitor \
+ *         -Ilib/socEstimator -Ilib/logger -Ilib/spscQueue -Ilib/myConstants -Ilib/boardProfile \
+ *         -Ilib/batterySaver -Ilib/powerPolicy -Ilib/connParams \
+ *         tools/traceReplay/traceReplay.cpp lib/traceRecorder/traceRecorder.cpp \
+ *         lib/press_type/pedalBank.cpp lib/press_type/gestureClassifier.cpp \
+ *         lib/flipState/flipState.cpp lib/controlRGB/controlRGB.cpp \
+ *         lib/batteryMonitor/batteryMonitor.cpp lib/batteryMonitor/batteryAdc.cpp \
+ *         lib/socEstimator/socEstimator.cpp lib/logger/logger.cpp lib/hal/hal_native.cpp \
+ *         -o traceReplay
+ *
+ *   Record times are unwrapped block to block, so consecutive blocks of one
+ *   ring must be less than ~35 minutes apart (32 bit microsecond deltas).
+ *
+ *  C W Greenstreet, Ver1, 17Oct26
+ *    MIT Licence - Released into the public domain
+ *
+ * ************************************************************ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "batteryMonitor.h"
+#include "controlRGB.h"
+#include "flipState.h"
+#include "hal.h"
+#include "pedalBank.h"
+#include "traceRecorder.h"
+
+constexpr int64_t BACKGROUND_STEP_USEC = 10000;  // background task period (BACKGROUND_TASK_PERIOD_MSEC)
+constexpr int64_t INPUT_TICK_USEC = 1000;        // input task poll while a gesture timer runs
+constexpr int64_t GESTURE_TOLERANCE_USEC = 20000;
+constexpr int64_t STATE_TOLERANCE_USEC = 100000;
+constexpr int64_t STATE_SETTLE_USEC = 5000000;   // replayed state machine starts cold; compare after this
+
+static const char* const typeName[TRACE_TYPE_COUNT] = {"-", "pedals", "gesture", "hid", "link", "battery", "state"};
+
+struct event_t {
+    int64_t time_usec;  // timeline time (first record = 0)
+    traceType_t type;
+    uint32_t value;
+};
+
+static bool readTrace(const char* path, std::vector<uint8_t>& bytes) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::vector<uint8_t> raw;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        raw.insert(raw.end(), chunk, chunk + n);
+    }
+    fclose(file);
+
+    uint32_t magic = 0;
+    if (raw.size() >= sizeof(magic)) {
+        memcpy(&magic, raw.data(), sizeof(magic));
+    }
+    if (magic == TRACE_MAGIC) {
+        bytes = raw;  // binary snapshot
+        return true;
+    }
+
+    // serial log: "TRACE BEGIN <length>", "TRACE <offset> <hex>", "TRACE END" (last dump wins)
+    std::string text(raw.begin(), raw.end());
+    size_t pos = 0;
+    while ((pos = text.find("TRACE ", pos)) != std::string::npos) {
+        pos += 6;
+        size_t end = text.find('\n', pos);
+        std::string line = text.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        if (line.compare(0, 6, "BEGIN ") == 0) {
+            bytes.assign(strtoul(line.c_str() + 6, nullptr, 10), 0);
+        } else if (line.compare(0, 3, "END") != 0) {
+            char* hex;
+            unsigned long offset = strtoul(line.c_str(), &hex, 16);
+            while (*hex == ' ') {
+                hex++;
+            }
+            for (; isxdigit((unsigned char)hex[0]) && isxdigit((unsigned char)hex[1]) && (offset < bytes.size()); hex += 2) {
+                char pair[3] = {hex[0], hex[1], 0};
+                bytes[offset++] = (uint8_t)strtoul(pair, nullptr, 16);
+            }
+        }
+    }
+    return !bytes.empty();
+}
+
+// all records of both rings on one timeline: microseconds since the first record, or
+//   (rebase false) relative to the snapshot time; snapshotAt_usec = when the snapshot was taken, on that timeline
+static bool decodeTrace(const std::vector<uint8_t>& bytes, traceHeader_t& header, std::vector<event_t>& events,
+                        bool rebase = true, int64_t* snapshotAt_usec = nullptr) {
+    if (bytes.size() < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, bytes.data(), sizeof(header));
+    if ((header.magic != TRACE_MAGIC) || (header.version != TRACE_VERSION) || (header.blockBytes != TRACE_BLOCK_BYTES) ||
+        (bytes.size() < sizeof(header) + (size_t)header.rings * header.blocks * header.blockBytes)) {
+        return false;
+    }
+
+    for (int r = 0; r < header.rings; r++) {
+        std::vector<traceRecord_t> records;
+        for (int b = 0; b < header.blocks; b++) {  // snapshot stores each ring oldest block first
+            traceBlock_t block;
+            memcpy(&block, bytes.data() + sizeof(header) + ((size_t)r * header.blocks + b) * header.blockBytes, sizeof(block));
+            traceRecord_t record;
+            int offset = 0;
+            while (traceDecode(block, offset, record)) {
+                records.push_back(record);
+            }
+        }
+        // unwrap backwards from the snapshot time: newest record is the most recent
+        int64_t time_usec = 0;
+        uint32_t later_usec = header.snapshot_usec;
+        for (int i = (int)records.size() - 1; i >= 0; i--) {
+            time_usec -= (int64_t)(int32_t)(later_usec - records[i].time_usec);
+            later_usec = records[i].time_usec;
+            events.push_back({time_usec, records[i].type, records[i].value});
+        }
+    }
+    std::stable_sort(events.begin(), events.end(), [](const event_t& a, const event_t& b) { return a.time_usec < b.time_usec; });
+    int64_t first_usec = (rebase && !events.empty()) ? events.front().time_usec : 0;
+    for (event_t& e : events) {
+        e.time_usec -= first_usec;
+    }
+    if (snapshotAt_usec != nullptr) {
+        *snapshotAt_usec = -first_usec;
+    }
+    return true;
+}
+
+static void printTimeline(const std::vector<event_t>& events) {
+    for (const event_t& e : events) {
+        printf("%12.6f  %-8s ", e.time_usec / 1e6, typeName[e.type]);
+        switch (e.type) {
+            case TRACE_PEDALS:
+                printf("0x%02x\n", e.value);
+                break;
+            case TRACE_GESTURE:
+                printf("type %u pedal %u chord %u\n", e.value & 0x0f, (e.value >> 4) & 0x0f, e.value >> 8);
+                break;
+            case TRACE_BATTERY:
+                printf("%u mV\n", e.value);
+                break;
+            default:
+                printf("%u\n", e.value);
+                break;
+        }
+    }
+}
+
+/*****************************************************************************
+Description : Replays the pedal records through a PedalBank set up from the
+                trace header, ticking every INPUT_TICK_USEC while a gesture
+                timer runs (as the input task does)
+
+Input Value : header, events
+Return Value: replayed gestures as TRACE_GESTURE events, at classification time
+********************************************************************************/
+static std::vector<event_t> replayGestures(const traceHeader_t& header, const std::vector<event_t>& events) {
+    PedalBank bank(header.debounce_usec, header.doubleTap_usec, header.hold_usec, header.chordWindow_usec);
+    for (int p = 0; p < header.pedalCount; p++) {
+        bank.addPedal(p);  // pedal p on "pin" p: levels rebuilt from the pedal mask
+    }
+    for (int c = 0; c < header.chordCount; c++) {
+        bank.addChord(header.chordMask[c]);
+    }
+    bank.setLowLatency(header.lowLatency);
+
+    std::vector<event_t> gestures;
+    uint64_t levels = ~0ULL;
+    int64_t now_usec = 0;
+    auto collect = [&]() {
+        pedalGesture_t g;
+        while (bank.takeGesture(g)) {
+            gestures.push_back({now_usec, TRACE_GESTURE, (uint32_t)(g.type | (g.pedal << 4) | (g.chord << 8))});
+        }
+    };
+    auto tickUntil = [&](int64_t until_usec) {
+        while (!bank.isIdle() && (now_usec + INPUT_TICK_USEC < until_usec)) {
+            now_usec += INPUT_TICK_USEC;
+            bank.onTick((uint32_t)now_usec, levels);
+            collect();
+        }
+        now_usec = until_usec;
+    };
+
+    for (const event_t& e : events) {
+        if (e.type != TRACE_PEDALS) {
+            continue;
+        }
+        tickUntil(e.time_usec);
+        levels = ~(uint64_t)e.value;
+        pedalScan_t scan = {(uint32_t)now_usec, levels};
+        bank.onScan(scan);
+        collect();
+    }
+    tickUntil(now_usec + 2 * (int64_t)(header.hold_usec + header.doubleTap_usec));  // let timers run out
+    return gestures;
+}
+
+/*****************************************************************************
+Description : Replays battery voltage, BLE link and long presses through the
+                firmware's flipState machine (native HAL, virtual clock), one
+                processState() per background period, up to the moment the trace
+                was taken
+
+Input Value : events, gestures - replayed gestures
+              end_usec - snapshot time on the events' timeline
+Return Value: state transitions as TRACE_STATE events
+********************************************************************************/
+static std::vector<event_t> replayStates(const std::vector<event_t>& events, const std::vector<event_t>& gestures,
+                                        int64_t end_usec) {
+    std::vector<event_t> inputs;
+    bool linkSeen = false, batterySeen = false;
+    simReset();
+    rgbLed.begin();
+    for (const event_t& e : events) {
+        if ((e.type == TRACE_LINK) && !linkSeen) {
+            simSetConnected(!e.value);  // recorded on change: before the first record it was the opposite
+            linkSeen = true;
+        }
+        if ((e.type == TRACE_BATTERY) && !batterySeen) {
+            batteryMonitor.resume(0, e.value);  // seed: the state machine needs a voltage from the start
+            batterySeen = true;
+        }
+        if ((e.type == TRACE_LINK) || (e.type == TRACE_BATTERY)) {
+            inputs.push_back(e);
+        }
+    }
+    for (const event_t& g : gestures) {
+        if ((g.value & 0x0f) == LONG_PRESS) {
+            inputs.push_back(g);
+        }
+    }
+    std::stable_sort(inputs.begin(), inputs.end(), [](const event_t& a, const event_t& b) { return a.time_usec < b.time_usec; });
+    if (!batterySeen) {
+        printf("warning: no battery records; state replay assumes 4000 mV\n");
+        batteryMonitor.resume(0, 4000);
+    }
+
+    size_t next = 0;
+    for (int64_t now_usec = 0; now_usec <= end_usec; now_usec += BACKGROUND_STEP_USEC) {
+        simAdvanceUsec((uint32_t)(now_usec - halMicros()));
+        for (; (next < inputs.size()) && (inputs[next].time_usec <= now_usec); next++) {
+            const event_t& e = inputs[next];
+            if (e.type == TRACE_LINK) {
+                simSetConnected(e.value);
+            } else if (e.type == TRACE_BATTERY) {
+                batteryMonitor.resume(halMillis(), e.value);
+            } else {
+                requestState(battery_status);  // as the background task does for a long press
+            }
+        }
+        processState();
+    }
+
+    // flipState recorded its transitions into this process's traceRecorder; virtual time = timeline time
+    static uint8_t snapshot[TRACE_SNAPSHOT_BYTES];
+    traceHeader_t header = {};
+    header.snapshot_usec = halMicros();
+    std::vector<uint8_t> bytes(snapshot, snapshot + traceRecorder.snapshot(header, snapshot, sizeof(snapshot)));
+    std::vector<event_t> states;
+    decodeTrace(bytes, header, states, false);
+    for (event_t& e : states) {
+        e.time_usec += header.snapshot_usec;
+    }
+    return states;
+}
+
+// pairs recorded and replayed events of one type in order; returns the number of differences
+static int match(const char* what, const std::vector<event_t>& recorded, const std::vector<event_t>& replayed,
+                 traceType_t type, int64_t from_usec, int64_t tolerance_usec) {
+    std::vector<event_t> a, b;
+    for (const event_t& e : recorded) {
+        if ((e.type == type) && (e.time_usec >= from_usec)) {
+            a.push_back(e);
+        }
+    }
+    for (const event_t& e : replayed) {
+        if ((e.type == type) && (e.time_usec >= from_usec)) {
+            b.push_back(e);
+        }
+    }
+    int differences = 0;
+    int64_t worst_usec = 0;
+    size_t i = 0, j = 0;
+    while ((i < a.size()) || (j < b.size())) {
+        bool bothLeft = (i < a.size()) && (j < b.size());
+        int64_t skew = bothLeft ? b[j].time_usec - a[i].time_usec : 0;
+        if (bothLeft && (a[i].value == b[j].value) && (llabs(skew) <= tolerance_usec)) {
+            worst_usec = std::max(worst_usec, (int64_t)llabs(skew));
+            i++;
+            j++;
+            continue;
+        }
+        differences++;
+        if ((j >= b.size()) || ((i < a.size()) && (a[i].time_usec <= b[j].time_usec))) {
+            printf("  %s: recorded %u at %.6f s not replayed\n", what, a[i].value, a[i].time_usec / 1e6);
+            i++;
+        } else {
+            printf("  %s: replay gave %u at %.6f s, not recorded\n", what, b[j].value, b[j].time_usec / 1e6);
+            j++;
+        }
+    }
+    printf("%s: %zu recorded, %zu replayed, %d differences, worst skew %.1f ms\n", what, a.size(), b.size(),
+           differences, worst_usec / 1000.0);
+    return differences;
+}
+
+int main(int argc, char** argv) {
+    bool verbose = false;
+    int benchmark = 0;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+        } else if ((strcmp(argv[i], "-b") == 0) && (i + 1 < argc)) {
+            benchmark = atoi(argv[++i]);
+        } else {
+            path = argv[i];
+        }
+    }
+    if (path == nullptr) {
+        fprintf(stderr, "usage: traceReplay [-v] [-b repeats] <serial log | trace.bin>\n");
+        return 2;
+    }
+
+    std::vector<uint8_t> bytes;
+    traceHeader_t header;
+    std::vector<event_t> events;
+    int64_t snapshot_usec;
+    if (!readTrace(path, bytes) || !decodeTrace(bytes, header, events, true, &snapshot_usec)) {
+        fprintf(stderr, "%s: no readable flipTurn trace\n", path);
+        return 2;
+    }
+    int count[TRACE_TYPE_COUNT] = {};
+    for (const event_t& e : events) {
+        count[e.type]++;
+    }
+    printf("trace: %zu records over %.3f s (pedals %d, gestures %d, hid %d, link %d, battery %d, states %d)\n",
+           events.size(), events.empty() ? 0.0 : events.back().time_usec / 1e6, count[TRACE_PEDALS],
+           count[TRACE_GESTURE], count[TRACE_HID], count[TRACE_LINK], count[TRACE_BATTERY], count[TRACE_STATE]);
+    printf("config: %d pedal(s), %d chord(s), debounce %u us, double tap %u us, hold %u us, low latency %d\n",
+           header.pedalCount, header.chordCount, header.debounce_usec, header.doubleTap_usec, header.hold_usec,
+           header.lowLatency);
+    if (verbose) {
+        printTimeline(events);
+    }
+
+    // gestures are only comparable once the pedal history starts
+    int64_t firstPedal_usec = 0;
+    for (const event_t& e : events) {
+        if (e.type == TRACE_PEDALS) {
+            firstPedal_usec = e.time_usec;
+            break;
+        }
+    }
+    std::vector<event_t> gestures = replayGestures(header, events);
+    int differences = match("gestures", events, gestures, TRACE_GESTURE, firstPedal_usec, GESTURE_TOLERANCE_USEC);
+
+    std::vector<event_t> states = replayStates(events, gestures, snapshot_usec);
+    differences += match("states", events, states, TRACE_STATE, STATE_SETTLE_USEC, STATE_TOLERANCE_USEC);
+
+    if ((benchmark > 0) && (count[TRACE_PEDALS] > 0)) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < benchmark; i++) {
+            replayGestures(header, events);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        printf("gesture replay: %.1f ns per pedal record (%d repeats)\n", ns / benchmark / count[TRACE_PEDALS], benchmark);
+    }
+    return differences ? 1 : 0;
+}